@@ -0,0 +1,239 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Host Benchmark - parser, matcher and payload builder
+ *
+ * Replays advertisement captures (STREAM RAW output) or synthetic traffic
+ * through the same parser and matcher the firmware runs, and reports
+ * ns/packet, heap allocations per packet and per-signature match counts.
+ * The final digest line only changes when match results change, so CI can
+ * diff it across matcher and signature table changes.
+ *
+ *   pio run -e native -t exec
+ *   .pio/build/native/program [capture.bin ...] [--sigs N] [--packets N]
+ *                             [--iterations K] [--seed S]
+ */
+
+#include "capture.h"
+#include "../src/detection/adv_parser.h"
+#include "../src/detection/matcher.h"
+#include "../src/packet/adv_builder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <new>
+#include <vector>
+
+// =============================================================================
+// ALLOCATION COUNTING
+// =============================================================================
+// The firmware hot path must not touch the heap; every operator new made
+// while a measured section runs is counted against it
+static size_t g_allocCount = 0;
+
+void* operator new(size_t size) {
+    g_allocCount++;
+    void* p = malloc(size != 0 ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+// =============================================================================
+// SIGNATURE TABLE
+// =============================================================================
+// Builtins first, then synthetic company ID + payload signatures so the
+// effect of table growth can be measured
+static device_signature_t g_extraSigs[SIG_INDEX_MAX_SIGS];
+static const device_signature_t* g_sigs[SIG_INDEX_MAX_SIGS];
+static sig_index_t g_index;
+
+static size_t buildTable(size_t wanted) {
+    size_t count = 0;
+    for (size_t i = 0; i < BUILTIN_SIGNATURE_COUNT && count < SIG_INDEX_MAX_SIGS; i++) {
+        g_sigs[count++] = &BUILTIN_SIGNATURES[i];
+    }
+    for (size_t n = 0; count < wanted && count < SIG_INDEX_MAX_SIGS; n++) {
+        device_signature_t* sig = &g_extraSigs[n];
+        memset(sig, 0, sizeof(*sig));
+        snprintf(sig->name, sizeof(sig->name), "Synthetic %u", (unsigned)n);
+        sig->category = 0;
+        sig->company_id = (uint16_t)(0xE000 + n);    // Unassigned range
+        sig->payload_pattern[0] = sig->company_id & 0xFF;
+        sig->payload_pattern[1] = sig->company_id >> 8;
+        sig->payload_pattern[2] = (uint8_t)n;
+        sig->pattern_length = 3;
+        sig->pattern_offset = -1;
+        sig->threat_level = 1;
+        sig->flags = SIG_FLAG_COMPANY_ID | SIG_FLAG_PAYLOAD | SIG_FLAG_EXACT_MATCH |
+                     SIG_FLAG_TRANSMITTABLE;
+        g_sigs[count++] = sig;
+    }
+
+    g_index = sigIndexBuild([](size_t i) -> const device_signature_t& { return *g_sigs[i]; },
+                            count);
+    return count;
+}
+
+// =============================================================================
+// MEASUREMENT
+// =============================================================================
+typedef std::chrono::steady_clock bench_clock_t;
+
+static double elapsedNs(bench_clock_t::time_point start) {
+    return std::chrono::duration<double, std::nano>(bench_clock_t::now() - start).count();
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [capture.bin ...] [--sigs N] [--packets N] [--iterations K] [--seed S]\n"
+            "  Without captures, --packets synthetic advertisements are generated.\n",
+            argv0);
+}
+
+int main(int argc, char** argv) {
+    std::vector<const char*> captures;
+    size_t wantedSigs = 0;
+    size_t packetCount = 10000;
+    unsigned iterations = 20;
+    uint32_t seed = 0x5EED1234;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--sigs") == 0 && hasValue) {
+            wantedSigs = strtoul(argv[++i], nullptr, 0);
+        } else if (strcmp(arg, "--packets") == 0 && hasValue) {
+            packetCount = strtoul(argv[++i], nullptr, 0);
+        } else if (strcmp(arg, "--iterations") == 0 && hasValue) {
+            iterations = (unsigned)strtoul(argv[++i], nullptr, 0);
+        } else if (strcmp(arg, "--seed") == 0 && hasValue) {
+            seed = (uint32_t)strtoul(argv[++i], nullptr, 0);
+        } else if (arg[0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            captures.push_back(arg);
+        }
+    }
+    if (iterations == 0) {
+        iterations = 1;
+    }
+
+    size_t sigCount = buildTable(wantedSigs);
+    sig_table_t table = { g_sigs, (uint16_t)sigCount, &g_index };
+    printf("signatures: %u (%u builtin)\n", (unsigned)sigCount, (unsigned)BUILTIN_SIGNATURE_COUNT);
+
+    // Workload
+    std::vector<bench_packet_t> packets;
+    for (const char* path : captures) {
+        int n = captureLoad(path, &packets);
+        if (n < 0) {
+            fprintf(stderr, "cannot open %s\n", path);
+            return 1;
+        }
+        printf("capture: %s, %d packets\n", path, n);
+    }
+    if (captures.empty()) {
+        captureSynthesize(g_sigs, sigCount, packetCount, seed, &packets);
+        printf("synthetic: %u packets, seed 0x%08X\n", (unsigned)packets.size(), (unsigned)seed);
+    }
+    if (packets.empty()) {
+        fprintf(stderr, "no packets\n");
+        return 1;
+    }
+
+    std::vector<adv_view_t> views(packets.size());
+    std::vector<uint32_t> matchCounts(sigCount + 1, 0);   // Last slot: no match
+    const size_t total = packets.size() * iterations;
+
+    // Parser alone
+    size_t allocsBefore = g_allocCount;
+    auto start = bench_clock_t::now();
+    for (unsigned it = 0; it < iterations; it++) {
+        for (size_t p = 0; p < packets.size(); p++) {
+            advParse(packets[p].data, packets[p].len, &views[p]);
+        }
+    }
+    double parseNs = elapsedNs(start);
+    size_t parseAllocs = g_allocCount - allocsBefore;
+
+    // Matcher alone, on the views parsed above
+    const device_signature_t* volatile sink = nullptr;
+    allocsBefore = g_allocCount;
+    start = bench_clock_t::now();
+    for (unsigned it = 0; it < iterations; it++) {
+        for (size_t p = 0; p < packets.size(); p++) {
+            sink = matchSignatureIn(&table, packets[p].data, packets[p].len, &views[p]);
+        }
+    }
+    double matchNs = elapsedNs(start);
+    size_t matchAllocs = g_allocCount - allocsBefore;
+    (void)sink;
+
+    // Payload builder (TX path), one template build + randomize per packet
+    tx_payload_t payload;
+    uint32_t rng = seed != 0 ? seed : 1;
+    size_t built = 0;
+    allocsBefore = g_allocCount;
+    start = bench_clock_t::now();
+    for (unsigned it = 0; it < iterations; it++) {
+        for (size_t s = 0; s < sigCount; s++) {
+            if (advBuildPayload(g_sigs[s], &payload)) {
+                advRandomizePayload(&payload, &rng);
+                built++;
+            }
+        }
+    }
+    double buildNs = elapsedNs(start);
+    size_t buildAllocs = g_allocCount - allocsBefore;
+
+    // Match results (one pass, outside the timed sections)
+    uint32_t digest = 2166136261u;      // FNV-1a over the matched indices
+    for (size_t p = 0; p < packets.size(); p++) {
+        adv_view_t view;
+        advParse(packets[p].data, packets[p].len, &view);
+        const device_signature_t* sig = matchSignatureIn(&table, packets[p].data, packets[p].len, &view);
+        size_t slot = sigCount;
+        for (size_t s = 0; sig != nullptr && s < sigCount; s++) {
+            if (g_sigs[s] == sig) {
+                slot = s;
+                break;
+            }
+        }
+        matchCounts[slot]++;
+        for (int b = 0; b < 2; b++) {
+            digest = (digest ^ ((slot >> (8 * b)) & 0xFF)) * 16777619u;
+        }
+    }
+
+    printf("\n%-10s %12s %14s\n", "stage", "ns/packet", "allocs/packet");
+    printf("%-10s %12.1f %14.3f\n", "parse", parseNs / total, (double)parseAllocs / total);
+    printf("%-10s %12.1f %14.3f\n", "match", matchNs / total, (double)matchAllocs / total);
+    printf("%-10s %12.1f %14.3f\n", "total", (parseNs + matchNs) / total,
+           (double)(parseAllocs + matchAllocs) / total);
+    if (built > 0) {
+        printf("%-10s %12.1f %14.3f   (ns/payload)\n", "build", buildNs / built,
+               (double)buildAllocs / built);
+    }
+
+    printf("\nmatches:\n");
+    for (size_t s = 0; s < sigCount; s++) {
+        if (matchCounts[s] > 0) {
+            printf("  %6u  %s\n", (unsigned)matchCounts[s], g_sigs[s]->name);
+        }
+    }
+    printf("  %6u  (no match)\n", (unsigned)matchCounts[sigCount]);
+    printf("\ndigest: %08X over %u packets\n", (unsigned)digest, (unsigned)packets.size());
+
+    return 0;
+}
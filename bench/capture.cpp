@@ -0,0 +1,178 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Benchmark Workloads Implementation
+ */
+
+#include "capture.h"
+#include "../src/serial/bin_records.h"
+#include "../src/packet/adv_builder.h"
+#include <stdio.h>
+#include <string.h>
+
+// =============================================================================
+// CAPTURE FILES
+// =============================================================================
+// Same CRC as the firmware (CRC-16/CCITT-FALSE)
+static uint16_t crc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+// Returns the decoded length, or 0 if the input is not valid COBS
+static size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out, size_t outMax) {
+    size_t n = 0;
+    size_t i = 0;
+    while (i < len) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > len) {
+            return 0;
+        }
+        for (uint8_t k = 1; k < code; k++) {
+            if (n >= outMax) {
+                return 0;
+            }
+            out[n++] = in[i++];
+        }
+        if (code < 0xFF && i < len) {
+            if (n >= outMax) {
+                return 0;
+            }
+            out[n++] = 0;
+        }
+    }
+    return n;
+}
+
+static bool decodeRawAdv(const uint8_t* frame, size_t len, bench_packet_t* pkt) {
+    uint8_t raw[BIN_FRAME_MAX];
+    size_t n = cobsDecode(frame, len, raw, sizeof(raw));
+    if (n < 4) {
+        return false;
+    }
+    uint16_t crc = raw[n - 2] | (raw[n - 1] << 8);
+    if (crc16(raw, n - 2) != crc || raw[0] != BIN_FRAME_RAW_ADV) {
+        return false;
+    }
+
+    const uint8_t* body = raw + 2;
+    size_t bodyLen = n - 4;
+    if (bodyLen < offsetof(bin_raw_adv_t, payload)) {
+        return false;
+    }
+    bin_raw_adv_t rec;
+    memset(&rec, 0, sizeof(rec));
+    memcpy(&rec, body, bodyLen < sizeof(rec) ? bodyLen : sizeof(rec));
+    if (rec.payloadLen > sizeof(pkt->data) ||
+        offsetof(bin_raw_adv_t, payload) + rec.payloadLen > bodyLen) {
+        return false;
+    }
+    pkt->len = rec.payloadLen;
+    memcpy(pkt->data, rec.payload, rec.payloadLen);
+    return true;
+}
+
+int captureLoad(const char* path, std::vector<bench_packet_t>* out) {
+    FILE* f = fopen(path, "rb");
+    if (f == nullptr) {
+        return -1;
+    }
+
+    int count = 0;
+    uint8_t frame[BIN_FRAME_MAX];
+    size_t frameLen = 0;
+    bool overflow = false;
+    int c;
+    while ((c = fgetc(f)) != EOF) {
+        if (c != 0) {
+            if (frameLen < sizeof(frame)) {
+                frame[frameLen++] = (uint8_t)c;
+            } else {
+                overflow = true;    // Text or garbage; skip to the next delimiter
+            }
+            continue;
+        }
+        bench_packet_t pkt;
+        if (frameLen > 0 && !overflow && decodeRawAdv(frame, frameLen, &pkt)) {
+            out->push_back(pkt);
+            count++;
+        }
+        frameLen = 0;
+        overflow = false;
+    }
+    fclose(f);
+    return count;
+}
+
+// =============================================================================
+// SYNTHETIC TRAFFIC
+// =============================================================================
+// Background devices that match nothing: phones, beacons, named gadgets
+static size_t buildNoise(uint32_t* rng, uint8_t* out) {
+    size_t pos = 0;
+    out[pos++] = 0x02;
+    out[pos++] = 0x01;
+    out[pos++] = 0x1A;
+
+    switch (advXorshift32(rng) % 3) {
+        case 0: {
+            // Manufacturer data from an unlisted company
+            uint8_t len = 4 + advXorshift32(rng) % 20;
+            out[pos++] = len + 1;
+            out[pos++] = 0xFF;
+            out[pos++] = 0xF0;
+            out[pos++] = 0xFF;
+            for (uint8_t i = 2; i < len; i++) {
+                out[pos++] = (uint8_t)advXorshift32(rng);
+            }
+            break;
+        }
+        case 1: {
+            // Unrelated 16-bit service UUIDs
+            out[pos++] = 0x05;
+            out[pos++] = 0x03;
+            out[pos++] = 0x0D;      // Heart rate (0x180D)
+            out[pos++] = 0x18;
+            out[pos++] = 0x0F;      // Battery (0x180F)
+            out[pos++] = 0x18;
+            break;
+        }
+        default: {
+            static const char* const names[] = { "LE-Bose QC", "Mi Band", "JBL Flip", "Govee_H6" };
+            const char* name = names[advXorshift32(rng) % 4];
+            size_t len = strlen(name);
+            out[pos++] = (uint8_t)(len + 1);
+            out[pos++] = 0x09;
+            memcpy(&out[pos], name, len);
+            pos += len;
+            break;
+        }
+    }
+    return pos;
+}
+
+void captureSynthesize(const device_signature_t* const* sigs, size_t sigCount,
+                       size_t count, uint32_t seed, std::vector<bench_packet_t>* out) {
+    uint32_t rng = seed != 0 ? seed : 1;
+    for (size_t n = 0; n < count; n++) {
+        bench_packet_t pkt;
+        memset(&pkt, 0, sizeof(pkt));
+
+        // Roughly one in four reports comes from a listed device
+        tx_payload_t payload;
+        if (sigCount > 0 && advXorshift32(&rng) % 4 == 0 &&
+            advBuildPayload(sigs[advXorshift32(&rng) % sigCount], &payload)) {
+            advRandomizePayload(&payload, &rng);
+            pkt.len = payload.len;
+            memcpy(pkt.data, payload.data, payload.len);
+        } else {
+            pkt.len = (uint8_t)buildNoise(&rng, pkt.data);
+        }
+        out->push_back(pkt);
+    }
+}
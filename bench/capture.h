@@ -0,0 +1,30 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Benchmark Workloads - recorded captures and synthetic traffic
+ */
+
+#ifndef BENCH_CAPTURE_H
+#define BENCH_CAPTURE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "../src/config.h"
+#include "../src/detection/signatures.h"
+
+typedef struct {
+    uint8_t len;
+    uint8_t data[ADV_RECORD_PAYLOAD_MAX];
+} bench_packet_t;
+
+// Append every raw advertisement frame of a STREAM RAW capture (the bytes
+// read from the serial port). Returns the number of packets read, or -1 if
+// the file can't be opened. Text and corrupt frames are skipped.
+int captureLoad(const char* path, std::vector<bench_packet_t>* out);
+
+// Append count packets: payloads built from the given signatures mixed
+// with unrelated advertisements, in a fixed pseudo-random order
+void captureSynthesize(const device_signature_t* const* sigs, size_t sigCount,
+                       size_t count, uint32_t seed, std::vector<bench_packet_t>* out);
+
+#endif // BENCH_CAPTURE_H
@@ -0,0 +1,30 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * BLE HAL Implementation
+ */
+
+#include "ble_hal.h"
+#include <BLEDevice.h>
+
+static ble_gap_listener_t gapListeners[BLE_HAL_MAX_LISTENERS];
+static volatile uint8_t gapListenerCount = 0;
+
+// Runs in the Bluedroid host task for every GAP event
+static void gapDispatch(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param) {
+    for (uint8_t i = 0; i < gapListenerCount; i++) {
+        gapListeners[i](event, param);
+    }
+}
+
+void bleHalInit() {
+    BLEDevice::setCustomGapHandler(gapDispatch);
+}
+
+bool bleHalAddGapListener(ble_gap_listener_t listener) {
+    if (gapListenerCount >= BLE_HAL_MAX_LISTENERS) {
+        return false;
+    }
+    gapListeners[gapListenerCount] = listener;
+    gapListenerCount = gapListenerCount + 1;  // Publish after the slot is written
+    return true;
+}
@@ -0,0 +1,39 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * BLE HAL - GAP event fan-out
+ *
+ * The Arduino BLE library owns the Bluedroid GAP callback and accepts a single
+ * custom handler. This module installs that handler once and forwards every
+ * GAP event to the modules that registered a listener (scanner, TX).
+ *
+ * It also picks the GAP API. A BLE 5.0 controller (ESP32-S3) refuses legacy
+ * advertising and scan commands once an extended one has been issued, so
+ * scanner and TX either both use the legacy API or both the extended one.
+ */
+
+#ifndef BLE_HAL_H
+#define BLE_HAL_H
+
+#include <Arduino.h>
+#include <esp_gap_ble_api.h>
+#include "../config.h"
+
+#define BLE_HAL_MAX_LISTENERS   4
+
+// Extended GAP API, available when Bluedroid is built with the BLE 5.0
+// feature set (the sdkconfig of the S3 Arduino core)
+#if defined(CONFIG_BT_BLE_50_FEATURES_SUPPORTED) && CONFIG_BT_BLE_50_FEATURES_SUPPORTED
+#define BLE_HAL_EXT_API         1
+#else
+#define BLE_HAL_EXT_API         0
+#endif
+
+typedef void (*ble_gap_listener_t)(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param);
+
+// Install the custom GAP handler (call after BLEDevice::init)
+void bleHalInit();
+
+// Register a listener; returns false if the listener table is full
+bool bleHalAddGapListener(ble_gap_listener_t listener);
+
+#endif // BLE_HAL_H
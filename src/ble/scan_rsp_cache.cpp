@@ -0,0 +1,96 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Scan Response Cache Implementation
+ */
+
+#include "scan_rsp_cache.h"
+
+// Global instance
+ScanRspCache scanRspCache;
+
+// =============================================================================
+// CONSTRUCTOR
+// =============================================================================
+ScanRspCache::ScanRspCache() {
+    memset(_entries, 0, sizeof(_entries));
+    _merged = 0;
+}
+
+// =============================================================================
+// LOOKUP
+// =============================================================================
+// Responses stay valid for SCAN_RSP_CACHE_TTL_MS; a request that got no
+// answer may be retried after SCAN_RSP_RETRY_MS
+bool ScanRspCache::expired(const scan_rsp_entry_t* e, uint32_t now) {
+    switch (e->state) {
+        case SCAN_RSP_VALID:     return now - e->stamp >= SCAN_RSP_CACHE_TTL_MS;
+        case SCAN_RSP_REQUESTED: return now - e->stamp >= SCAN_RSP_RETRY_MS;
+        default:                 return true;
+    }
+}
+
+const scan_rsp_entry_t* ScanRspCache::find(const uint8_t* mac, uint32_t now) {
+    for (int i = 0; i < SCAN_RSP_CACHE_SIZE; i++) {
+        scan_rsp_entry_t* e = &_entries[i];
+        if (e->state != SCAN_RSP_EMPTY && memcmp(e->mac, mac, 6) == 0) {
+            return expired(e, now) ? nullptr : e;
+        }
+    }
+    return nullptr;
+}
+
+// The entry for mac if present, else a free or expired one, else the oldest
+scan_rsp_entry_t* ScanRspCache::slotFor(const uint8_t* mac, uint32_t now) {
+    scan_rsp_entry_t* victim = &_entries[0];
+    bool victimFree = expired(victim, now);
+    for (int i = 0; i < SCAN_RSP_CACHE_SIZE; i++) {
+        scan_rsp_entry_t* e = &_entries[i];
+        if (e->state != SCAN_RSP_EMPTY && memcmp(e->mac, mac, 6) == 0) {
+            return e;
+        }
+        if (victimFree) {
+            continue;
+        }
+        if (expired(e, now)) {
+            victim = e;
+            victimFree = true;
+        } else if (now - e->stamp > now - victim->stamp) {
+            victim = e;
+        }
+    }
+    return victim;
+}
+
+// =============================================================================
+// UPDATES
+// =============================================================================
+void ScanRspCache::store(const uint8_t* mac, const uint8_t* data, uint8_t len, uint32_t now) {
+    if (len > SCAN_RSP_MAX_LEN) {
+        len = SCAN_RSP_MAX_LEN;
+    }
+    scan_rsp_entry_t* e = slotFor(mac, now);
+    memcpy(e->mac, mac, 6);
+    e->state = SCAN_RSP_VALID;
+    e->len = len;
+    e->stamp = now;
+    memcpy(e->data, data, len);
+}
+
+void ScanRspCache::markRequested(const uint8_t* mac, uint32_t now) {
+    scan_rsp_entry_t* e = slotFor(mac, now);
+    memcpy(e->mac, mac, 6);
+    e->state = SCAN_RSP_REQUESTED;
+    e->len = 0;
+    e->stamp = now;
+}
+
+int ScanRspCache::count() {
+    int n = 0;
+    uint32_t now = millis();
+    for (int i = 0; i < SCAN_RSP_CACHE_SIZE; i++) {
+        if (_entries[i].state == SCAN_RSP_VALID && !expired(&_entries[i], now)) {
+            n++;
+        }
+    }
+    return n;
+}
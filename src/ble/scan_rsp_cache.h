@@ -0,0 +1,63 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Scan Response Cache
+ *
+ * Keeps the last scan response of recently seen advertisers by MAC. With
+ * hybrid scanning the scan is passive most of the time; a cached response
+ * is merged into later reports from the same device, so its name stays
+ * matchable without asking for the response again. Entries can also mark
+ * a device whose response was requested but hasn't arrived yet.
+ */
+
+#ifndef SCAN_RSP_CACHE_H
+#define SCAN_RSP_CACHE_H
+
+#include <Arduino.h>
+#include "../config.h"
+
+#define SCAN_RSP_MAX_LEN    31
+
+typedef enum {
+    SCAN_RSP_EMPTY = 0,
+    SCAN_RSP_REQUESTED,                 // Waiting for an active scan burst
+    SCAN_RSP_VALID
+} scan_rsp_state_t;
+
+typedef struct {
+    uint8_t mac[6];
+    uint8_t state;                      // scan_rsp_state_t
+    uint8_t len;
+    uint32_t stamp;                     // millis() stored or requested
+    uint8_t data[SCAN_RSP_MAX_LEN];
+} scan_rsp_entry_t;
+
+class ScanRspCache {
+public:
+    ScanRspCache();
+
+    // Store a received scan response (longer ones are truncated)
+    void store(const uint8_t* mac, const uint8_t* data, uint8_t len, uint32_t now);
+
+    // Remember that a response was asked for, so it isn't asked again
+    void markRequested(const uint8_t* mac, uint32_t now);
+
+    // Unexpired entry for mac (valid or requested), or nullptr
+    const scan_rsp_entry_t* find(const uint8_t* mac, uint32_t now);
+
+    // Statistics
+    int count();
+    uint32_t getMergedCount() { return _merged; }
+    void countMerged() { _merged++; }
+
+private:
+    scan_rsp_entry_t _entries[SCAN_RSP_CACHE_SIZE];
+    uint32_t _merged;
+
+    bool expired(const scan_rsp_entry_t* e, uint32_t now);
+    scan_rsp_entry_t* slotFor(const uint8_t* mac, uint32_t now);
+};
+
+// Global cache instance
+extern ScanRspCache scanRspCache;
+
+#endif // SCAN_RSP_CACHE_H
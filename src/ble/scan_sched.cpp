@@ -0,0 +1,145 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Scan Scheduler Implementation
+ */
+
+#include "scan_sched.h"
+#include "scanner.h"
+
+// Global instance
+ScanScheduler scanScheduler;
+
+// Weight of the newest measurement in the rate average
+#define SCAN_RATE_ALPHA     0.25f
+
+// =============================================================================
+// CONSTRUCTOR
+// =============================================================================
+ScanScheduler::ScanScheduler() {
+    _intervalMs = BLE_SCAN_INTERVAL_MS;
+    _windowMs = BLE_SCAN_WINDOW_MS;
+    _active = BLE_ACTIVE_SCAN;
+    _applied = false;
+    _quiet = false;
+    _advRate = 0.0f;
+    _reason = SCAN_REASON_NORMAL;
+    _dirty = false;
+    _lastUpdate = 0;
+    _lastReports = 0;
+    _burstStart = 0;
+    _burstUntil = 0;
+    _burstCount = 0;
+    _burstApplied = false;
+    _slotUntil = 0;
+    _slotCount = 0;
+    _slotApplied = false;
+    _uplinkListen = false;
+}
+
+// =============================================================================
+// SCHEDULING
+// =============================================================================
+void ScanScheduler::update(uint32_t now, bool txActive, bool powerSave) {
+    bool burst = isBurstActive(now);
+    bool slot = isUplinkSlot(now);
+    bool periodDue = (now - _lastUpdate >= BLE_SCHED_PERIOD_MS);
+    if (_applied && !periodDue && !_dirty && burst == _burstApplied && slot == _slotApplied) {
+        return;     // Bursts and slots start and end right away, the rest once a period
+    }
+    _dirty = false;
+
+    // Advertisement rate over the listening time of the last period
+    if (periodDue) {
+        uint32_t reports = bleScanner.getReportCount();
+        if (_applied && bleScanner.isRunning()) {
+            float listenSec = (now - _lastUpdate) * (float)_windowMs / _intervalMs / 1000.0f;
+            float rate = (reports - _lastReports) / listenSec;
+            _advRate += SCAN_RATE_ALPHA * (rate - _advRate);
+
+            // Hysteresis so a borderline environment doesn't flip every period
+            if (!_quiet && _advRate < BLE_SCHED_QUIET_RATE) {
+                _quiet = true;
+            } else if (_quiet && _advRate > BLE_SCHED_BUSY_RATE) {
+                _quiet = false;
+            }
+        }
+        _lastReports = reports;
+        _lastUpdate = now;
+    }
+
+    // Strongest restriction wins the duty cycle and names the reason
+    uint8_t duty = 100;
+    scan_reason_t reason = SCAN_REASON_NORMAL;
+    bool active = BLE_HYBRID_SCAN ? false : BLE_ACTIVE_SCAN;
+    if (_quiet) {
+        duty = BLE_SCHED_QUIET_DUTY_PCT;
+        reason = SCAN_REASON_QUIET;
+        active = false;
+    }
+    if (powerSave && BLE_SCHED_POWERSAVE_DUTY_PCT < duty) {
+        duty = BLE_SCHED_POWERSAVE_DUTY_PCT;
+        reason = SCAN_REASON_POWERSAVE;
+    }
+    if (txActive && BLE_SCHED_TX_DUTY_PCT < duty) {
+        duty = BLE_SCHED_TX_DUTY_PCT;
+        reason = SCAN_REASON_TX;
+    }
+    if ((slot || _uplinkListen) && BLE_SCHED_UPLINK_DUTY_PCT < duty) {
+        duty = BLE_SCHED_UPLINK_DUTY_PCT;
+        reason = SCAN_REASON_UPLINK;
+    }
+
+    if (BLE_HYBRID_SCAN && burst) {
+        active = true;
+    }
+    _burstApplied = burst;
+
+    uint16_t window = (uint16_t)(BLE_SCAN_INTERVAL_MS * duty / 100);
+    if (window > BLE_SCAN_WINDOW_MS) {
+        window = BLE_SCAN_WINDOW_MS;
+    } else if (window < BLE_SCAN_WINDOW_MIN_MS) {
+        window = BLE_SCAN_WINDOW_MIN_MS;
+    }
+    _reason = reason;
+
+    if (_applied && window == _windowMs && active == _active) {
+        _slotApplied = slot;
+        return;
+    }
+    _intervalMs = BLE_SCAN_INTERVAL_MS;
+    _windowMs = window;
+    _active = active;
+    _applied = true;
+    bleScanner.setParams(_intervalMs, _windowMs, _active);
+    _slotApplied = slot;
+}
+
+void ScanScheduler::requestUplinkSlot(uint32_t now) {
+    _slotUntil = now + UPLINK_SLOT_MS;
+    _slotCount++;
+    _dirty = true;
+}
+
+bool ScanScheduler::requestActiveBurst(uint32_t now) {
+    if (isBurstActive(now)) {
+        return true;    // Already collecting responses
+    }
+    if (_burstCount > 0 && now - _burstStart < BLE_HYBRID_BURST_GAP_MS) {
+        return false;
+    }
+    _burstStart = now;
+    _burstUntil = now + BLE_HYBRID_BURST_MS;
+    _burstCount++;
+    _dirty = true;
+    return true;
+}
+
+const char* ScanScheduler::getReasonString() {
+    switch (_reason) {
+        case SCAN_REASON_QUIET:     return "quiet";
+        case SCAN_REASON_POWERSAVE: return "powersave";
+        case SCAN_REASON_TX:        return "tx";
+        case SCAN_REASON_UPLINK:    return "uplink";
+        default:                    return "normal";
+    }
+}
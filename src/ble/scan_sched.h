@@ -0,0 +1,87 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Scan Scheduler - adaptive scan interval, window and type
+ *
+ * Chooses the scan parameters from what is going on: while transmitting the
+ * window leaves room for advertising events instead of the scan stopping;
+ * when few advertisers are around it listens less; while the screen sleeps
+ * the duty cycle is capped. With hybrid scanning the scan is passive except
+ * for short active bursts that collect scan responses. The Wi-Fi uplink gets
+ * its air time the same way: while it sends (node) or listens (collector)
+ * the window is narrowed, so the gaps between windows are free for it. The
+ * advertisement rate is measured per second of listening, so it doesn't
+ * depend on the duty.
+ */
+
+#ifndef SCAN_SCHED_H
+#define SCAN_SCHED_H
+
+#include <Arduino.h>
+#include "../config.h"
+
+typedef enum {
+    SCAN_REASON_NORMAL = 0,
+    SCAN_REASON_QUIET,
+    SCAN_REASON_POWERSAVE,
+    SCAN_REASON_TX,
+    SCAN_REASON_UPLINK
+} scan_reason_t;
+
+class ScanScheduler {
+public:
+    ScanScheduler();
+
+    // Call from the match task; re-evaluates every BLE_SCHED_PERIOD_MS and only
+    // touches the scanner when the parameters change
+    void update(uint32_t now, bool txActive, bool powerSave);
+
+    // Hybrid scanning: scan actively for BLE_HYBRID_BURST_MS to collect scan
+    // responses. Returns false if the last burst started too recently.
+    bool requestActiveBurst(uint32_t now);
+
+    // Uplink air time: a node asks for a slot of UPLINK_SLOT_MS before each
+    // batch and sends once it is ready; a collector listens all the time.
+    // Both narrow the window to BLE_SCHED_UPLINK_DUTY_PCT.
+    void requestUplinkSlot(uint32_t now);
+    bool isUplinkSlotReady(uint32_t now) { return _slotApplied && isUplinkSlot(now); }
+    void setUplinkListen(bool listen) { _uplinkListen = listen; _dirty = true; }
+
+    // Chosen parameters
+    uint16_t getIntervalMs() { return _intervalMs; }
+    uint16_t getWindowMs() { return _windowMs; }
+    uint8_t getDutyPct() { return (uint8_t)(_windowMs * 100 / _intervalMs); }
+    bool isActiveScan() { return _active; }
+    float getAdvRate() { return _advRate; }
+    scan_reason_t getReason() { return _reason; }
+    const char* getReasonString();
+    bool isBurstActive(uint32_t now) { return _burstCount > 0 && (int32_t)(_burstUntil - now) > 0; }
+    uint32_t getBurstCount() { return _burstCount; }
+    uint32_t getUplinkSlotCount() { return _slotCount; }
+
+private:
+    uint16_t _intervalMs;
+    uint16_t _windowMs;
+    bool _active;
+    bool _applied;                      // Scanner has the parameters above
+    bool _quiet;
+    float _advRate;                     // EWMA, reports per listening second
+    scan_reason_t _reason;
+    bool _dirty;                        // Re-evaluate on the next update
+    uint32_t _lastUpdate;
+    uint32_t _lastReports;
+    uint32_t _burstStart;
+    uint32_t _burstUntil;
+    uint32_t _burstCount;
+    bool _burstApplied;                 // Burst state the parameters reflect
+    volatile uint32_t _slotUntil;       // Set by the uplink task
+    uint32_t _slotCount;
+    volatile bool _slotApplied;         // Parameters reflect an uplink slot
+    volatile bool _uplinkListen;
+
+    bool isUplinkSlot(uint32_t now) { return _slotCount > 0 && (int32_t)(_slotUntil - now) > 0; }
+};
+
+// Global scheduler instance
+extern ScanScheduler scanScheduler;
+
+#endif // SCAN_SCHED_H
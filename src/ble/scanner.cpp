@@ -0,0 +1,360 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * BLE Scanner Implementation
+ */
+
+#include "scanner.h"
+#include "../util/perf_stats.h"
+#include "ble_hal.h"
+#include "../detection/allow_list.h"
+
+// Global instance
+BLEScanner bleScanner;
+
+// =============================================================================
+// CONSTRUCTOR
+// =============================================================================
+BLEScanner::BLEScanner() {
+    memset(&_params, 0, sizeof(_params));
+    _task = nullptr;
+    _consumer = nullptr;
+    _lock = nullptr;
+    _enabled = false;
+    _running = false;
+    _txHold = false;
+    _reportCount = 0;
+    _dupResetMs = BLE_RSSI_SAMPLE_MS;
+    _scanStart = 0;
+    _restartCount = 0;
+}
+
+// =============================================================================
+// INITIALIZATION
+// =============================================================================
+// Scan interval and window are in units of 0.625 ms
+#define BLE_SCAN_MS_TO_UNITS(ms)    ((uint16_t)((ms) * 8 / 5))
+
+void BLEScanner::init() {
+    _params.scan_type = BLE_ACTIVE_SCAN ? BLE_SCAN_TYPE_ACTIVE : BLE_SCAN_TYPE_PASSIVE;
+    _params.own_addr_type = BLE_ADDR_TYPE_PUBLIC;
+    _params.scan_filter_policy = BLE_SCAN_FILTER_ALLOW_ALL;
+    _params.scan_interval = BLE_SCAN_MS_TO_UNITS(BLE_SCAN_INTERVAL_MS);
+    _params.scan_window = BLE_SCAN_MS_TO_UNITS(BLE_SCAN_WINDOW_MS);
+    _params.scan_duplicate = BLE_SCAN_FILTER_DUPLICATES ?
+                             BLE_SCAN_DUPLICATE_ENABLE : BLE_SCAN_DUPLICATE_DISABLE;
+
+    _lock = xSemaphoreCreateMutex();
+    if (!bleHalAddGapListener(onGapEvent)) {
+        Serial.println("[SCAN] GAP listener table full");
+    }
+}
+
+bool BLEScanner::startTask() {
+    if (_lock == nullptr || _task != nullptr) {
+        return false;
+    }
+
+    BaseType_t rc = xTaskCreatePinnedToCore(taskEntry, "ble_scan",
+                                            TASK_BLE_SCAN_STACK, this,
+                                            TASK_BLE_SCAN_PRIORITY, &_task,
+                                            TASK_BLE_SCAN_CORE);
+    if (rc != pdPASS) {
+        _task = nullptr;
+        Serial.println("[SCAN] Failed to create scan task");
+        return false;
+    }
+
+    Serial.printf("[SCAN] Continuous scan task started on core %d\n", TASK_BLE_SCAN_CORE);
+    return true;
+}
+
+// =============================================================================
+// CONTROL
+// =============================================================================
+void BLEScanner::setEnabled(bool enabled) {
+    if (_enabled == enabled) {
+        return;
+    }
+    _enabled = enabled;
+    if (_task != nullptr) {
+        xTaskNotifyGive(_task);
+    }
+}
+
+void BLEScanner::setParams(uint16_t intervalMs, uint16_t windowMs, bool active) {
+    if (_lock == nullptr) {
+        return;
+    }
+
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    _params.scan_type = active ? BLE_SCAN_TYPE_ACTIVE : BLE_SCAN_TYPE_PASSIVE;
+    _params.scan_interval = BLE_SCAN_MS_TO_UNITS(intervalMs);
+    _params.scan_window = BLE_SCAN_MS_TO_UNITS(windowMs);
+    if (_running) {
+        // GAP commands run in order: stop, new params, start
+        stopScan();
+        startScan();
+    }
+    xSemaphoreGive(_lock);
+}
+
+void BLEScanner::setDuplicateFilter(bool enabled, uint16_t resetMs) {
+    if (_lock == nullptr) {
+        return;
+    }
+
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    _params.scan_duplicate = enabled ? BLE_SCAN_DUPLICATE_ENABLE : BLE_SCAN_DUPLICATE_DISABLE;
+    _dupResetMs = resetMs;
+    if (_running) {
+        stopScan();
+        startScan();
+    }
+    xSemaphoreGive(_lock);
+    if (_task != nullptr) {
+        xTaskNotifyGive(_task);     // Pick up the new reset period
+    }
+}
+
+void BLEScanner::holdForTx(bool hold) {
+    if (_lock == nullptr) {
+        return;
+    }
+
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    _txHold = hold;
+    if (hold && _running) {
+        stopScan();
+    } else if (!hold && _enabled && !_running) {
+        startScan();
+    }
+    xSemaphoreGive(_lock);
+}
+
+void BLEScanner::stop() {
+    _enabled = false;
+    if (_lock == nullptr) {
+        return;
+    }
+
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    bool wasRunning = _running;
+    if (wasRunning) {
+        stopScan();
+    }
+    xSemaphoreGive(_lock);
+
+    if (wasRunning) {
+        delay(50);  // Give BLE stack time to stop scan
+    }
+}
+
+// =============================================================================
+// SCAN TASK
+// =============================================================================
+void BLEScanner::taskEntry(void* param) {
+    static_cast<BLEScanner*>(param)->run();
+}
+
+// Runs in the Bluedroid host task: copy the report and return
+void BLEScanner::onGapEvent(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param) {
+    switch (event) {
+        case ESP_GAP_BLE_SCAN_RESULT_EVT:
+            if (param->scan_rst.search_evt == ESP_GAP_SEARCH_INQ_RES_EVT) {
+                PERF_SCOPE(PERF_SCAN_CALLBACK);
+                bleScanner._reportCount++;
+                if (allowList.contains(param->scan_rst.bda)) {
+                    return;  // Known-good device, counted by the allow list
+                }
+                adv_record_t* rec = bleScanner._ring.reserve();
+                if (rec == nullptr) {
+                    return;  // Queue full, counted as dropped
+                }
+
+                size_t payloadLen = param->scan_rst.adv_data_len + param->scan_rst.scan_rsp_len;
+                if (payloadLen > sizeof(rec->payload)) {
+                    payloadLen = sizeof(rec->payload);
+                }
+
+                rec->timestamp = millis();
+                memcpy(rec->mac, param->scan_rst.bda, 6);
+                rec->addrType = param->scan_rst.ble_addr_type;
+                rec->evtType = param->scan_rst.ble_evt_type;
+                rec->rssi = param->scan_rst.rssi;
+                rec->advLen = param->scan_rst.adv_data_len < payloadLen ?
+                              param->scan_rst.adv_data_len : payloadLen;
+                rec->payloadLen = payloadLen;
+                memcpy(rec->payload, param->scan_rst.ble_adv, payloadLen);
+
+                bleScanner._ring.commit();
+                if (bleScanner._consumer != nullptr) {
+                    xTaskNotifyGive(bleScanner._consumer);
+                }
+            } else if (param->scan_rst.search_evt == ESP_GAP_SEARCH_INQ_CMPL_EVT) {
+                // Only seen if the stack ends the scan on its own (duration 0 = forever)
+                bleScanner._running = false;
+                bleScanner._restartCount++;
+                if (bleScanner._task != nullptr) {
+                    xTaskNotifyGive(bleScanner._task);
+                }
+            }
+            break;
+
+        case ESP_GAP_BLE_SCAN_START_COMPLETE_EVT:
+            if (param->scan_start_cmpl.status != ESP_BT_STATUS_SUCCESS) {
+                Serial.printf("[SCAN] Scan start failed: %d\n", param->scan_start_cmpl.status);
+                bleScanner._running = false;
+            }
+            break;
+
+#if BLE_HAL_EXT_API
+        case ESP_GAP_BLE_EXT_ADV_REPORT_EVT:
+            onExtReport(&param->ext_adv_report.params);
+            break;
+
+        case ESP_GAP_BLE_EXT_SCAN_START_COMPLETE_EVT:
+            if (param->ext_scan_start.status != ESP_BT_STATUS_SUCCESS) {
+                Serial.printf("[SCAN] Scan start failed: %d\n", param->ext_scan_start.status);
+                bleScanner._running = false;
+            }
+            break;
+
+        case ESP_GAP_BLE_SCAN_TIMEOUT_EVT:
+            // Only seen if the stack ends the scan on its own (duration 0 = forever)
+            bleScanner._running = false;
+            bleScanner._restartCount++;
+            if (bleScanner._task != nullptr) {
+                xTaskNotifyGive(bleScanner._task);
+            }
+            break;
+#endif
+
+        default:
+            break;
+    }
+}
+
+#if BLE_HAL_EXT_API
+// Event type bits of an extended advertising report (Core spec Vol 4 Part E
+// 7.7.65.13)
+#define EXT_REPORT_CONNECTABLE  0x0001
+#define EXT_REPORT_SCANNABLE    0x0002
+#define EXT_REPORT_DIRECTED     0x0004
+#define EXT_REPORT_SCAN_RSP     0x0008
+
+// Runs in the Bluedroid host task. Each report is one PDU; scan responses
+// are merged with the advertisement later (mergeScanResponse).
+void BLEScanner::onExtReport(const esp_ble_gap_ext_adv_reprot_t* report) {
+    PERF_SCOPE(PERF_SCAN_CALLBACK);
+    bleScanner._reportCount++;
+    // Chained extended data that didn't fit one report; the AD structures
+    // would be cut
+    if (report->data_status != ESP_BLE_GAP_EXT_ADV_DATA_COMPLETE ||
+        report->adv_data_len > ADV_RECORD_PAYLOAD_MAX) {
+        return;
+    }
+    if (allowList.contains(report->addr)) {
+        return;  // Known-good device, counted by the allow list
+    }
+    adv_record_t* rec = bleScanner._ring.reserve();
+    if (rec == nullptr) {
+        return;  // Queue full, counted as dropped
+    }
+
+    uint16_t type = report->event_type;
+    uint8_t evtType;
+    if (type & EXT_REPORT_SCAN_RSP) {
+        evtType = ESP_BLE_EVT_SCAN_RSP;
+    } else if ((type & EXT_REPORT_CONNECTABLE) && (type & EXT_REPORT_DIRECTED)) {
+        evtType = ESP_BLE_EVT_CONN_DIR_ADV;
+    } else if (type & EXT_REPORT_CONNECTABLE) {
+        evtType = ESP_BLE_EVT_CONN_ADV;
+    } else if (type & EXT_REPORT_SCANNABLE) {
+        evtType = ESP_BLE_EVT_DISC_ADV;
+    } else {
+        evtType = ESP_BLE_EVT_NON_CONN_ADV;
+    }
+
+    rec->timestamp = millis();
+    memcpy(rec->mac, report->addr, 6);
+    rec->addrType = report->addr_type;
+    rec->evtType = evtType;
+    rec->rssi = report->rssi;
+    rec->advLen = evtType == ESP_BLE_EVT_SCAN_RSP ? 0 : report->adv_data_len;
+    rec->payloadLen = report->adv_data_len;
+    memcpy(rec->payload, report->adv_data, report->adv_data_len);
+
+    bleScanner._ring.commit();
+    if (bleScanner._consumer != nullptr) {
+        xTaskNotifyGive(bleScanner._consumer);
+    }
+}
+#endif
+
+void BLEScanner::run() {
+    for (;;) {
+        // Wake on a state change request, scan end, or supervision timeout;
+        // with the duplicate filter on, also when the filter is due a reset
+        uint32_t timeout = BLE_SCAN_SUPERVISE_MS;
+        bool dupFilter = isDuplicateFilterEnabled();
+        if (dupFilter && _running) {
+            uint32_t elapsed = millis() - _scanStart;
+            uint32_t remaining = elapsed < _dupResetMs ? _dupResetMs - elapsed : 0;
+            if (remaining < timeout) {
+                timeout = remaining;
+            }
+        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout));
+
+        xSemaphoreTake(_lock, portMAX_DELAY);
+        if (_enabled && !_running && !_txHold) {
+            startScan();
+        } else if (!_enabled && _running) {
+            stopScan();
+        } else if (_running && isDuplicateFilterEnabled() &&
+                   millis() - _scanStart >= _dupResetMs) {
+            // Restarting clears the controller's duplicate list
+            stopScan();
+            startScan();
+        }
+        xSemaphoreGive(_lock);
+    }
+}
+
+void BLEScanner::startScan() {
+    // GAP commands are queued in order, so the scan starts with these params.
+    // Duration 0 = scan until stopped.
+#if BLE_HAL_EXT_API
+    esp_ble_ext_scan_params_t ext = {};
+    ext.own_addr_type = _params.own_addr_type;
+    ext.filter_policy = _params.scan_filter_policy;
+    ext.scan_duplicate = _params.scan_duplicate;
+    ext.cfg_mask = ESP_BLE_GAP_EXT_SCAN_CFG_UNCODE_MASK;    // 1M PHY only
+    ext.uncoded_cfg.scan_type = _params.scan_type;
+    ext.uncoded_cfg.scan_interval = _params.scan_interval;
+    ext.uncoded_cfg.scan_window = _params.scan_window;
+    esp_err_t err = esp_ble_gap_set_ext_scan_params(&ext);
+    if (err == ESP_OK) {
+        err = esp_ble_gap_start_ext_scan(0, 0);
+    }
+#else
+    esp_err_t err = esp_ble_gap_set_scan_params(&_params);
+    if (err == ESP_OK) {
+        err = esp_ble_gap_start_scanning(0);
+    }
+#endif
+    _running = (err == ESP_OK);
+    _scanStart = millis();
+    if (!_running) {
+        Serial.printf("[SCAN] Failed to start scan: %d\n", err);
+    }
+}
+
+void BLEScanner::stopScan() {
+#if BLE_HAL_EXT_API
+    esp_ble_gap_stop_ext_scan();
+#else
+    esp_ble_gap_stop_scanning();
+#endif
+    _running = false;
+}
@@ -0,0 +1,114 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * BLE Scanner - Continuous background scanning
+ *
+ * Runs the BLE scan from a dedicated FreeRTOS task pinned to core 0 so the
+ * radio listens continuously instead of in short blocking bursts from loop().
+ * The scan is driven through the Bluedroid GAP API directly: reports are
+ * copied from the GAP event into the queue without creating any objects.
+ * Interval, window and scan type are chosen at runtime (see scan_sched.h).
+ * With the extended GAP API (BLE_HAL_EXT_API) the scan uses the extended
+ * scan commands; scan responses then arrive as reports of their own.
+ * With the controller duplicate filter enabled the scan is restarted
+ * periodically, which clears the filter and yields one RSSI sample per
+ * advertiser and period.
+ */
+
+#ifndef SCANNER_H
+#define SCANNER_H
+
+#include <Arduino.h>
+#include <esp_gap_ble_api.h>
+#include "../config.h"
+#include "spsc_ring.h"
+
+// =============================================================================
+// RAW ADVERTISEMENT RECORD
+// =============================================================================
+// Fixed-size copy of one advertising report, filled in the GAP callback and
+// processed later by the match task. Legacy Bluedroid hands over the advertising data and
+// any scan response concatenated, so the payload holds up to 31 + 31 bytes.
+// Extended reports carry one PDU each (advLen is 0 for a scan response).
+typedef struct {
+    uint32_t timestamp;                     // millis() when received
+    uint8_t mac[6];                         // Advertiser address
+    uint8_t addrType;                       // esp_ble_addr_type_t
+    uint8_t evtType;                        // esp_ble_evt_type_t (PDU type)
+    int8_t rssi;                            // Received signal strength
+    uint8_t advLen;                         // Adv data bytes; scan response follows
+    uint8_t payloadLen;                     // Valid bytes in payload
+    uint8_t payload[ADV_RECORD_PAYLOAD_MAX];// Raw AD structures
+} adv_record_t;
+
+// =============================================================================
+// BLE SCANNER CLASS
+// =============================================================================
+class BLEScanner {
+public:
+    BLEScanner();
+
+    // Initialization (call after bleHalInit)
+    void init();
+    bool startTask();
+
+    // Control - the scan task applies the requested state asynchronously
+    void setEnabled(bool enabled);
+    void stop();                        // Synchronous stop
+
+    // Scan timing and type; a running scan is restarted with the new values
+    void setParams(uint16_t intervalMs, uint16_t windowMs, bool active);
+
+    // Controller duplicate filter: each advertiser is reported once per
+    // scan, and the scan is restarted every resetMs to take a fresh RSSI
+    void setDuplicateFilter(bool enabled, uint16_t resetMs);
+    bool isDuplicateFilterEnabled() { return _params.scan_duplicate == BLE_SCAN_DUPLICATE_ENABLE; }
+    uint16_t getDuplicateResetMs() { return _dupResetMs; }
+
+    // The stack rejects a random address change while scanning, so the TX
+    // task pauses the scan around it (true) and resumes it after (false).
+    // Legacy API only: extended advertising sets have their own addresses.
+    // It only changes the address when the packet's MAC differs from the
+    // last one set, but per-packet random MACs (confusion mode, TX with a
+    // random MAC) restart the scan on every packet.
+    void holdForTx(bool hold);
+
+    // Result queue (producer: GAP callback, consumer: match task). The
+    // consumer task, if set, is notified for every queued report.
+    void setConsumer(TaskHandle_t task) { _consumer = task; }
+    size_t drain(adv_record_t* out, size_t max) { return _ring.pop(out, max); }
+    size_t getQueuedCount() { return _ring.size(); }
+    uint32_t getDroppedCount() { return _ring.dropped(); }
+
+    // Status
+    bool isRunning() { return _running; }
+    bool isTaskStarted() { return _task != nullptr; }
+    uint32_t getRestartCount() { return _restartCount; }
+    uint32_t getReportCount() { return _reportCount; }  // Incl. dropped ones
+
+private:
+    esp_ble_scan_params_t _params;
+    TaskHandle_t _task;
+    TaskHandle_t _consumer;
+    SemaphoreHandle_t _lock;
+    volatile bool _enabled;             // Requested state
+    volatile bool _running;             // Actual state
+    volatile bool _txHold;              // Paused for a TX address change
+    volatile uint32_t _reportCount;     // Advertising reports received
+    uint16_t _dupResetMs;               // Duplicate filter reset period
+    uint32_t _scanStart;                // millis() of the last scan start
+    uint32_t _restartCount;             // Scans the stack ended on its own
+    SpscRing<adv_record_t, ADV_RING_SIZE> _ring;
+
+    // Internal methods
+    static void taskEntry(void* param);
+    static void onGapEvent(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param);
+    static void onExtReport(const esp_ble_gap_ext_adv_reprot_t* report);
+    void run();
+    void startScan();
+    void stopScan();
+};
+
+// Global scanner instance
+extern BLEScanner bleScanner;
+
+#endif // SCANNER_H
@@ -0,0 +1,88 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Lock-free Single-Producer / Single-Consumer Ring Buffer
+ *
+ * Fixed-capacity FIFO used to hand records from the BLE host context to
+ * the match task without locks. Exactly one task may push and one task may pop.
+ */
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+    SpscRing() : _head(0), _tail(0), _dropped(0) {}
+
+    // -------------------------------------------------------------------------
+    // Producer side
+    // -------------------------------------------------------------------------
+    // Reserve the next free slot so the producer can fill it in place.
+    // Returns nullptr (and counts a drop) if the ring is full.
+    T* reserve() {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        uint32_t tail = _tail.load(std::memory_order_acquire);
+        if (head - tail >= N) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &_buf[head & (N - 1)];
+    }
+
+    // Publish the slot returned by the last successful reserve()
+    void commit() {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        _head.store(head + 1, std::memory_order_release);
+    }
+
+    bool push(const T& item) {
+        T* slot = reserve();
+        if (slot == nullptr) {
+            return false;
+        }
+        *slot = item;
+        commit();
+        return true;
+    }
+
+    // -------------------------------------------------------------------------
+    // Consumer side
+    // -------------------------------------------------------------------------
+    // Copy up to max records into out; returns the number copied
+    size_t pop(T* out, size_t max) {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        uint32_t head = _head.load(std::memory_order_acquire);
+        size_t count = head - tail;
+        if (count > max) {
+            count = max;
+        }
+        for (size_t i = 0; i < count; i++) {
+            out[i] = _buf[(tail + i) & (N - 1)];
+        }
+        _tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // -------------------------------------------------------------------------
+    // Status (safe from either side)
+    // -------------------------------------------------------------------------
+    size_t size() const {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+    static constexpr size_t capacity() { return N; }
+    uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    T _buf[N];
+    std::atomic<uint32_t> _head;        // Written by producer only
+    std::atomic<uint32_t> _tail;        // Written by consumer only
+    std::atomic<uint32_t> _dropped;     // Written by producer only
+};
+
+#endif // SPSC_RING_H
@@ -19,13 +19,18 @@
 // The 2.8" CYD ships in two revisions with different TFT controllers:
 //   BLEPTD_VARIANT_MICROUSB -> ESP32-2432S028R   (ILI9341 driver)
 //   BLEPTD_VARIANT_USBC     -> ESP32-2432S028R v3 (ILI9342 driver, RGB, inverted)
+// BLEPTD_VARIANT_S3 is an ESP32-S3-DevKitC-1 wired to a 2.8" ILI9341 +
+// XPT2046 module (pins below); its BLE 5.0 controller enables extended
+// advertising (see ble_hal.h).
 // One of these is selected at compile time via platformio.ini.
-#if !defined(BLEPTD_VARIANT_MICROUSB) && !defined(BLEPTD_VARIANT_USBC)
+#if !defined(BLEPTD_VARIANT_MICROUSB) && !defined(BLEPTD_VARIANT_USBC) && !defined(BLEPTD_VARIANT_S3)
 #define BLEPTD_VARIANT_MICROUSB 1
 #endif
 
 #if defined(BLEPTD_VARIANT_USBC)
 #define BLEPTD_VARIANT_STRING "USB-C/ILI9342"
+#elif defined(BLEPTD_VARIANT_S3)
+#define BLEPTD_VARIANT_STRING "ESP32-S3/ILI9341"
 #else
 #define BLEPTD_VARIANT_STRING "microUSB/ILI9341"
 #endif
@@ -33,6 +38,26 @@
 // =============================================================================
 // HARDWARE PIN DEFINITIONS (CYD 2.8" — identical on both revisions)
 // =============================================================================
+#if defined(BLEPTD_VARIANT_S3)
+
+// TFT Display (ILI9341) on SPI3; strapping, USB, flash and octal PSRAM
+// pins are left free
+#define TFT_MISO_PIN    13
+#define TFT_MOSI_PIN    11
+#define TFT_SCLK_PIN    12
+#define TFT_CS_PIN      10
+#define TFT_DC_PIN      9
+#define TFT_RST_PIN     8
+#define TFT_BL_PIN      21
+
+// Touch Screen (XPT2046) on its own bus (SPI2)
+#define TOUCH_CS_PIN    7
+#define TOUCH_IRQ_PIN   15
+
+// SD Card
+#define SD_CS_PIN       16
+
+#else
 
 // TFT Display (ILI9341)
 #define TFT_MISO_PIN    12
@@ -50,6 +75,8 @@
 // SD Card
 #define SD_CS_PIN       5
 
+#endif
+
 // =============================================================================
 // DISPLAY SETTINGS
 // =============================================================================
@@ -62,32 +89,175 @@
 #define NAV_BAR_HEIGHT      40
 #define CONTENT_HEIGHT      (SCREEN_HEIGHT - STATUS_BAR_HEIGHT - NAV_BAR_HEIGHT)
 
+// Scan list rows are redrawn individually; RSSI-only changes are batched
+#define SCAN_RSSI_REFRESH_MS    1000
+
+// The UI task sleeps until a UI event arrives (ui_events.h). Events that
+// arrive while a frame is drawn are coalesced into the next one.
+#define UI_FRAME_MIN_MS         33      // Frame rate cap (~30 fps)
+#define UI_IDLE_MS              1000    // Longest sleep without events
+#define UI_TX_REFRESH_MS        500     // TX screen redraw rate while counters change
+#define TOUCH_POLL_MS           50      // Touch read rate while the panel is pressed
+
+// Full scan/TX screen redraws are composed off-screen and pushed with DMA.
+// A 16-bit content buffer needs ~113 KB; if that allocation fails an 8-bit
+// buffer (~56 KB) is used and expanded to 16-bit in strips while pushing.
+#define DISPLAY_USE_SPRITE      true
+#define DISPLAY_STRIP_LINES     12      // Lines per DMA strip (8-bit buffer)
+
 // =============================================================================
 // BLE SETTINGS
 // =============================================================================
-#define BLE_SCAN_DURATION_SEC   1
 #define BLE_SCAN_INTERVAL_MS    100
 #define BLE_SCAN_WINDOW_MS      99
 #define BLE_ACTIVE_SCAN         true
 
+// Hybrid scanning: passive by default. A short active burst collects scan
+// responses when an unmatched advertiser could still match by name; the
+// responses are cached per MAC (scan_rsp_cache.h) and merged into later
+// reports. false = always scan as BLE_ACTIVE_SCAN says.
+#define BLE_HYBRID_SCAN         true
+#define BLE_HYBRID_BURST_MS     1500    // Active scanning per burst
+#define BLE_HYBRID_BURST_GAP_MS 5000    // Min time between burst starts
+#define SCAN_RSP_CACHE_SIZE     32      // Advertisers remembered
+#define SCAN_RSP_CACHE_TTL_MS   300000  // A cached response is reused this long
+#define SCAN_RSP_RETRY_MS       60000   // Unanswered request may be repeated
+
+// Scanning runs continuously on a dedicated task (TASK_BLE_SCAN_*) so the
+// radio listens ~100% of the time.
+#define BLE_SCAN_SUPERVISE_MS   250     // Scan task state check period
+
+// Duplicate suppression. A known device whose payload hash is unchanged
+// skips matching and only updates RSSI/lastSeen; unmatched payloads are
+// remembered per MAC (match_cache.h). Optionally the controller drops
+// duplicates too; its filter is reset every BLE_RSSI_SAMPLE_MS so present
+// devices still report a fresh RSSI at that rate (SCAN DUPFILTER/SAMPLE).
+#define MATCH_CACHE_ENABLED     true
+#define MATCH_CACHE_SIZE        64      // Unmatched advertisers (power of two)
+#define BLE_SCAN_FILTER_DUPLICATES false
+#define BLE_RSSI_SAMPLE_MS      1000
+#define BLE_RSSI_SAMPLE_MIN_MS  250
+
+// Allow list (IGNORE ADD/REMOVE): known-good MACs dropped in the scan
+// callback. False positive rate of the Bloom filter when full, by bits per
+// entry: 8 -> ~2%, 10 -> ~1%, 16 -> ~0.05%. Probes: bits per entry * ln 2.
+#define ALLOW_LIST_FILE         "/ignore.txt"
+#define ALLOW_LIST_MAX          64      // Entries (6 bytes each + filter)
+#define ALLOW_BLOOM_BITS_PER_ENTRY 10
+#define ALLOW_BLOOM_HASHES      7
+#define ALLOW_LIST_CONFIRM      true    // Check filter hits against the list
+
+// Adaptive scan scheduling (scan_sched.h): the window above is the
+// full-duty case and shrinks while transmitting, in quiet surroundings and while
+// the screen sleeps. Rates are reports per second of listening time.
+#define BLE_SCHED_PERIOD_MS     1000    // Re-evaluation period
+#define BLE_SCHED_TX_DUTY_PCT   50      // Leaves air time for TX packets
+#define BLE_SCHED_QUIET_DUTY_PCT 30     // Few advertisers around
+#define BLE_SCHED_POWERSAVE_DUTY_PCT 50 // Screen asleep
+#define BLE_SCHED_UPLINK_DUTY_PCT 50    // ESP-NOW uplink sending or listening
+#define BLE_SCHED_QUIET_RATE    3.0f    // Below this: quiet (passive scan)
+#define BLE_SCHED_BUSY_RATE     8.0f    // Above this: back to active scanning
+#define BLE_SCAN_WINDOW_MIN_MS  10
+
+// Raw advertisement queue between the GAP callback and the match task
+#define ADV_RING_SIZE           64      // Records (must be a power of two)
+#define ADV_RECORD_PAYLOAD_MAX  62      // Adv data + scan response
+#define ADV_DRAIN_BATCH         16      // Records processed per batch
+
 // TX Settings
 #define TX_DEFAULT_INTERVAL_MS  100
 #define TX_MAX_CONCURRENT       8
 #define TX_CONFUSION_MAX_DEVICES 16
+#define TX_CONFUSION_INTERVAL_MS 20     // 50 packets/sec max in confusion mode
+#define TX_ADV_DWELL_MS         30      // Advertise this long per packet
+#define TX_GAP_TIMEOUT_MS       100     // Max wait for a GAP completion event
+#define TX_IDLE_POLL_MS         100     // TX task wake-up when nothing is due
+// Extended advertising (BLE 5.0 chips only): one set for sessions, the rest
+// carry one confusion instance each. Sets beyond what the controller has
+// room for (CONFIG_BT_CTRL_BLE_MAX_ACT, less one for the scan) stay off air.
+#ifndef TX_EXT_ADV_SETS
+#define TX_EXT_ADV_SETS         10
+#endif
+#define TX_EXT_CONFUSION_INTERVAL_MS 100 // Per-instance advertising interval
 
 // =============================================================================
 // SERIAL SETTINGS
 // =============================================================================
 #define SERIAL_BAUD_RATE        115200
 #define SERIAL_CMD_BUFFER_SIZE  256
+#define SERIAL_CMD_MAX_TOKENS   12      // Per command; a line may hold several
 #define SERIAL_JSON_OUTPUT      false   // Default to human-readable
+#define SERIAL_TX_BUFFER_SIZE   2048    // Binary frames are dropped when full
+#define SERIAL_BAUD_MAX         2000000
+#define RAW_STREAM_BUFFER_SIZE  1024    // STREAM RAW batch buffer
+#define RAW_STREAM_QUEUE_SIZE   32      // Reports waiting for the serial task
+#define RAW_STREAM_FLUSH_MS     50      // Max age of a buffered raw record
+
+// =============================================================================
+// UPLINK SETTINGS
+// =============================================================================
+// Nodes send device table changes over ESP-NOW to a collector (uplink.h).
+// Off until UPLINK NODE/COLLECTOR or uplink_mode in /config.txt.
+#define UPLINK_CHANNEL_DEFAULT  1       // Wi-Fi channel; all units must agree
+#define UPLINK_INTERVAL_MS      1000    // Batch period (UPLINK INTERVAL)
+#define UPLINK_INTERVAL_MIN_MS  200
+#define UPLINK_INTERVAL_MAX_MS  60000
+#define UPLINK_REFRESH_BATCHES  30      // Every Nth batch resends all devices
+#define UPLINK_RSSI_DELTA       3       // dB change worth sending
+#define UPLINK_BATCH_PACKETS    4       // Packets per batch; the rest waits
+#define UPLINK_SLOT_MS          300     // Narrowed scan window per batch
+#define UPLINK_RX_QUEUE_SIZE    8       // Packets waiting for the serial task
+#define UPLINK_MAX_NODES        8       // Nodes the collector keeps counters for
 
 // =============================================================================
 // STORAGE SETTINGS
 // =============================================================================
 #define CONFIG_NAMESPACE        "bleptd"
 #define SIG_DB_MAX_ENTRIES      128
+#define SIG_DB_JSON_FILE        "/signatures.json"  // Editable source
+#define SIG_DB_BIN_FILE         "/signatures.bin"   // Converted on boot
+
+// Detection log: records are batched in RAM and written by a background
+// task when a batch fills or gets old, never once per detection
+#define DET_LOG_FILE_PREFIX     "/detlog"   // Segments /detlog0.bin ...
+#define DET_LOG_SEGMENTS        4
+#define DET_LOG_SEGMENT_SIZE    65536       // Bytes per segment file
+#define DET_LOG_BATCH_BYTES     512         // RAM batch (two SPIFFS pages)
+#define DET_LOG_FLUSH_MS        30000       // Max age of a buffered record
+#define DET_LOG_RESIGHT_MS      60000       // Present devices are re-logged this often
+
+// Device table capacity; override from build_flags to fit the RAM budget.
+// Once full, the least recently seen device is evicted for a new one.
+// Each device costs about 32 bytes of internal RAM (hot record and index)
+// plus its detail record, which moves to PSRAM on boards that have it, so
+// a PSRAM board can raise this into the hundreds.
+#ifndef DETECTED_DEVICES_MAX
 #define DETECTED_DEVICES_MAX    64
+#endif
+#define DEVICE_DETAIL_PSRAM     true    // Detail records in PSRAM when present
+#define DEVICE_INACTIVE_SEC     60      // Not seen for this long = inactive
+
+// Tracker clustering (cluster.h): a new random MAC continues a quiet entry
+// with the same signature and payload fingerprint and a similar RSSI
+#define CLUSTER_ENABLED         true
+#define CLUSTER_WINDOW_MS       30000   // Old MAC last seen at most this long ago
+#define CLUSTER_MIN_GAP_MS      1500    // ...and at least this long ago
+#define CLUSTER_MIN_HOLD_MS     60000   // A linked entry isn't relinked sooner
+#define CLUSTER_RSSI_DELTA      15      // dB
+#define CLUSTER_MAX_PROBE       16      // Entries examined per new MAC
+
+// Per-device RSSI tracking (rssi_track.h). The shown RSSI is an EWMA with
+// gain 1/2^RSSI_EWMA_SHIFT; the ring keeps one estimate per sample period.
+#define RSSI_EWMA_SHIFT         3
+#define RSSI_TRACK_RESET_MS     30000   // Estimate restarts after this gap
+#define RSSI_TRACK_RING         8       // Samples kept (ring spans 2 min)
+#define RSSI_TRACK_SAMPLE_MS    15000
+
+// Follower alert: a device of these categories stayed in range this long
+#define FOLLOWER_CATEGORIES     CAT_TRACKER
+#define FOLLOWER_DWELL_MIN      10      // Minutes
+#define FOLLOWER_RSSI_MIN       -85     // dBm (filtered) that counts as in range
+#define FOLLOWER_GAP_MS         60000   // Longer out of range ends the dwell
 
 // =============================================================================
 // POWER SAVE SETTINGS
@@ -97,6 +267,24 @@
 #define POWERSAVE_ENABLED_DEFAULT       true    // Power save enabled by default
 #define POWERSAVE_TIMEOUT_SEC_DEFAULT   300     // 5 minutes (300 seconds)
 #define POWERSAVE_CONFIG_FILE           "/config.txt"
+#define POWERSAVE_LIGHT_SLEEP_DEFAULT   true    // powersave_light_sleep
+
+// While the screen is off the CPU clock may drop (DFS) and, where the build
+// has tickless idle, the chip light-sleeps between events (power_mgr.h)
+#define POWER_ACTIVE_CPU_MHZ    240
+#define POWER_IDLE_CPU_MHZ      80      // Lowest clock the BLE controller allows
+#define POWER_UART_WAKE_EDGES   3       // RX edges that wake from light sleep
+#define POWER_STATS_PERIOD_MS   5000    // Wakeup rate window
+#define TOUCH_SLEEP_POLL_MS     100     // PENIRQ poll in light sleep (no GPIO wake)
+
+// Current model for the STATUS estimate (typical CYD figures, 5 V supply)
+#define POWER_EST_BOARD_MA      20      // Regulator, USB-UART, touch, flash
+#define POWER_EST_CPU_80_MA     22
+#define POWER_EST_CPU_240_MA    50
+#define POWER_EST_LIGHT_SLEEP_MA 1
+#define POWER_EST_WAKE_MS       2       // Average time awake per wakeup
+#define POWER_EST_RADIO_RX_MA   95      // Scaled by the scan duty cycle
+#define POWER_EST_BACKLIGHT_MA  55
 
 // =============================================================================
 // DEVICE CATEGORIES
@@ -149,6 +337,12 @@ typedef enum {
 #define TASK_BLE_SCAN_PRIORITY  5
 #define TASK_BLE_SCAN_CORE      0
 
+// Pipeline: the match task drains the scan ring on core 0; the serial and
+// UI tasks take over from loop() on core 1 (see main.cpp)
+#define TASK_MATCH_STACK        6144
+#define TASK_MATCH_PRIORITY     3
+#define TASK_MATCH_CORE         0
+
 #define TASK_BLE_TX_STACK       4096
 #define TASK_BLE_TX_PRIORITY    4
 #define TASK_BLE_TX_CORE        0
@@ -157,10 +351,30 @@ typedef enum {
 #define TASK_UI_PRIORITY        3
 #define TASK_UI_CORE            1
 
-#define TASK_SERIAL_STACK       4096
+#define TASK_LOG_STACK          3072
+#define TASK_LOG_PRIORITY       1
+#define TASK_LOG_CORE           1
+
+#define TASK_UPLINK_STACK       4096
+#define TASK_UPLINK_PRIORITY    1
+#define TASK_UPLINK_CORE        1
+
+#define TASK_SERIAL_STACK       8192    // Command handlers format on the stack
 #define TASK_SERIAL_PRIORITY    2
 #define TASK_SERIAL_CORE        1
 
+#define DET_EVENT_QUEUE_SIZE    16      // Detections waiting for the serial task
+#define MATCH_IDLE_MS           250     // Match task wakes at least this often
+#define SERIAL_IDLE_MS          500     // Serial task fallback wake (RX and events notify it)
+#define MATCH_BATCH_IDLE_MS     100     // Report batching while the screen is off
+
+// =============================================================================
+// PERFORMANCE STATISTICS
+// =============================================================================
+#ifndef PERF_STATS_ENABLED
+#define PERF_STATS_ENABLED      1       // STATS command; 0 compiles it out
+#endif
+
 // =============================================================================
 // DEBUG MACROS
 // =============================================================================
@@ -0,0 +1,99 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Advertisement Parser Implementation
+ */
+
+#include "adv_parser.h"
+#include <string.h>
+
+bool advParse(const uint8_t* payload, size_t len, adv_view_t* view) {
+    memset(view, 0, sizeof(*view));
+    view->mfgOffset = ADV_VIEW_NONE;
+    view->nameOffset = ADV_VIEW_NONE;
+
+    if (len > ADV_VIEW_NONE) {
+        len = ADV_VIEW_NONE;  // Offsets are 8-bit
+    }
+
+    size_t idx = 0;
+    while (idx < len) {
+        uint8_t adLen = payload[idx];
+        if (adLen == 0) {
+            break;  // Early termination / zero padding
+        }
+        if (idx + adLen >= len) {
+            return false;  // Structure runs past the end of the payload
+        }
+
+        uint8_t type = payload[idx + 1];
+        uint8_t dataOffset = idx + 2;
+        uint8_t dataLen = adLen - 1;
+
+        switch (type) {
+            case AD_TYPE_FLAGS:
+                if (dataLen >= 1) {
+                    view->adFlags = payload[dataOffset];
+                }
+                break;
+
+            case AD_TYPE_TX_POWER:
+                if (dataLen >= 1) {
+                    view->txPower = (int8_t)payload[dataOffset];
+                }
+                break;
+
+            case AD_TYPE_MANUFACTURER:
+                if (view->mfgOffset == ADV_VIEW_NONE && dataLen >= 2) {
+                    view->mfgOffset = dataOffset;
+                    view->mfgLen = dataLen;
+                    view->companyId = payload[dataOffset] | (payload[dataOffset + 1] << 8);
+                }
+                break;
+
+            case AD_TYPE_UUID16_INCOMPLETE:
+            case AD_TYPE_UUID16_COMPLETE:
+                for (uint8_t i = 0; i + 1 < dataLen && view->uuid16Count < ADV_VIEW_MAX_UUID16; i += 2) {
+                    view->uuid16[view->uuid16Count++] =
+                        payload[dataOffset + i] | (payload[dataOffset + i + 1] << 8);
+                }
+                break;
+
+            case AD_TYPE_UUID128_INCOMPLETE:
+            case AD_TYPE_UUID128_COMPLETE:
+                for (uint8_t i = 0; i + 15 < dataLen && view->uuid128Count < ADV_VIEW_MAX_UUID128; i += 16) {
+                    view->uuid128Offset[view->uuid128Count++] = dataOffset + i;
+                }
+                break;
+
+            case AD_TYPE_NAME_SHORT:
+            case AD_TYPE_NAME_COMPLETE:
+                // Prefer the complete name when both are present
+                if (view->nameOffset == ADV_VIEW_NONE || type == AD_TYPE_NAME_COMPLETE) {
+                    view->nameOffset = dataOffset;
+                    view->nameLen = dataLen;
+                }
+                break;
+        }
+
+        view->structCount++;
+        idx += adLen + 1;
+    }
+
+    return true;
+}
+
+size_t advCopyName(const adv_view_t* view, const uint8_t* payload, char* out, size_t outSize) {
+    if (outSize == 0) {
+        return 0;
+    }
+    size_t n = 0;
+    if (advHasName(view)) {
+        n = view->nameLen;
+        if (n > outSize - 1) {
+            n = outSize - 1;
+        }
+        memcpy(out, payload + view->nameOffset, n);
+    }
+    out[n] = '\0';
+    return n;
+}
@@ -0,0 +1,78 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Advertisement Parser
+ *
+ * Single-pass, allocation-free parser for raw advertising data. It produces a
+ * small POD view holding offsets into the payload, so the view stays valid
+ * wherever the payload bytes are copied along with it.
+ */
+
+#ifndef ADV_PARSER_H
+#define ADV_PARSER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// =============================================================================
+// AD TYPES
+// =============================================================================
+#define AD_TYPE_FLAGS               0x01
+#define AD_TYPE_UUID16_INCOMPLETE   0x02
+#define AD_TYPE_UUID16_COMPLETE     0x03
+#define AD_TYPE_UUID128_INCOMPLETE  0x06
+#define AD_TYPE_UUID128_COMPLETE    0x07
+#define AD_TYPE_NAME_SHORT          0x08
+#define AD_TYPE_NAME_COMPLETE       0x09
+#define AD_TYPE_TX_POWER            0x0A
+#define AD_TYPE_SERVICE_DATA16      0x16
+#define AD_TYPE_MANUFACTURER        0xFF
+
+// =============================================================================
+// ADVERTISEMENT VIEW
+// =============================================================================
+#define ADV_VIEW_MAX_UUID16     12
+#define ADV_VIEW_MAX_UUID128    3
+#define ADV_VIEW_NONE           0xFF    // Offset value for "field not present"
+
+typedef struct {
+    uint8_t mfgOffset;                      // Start of mfg data (company ID LSB)
+    uint8_t mfgLen;                         // Mfg data length incl. company ID
+    uint16_t companyId;                     // Decoded company ID (if mfgLen >= 2)
+    uint8_t nameOffset;                     // Start of local name
+    uint8_t nameLen;                        // Local name length (not terminated)
+    uint8_t uuid16Count;                    // All 16-bit UUIDs, in order
+    uint16_t uuid16[ADV_VIEW_MAX_UUID16];
+    uint8_t uuid128Count;                   // Offsets of 128-bit UUIDs
+    uint8_t uuid128Offset[ADV_VIEW_MAX_UUID128];
+    uint8_t adFlags;                        // AD Flags value (0 if absent)
+    int8_t txPower;                         // TX power level (0 if absent)
+    uint8_t structCount;                    // Well-formed AD structures seen
+} adv_view_t;
+
+// Parse payload into view. Returns false if the payload is malformed; fields
+// found before the malformed structure are still filled in.
+bool advParse(const uint8_t* payload, size_t len, adv_view_t* view);
+
+// =============================================================================
+// VIEW ACCESSORS
+// =============================================================================
+inline bool advHasMfgData(const adv_view_t* view) {
+    return view->mfgOffset != ADV_VIEW_NONE && view->mfgLen >= 2;
+}
+
+inline bool advHasName(const adv_view_t* view) {
+    return view->nameOffset != ADV_VIEW_NONE && view->nameLen > 0;
+}
+
+inline const char* advName(const adv_view_t* view, const uint8_t* payload) {
+    return (const char*)(payload + view->nameOffset);
+}
+
+inline const uint8_t* advUuid128(const adv_view_t* view, const uint8_t* payload, uint8_t i) {
+    return payload + view->uuid128Offset[i];
+}
+
+// Copy the local name into a NUL-terminated buffer; returns the length copied
+size_t advCopyName(const adv_view_t* view, const uint8_t* payload, char* out, size_t outSize);
+
+#endif // ADV_PARSER_H
@@ -0,0 +1,264 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Allow List Implementation
+ */
+
+#include "allow_list.h"
+#include <SPIFFS.h>
+#include <math.h>
+
+// Global instance
+AllowList allowList;
+
+static_assert(ALLOW_LIST_MAX <= 255, "Entry count is stored in a byte");
+static_assert(ALLOW_BLOOM_HASHES >= 1, "Bloom filter needs at least one probe");
+
+// =============================================================================
+// HELPERS
+// =============================================================================
+static int hexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool macParse(const char* s, uint8_t* mac) {
+    for (int i = 0; i < 6; i++) {
+        int hi = hexNibble(s[0]);
+        int lo = hi >= 0 ? hexNibble(s[1]) : -1;
+        if (lo < 0) {
+            return false;
+        }
+        mac[i] = (uint8_t)(hi << 4 | lo);
+        s += 2;
+        if (i < 5) {
+            if (*s != ':' && *s != '-') {
+                return false;
+            }
+            s++;
+        }
+    }
+    return *s == '\0';
+}
+
+// Two independent hashes of the address; probe i is h1 + i * h2
+// (Kirsch-Mitzenmacher), so one pass over the bytes serves every probe
+static inline void macHashes(const uint8_t* mac, uint32_t* h1, uint32_t* h2) {
+    uint32_t a = 2166136261u;
+    uint32_t b = 0x9E3779B9u;
+    for (int i = 0; i < 6; i++) {
+        a = (a ^ mac[i]) * 16777619u;
+        b = (b + mac[i]) * 0x85EBCA6Bu;
+        b ^= b >> 13;
+    }
+    *h1 = a;
+    *h2 = b | 1;                        // Odd, so the probes don't repeat early
+}
+
+// =============================================================================
+// CONSTRUCTOR / INITIALIZATION
+// =============================================================================
+AllowList::AllowList() : _seq(0) {
+    memset(_bloom, 0, sizeof(_bloom));
+    memset(_macs, 0, sizeof(_macs));
+    _count = 0;
+    _ignored = 0;
+    _falsePositives = 0;
+}
+
+bool AllowList::init() {
+    if (!SPIFFS.exists(ALLOW_LIST_FILE)) {
+        return true;
+    }
+    fs::File file = SPIFFS.open(ALLOW_LIST_FILE, "r");
+    if (!file) {
+        Serial.println("[ALLOW] Failed to open " ALLOW_LIST_FILE);
+        return false;
+    }
+
+    int skipped = 0;
+    while (file.available()) {
+        String line = file.readStringUntil('\n');
+        int hash = line.indexOf('#');
+        if (hash >= 0) {
+            line = line.substring(0, hash);
+        }
+        line.trim();
+        if (line.length() == 0) {
+            continue;
+        }
+        uint8_t mac[6];
+        if (!macParse(line.c_str(), mac) || _count >= ALLOW_LIST_MAX) {
+            skipped++;
+            continue;
+        }
+        int pos = find(mac);
+        if (pos < 0) {
+            pos = -pos - 1;
+            memmove(_macs[pos + 1], _macs[pos], (size_t)(_count - pos) * 6);
+            memcpy(_macs[pos], mac, 6);
+            _count++;
+        }
+    }
+    file.close();
+
+    beginWrite();
+    rebuild();
+    endWrite();
+    Serial.printf("[ALLOW] %d devices ignored (%d lines skipped), %u bytes\n",
+                  _count, skipped, (unsigned)getMemoryBytes());
+    return true;
+}
+
+// =============================================================================
+// LOOKUP
+// =============================================================================
+int AllowList::find(const uint8_t* mac) {
+    int lo = 0;
+    int hi = _count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = memcmp(_macs[mid], mac, 6);
+        if (cmp == 0) {
+            return mid;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return -lo - 1;
+}
+
+bool AllowList::contains(const uint8_t* mac) {
+    uint32_t seq = _seq.load(std::memory_order_acquire);
+    if ((seq & 1) || _count == 0) {
+        return false;
+    }
+
+    uint32_t h1, h2;
+    macHashes(mac, &h1, &h2);
+    for (uint8_t i = 0; i < ALLOW_BLOOM_HASHES; i++) {
+        uint32_t bit = (h1 + i * h2) % ALLOW_BLOOM_BITS;
+        if (!(_bloom[bit / 32] & (1u << (bit % 32)))) {
+            return false;
+        }
+    }
+
+    bool listed = true;
+    if (ALLOW_LIST_CONFIRM) {
+        listed = find(mac) >= 0;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (_seq.load(std::memory_order_relaxed) != seq) {
+        return false;                   // Rebuilt meanwhile; let it through
+    }
+    if (!listed) {
+        _falsePositives++;
+        return false;
+    }
+    _ignored++;
+    return true;
+}
+
+// =============================================================================
+// EDITING
+// =============================================================================
+void AllowList::beginWrite() {
+    _seq.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void AllowList::endWrite() {
+    _seq.fetch_add(1, std::memory_order_release);
+}
+
+// A Bloom filter can't forget an entry, so every change rebuilds it from
+// the list (at most ALLOW_LIST_MAX * ALLOW_BLOOM_HASHES bit sets). Callers
+// hold the sequence counter odd.
+void AllowList::rebuild() {
+    memset(_bloom, 0, sizeof(_bloom));
+    for (int n = 0; n < _count; n++) {
+        uint32_t h1, h2;
+        macHashes(_macs[n], &h1, &h2);
+        for (uint8_t i = 0; i < ALLOW_BLOOM_HASHES; i++) {
+            uint32_t bit = (h1 + i * h2) % ALLOW_BLOOM_BITS;
+            _bloom[bit / 32] |= 1u << (bit % 32);
+        }
+    }
+}
+
+int AllowList::add(const uint8_t* mac) {
+    int pos = find(mac);
+    if (pos >= 0) {
+        return 1;
+    }
+    if (_count >= ALLOW_LIST_MAX) {
+        return -1;
+    }
+    pos = -pos - 1;
+
+    beginWrite();
+    memmove(_macs[pos + 1], _macs[pos], (size_t)(_count - pos) * 6);
+    memcpy(_macs[pos], mac, 6);
+    _count++;
+    rebuild();
+    endWrite();
+
+    save();
+    return 0;
+}
+
+bool AllowList::remove(const uint8_t* mac) {
+    int pos = find(mac);
+    if (pos < 0) {
+        return false;
+    }
+
+    beginWrite();
+    memmove(_macs[pos], _macs[pos + 1], (size_t)(_count - pos - 1) * 6);
+    _count--;
+    rebuild();
+    endWrite();
+
+    save();
+    return true;
+}
+
+void AllowList::clear() {
+    beginWrite();
+    _count = 0;
+    rebuild();
+    endWrite();
+
+    save();
+}
+
+bool AllowList::save() {
+    fs::File file = SPIFFS.open(ALLOW_LIST_FILE, "w");
+    if (!file) {
+        Serial.println("[ALLOW] Failed to write " ALLOW_LIST_FILE);
+        return false;
+    }
+    file.println("# BLEPTD allow list: one MAC per line, never matched or listed");
+    for (int i = 0; i < _count; i++) {
+        const uint8_t* m = _macs[i];
+        file.printf("%02X:%02X:%02X:%02X:%02X:%02X\n", m[0], m[1], m[2], m[3], m[4], m[5]);
+    }
+    file.close();
+    return true;
+}
+
+// =============================================================================
+// STATISTICS
+// =============================================================================
+// (1 - e^(-kn/m))^k for the entries actually present
+float AllowList::getEstimatedFpRate() {
+    if (_count == 0) {
+        return 0.0f;
+    }
+    float fill = 1.0f - expf(-(float)ALLOW_BLOOM_HASHES * _count / ALLOW_BLOOM_BITS);
+    return powf(fill, ALLOW_BLOOM_HASHES);
+}
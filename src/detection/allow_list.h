@@ -0,0 +1,78 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Allow List - Known-good devices that are dropped before matching
+ *
+ * The team's own watches and headsets make up most of the traffic in a
+ * familiar place. Their addresses are kept in ALLOW_LIST_FILE and checked
+ * first thing in the GAP scan callback, so their reports never take a
+ * ring slot, reach the matcher or enter the device table.
+ *
+ * The callback tests a Bloom filter (ALLOW_BLOOM_BITS_PER_ENTRY bits per
+ * entry of capacity, ALLOW_BLOOM_HASHES probes). A hit is confirmed against
+ * the sorted address list when ALLOW_LIST_CONFIRM is set, so a false
+ * positive costs one binary search instead of hiding a device. Readers take
+ * no lock: commands rebuild the filter under a sequence counter, and a
+ * lookup that overlaps a rebuild lets the report through.
+ *
+ * Entries are addresses only. Payload fingerprints are shared by every unit
+ * of a model, so listing one would hide other people's devices as well.
+ */
+
+#ifndef ALLOW_LIST_H
+#define ALLOW_LIST_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "../config.h"
+
+#define ALLOW_BLOOM_BITS    (ALLOW_LIST_MAX * ALLOW_BLOOM_BITS_PER_ENTRY)
+#define ALLOW_BLOOM_WORDS   ((ALLOW_BLOOM_BITS + 31) / 32)
+
+// "AA:BB:CC:DD:EE:FF" (or '-' separated), case-insensitive
+bool macParse(const char* s, uint8_t* mac);
+
+class AllowList {
+public:
+    AllowList();
+
+    // Load ALLOW_LIST_FILE (SPIFFS must be mounted)
+    bool init();
+
+    // Any task, including the GAP callback; never blocks
+    bool contains(const uint8_t* mac);
+
+    // Commands (one task); changes are saved right away
+    int add(const uint8_t* mac);        // 0 added, 1 already listed, -1 full
+    bool remove(const uint8_t* mac);
+    void clear();
+
+    // Entries are kept sorted
+    int count() { return _count; }
+    const uint8_t* at(int index) { return _macs[index]; }
+
+    // Statistics
+    uint32_t getIgnoredCount() { return _ignored; }
+    uint32_t getFalsePositives() { return _falsePositives; }
+    float getEstimatedFpRate();         // For the current entry count
+    size_t getMemoryBytes() { return sizeof(_bloom) + sizeof(_macs); }
+
+private:
+    uint32_t _bloom[ALLOW_BLOOM_WORDS];
+    uint8_t _macs[ALLOW_LIST_MAX][6];
+    uint8_t _count;
+    std::atomic<uint32_t> _seq;         // Odd while the filter is rebuilt
+
+    uint32_t _ignored;                  // Reports dropped (GAP callback only)
+    uint32_t _falsePositives;           // Filter hits the list didn't confirm
+
+    int find(const uint8_t* mac);       // Index, or -(insert position) - 1
+    void beginWrite();
+    void endWrite();
+    void rebuild();
+    bool save();
+};
+
+// Global allow list instance
+extern AllowList allowList;
+
+#endif // ALLOW_LIST_H
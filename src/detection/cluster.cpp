@@ -0,0 +1,133 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Tracker Clustering Implementation
+ */
+
+#include "cluster.h"
+#include "device_table.h"
+
+// Global instance
+ClusterEngine clusterEngine;
+
+#define APPLE_COMPANY_ID        0x004C
+#define APPLE_TYPE_PAIRING      0x07    // Proximity pairing (unregistered AirTag, AirPods)
+#define APPLE_TYPE_FIND_MY      0x12    // Offline finding
+
+// =============================================================================
+// FINGERPRINT
+// =============================================================================
+static inline uint32_t fpMix(uint32_t h, uint8_t b) {
+    return (h ^ b) * 16777619u;
+}
+
+// Apple packs several type/length/value items into one mfg data field. The
+// Find My public key changes with the address; the status byte (battery,
+// device type) and the pairing model ID do not.
+static uint32_t fpApple(uint32_t h, const uint8_t* data, uint8_t len) {
+    uint8_t pos = 0;
+    while (pos + 2 <= len) {
+        uint8_t type = data[pos];
+        uint8_t itemLen = data[pos + 1];
+        const uint8_t* item = data + pos + 2;
+        if (pos + 2 + itemLen > len) {
+            break;
+        }
+        h = fpMix(fpMix(h, type), itemLen);
+        if (type == APPLE_TYPE_FIND_MY && itemLen >= 1) {
+            h = fpMix(h, item[0]);
+        } else if (type == APPLE_TYPE_PAIRING && itemLen >= 3) {
+            h = fpMix(fpMix(h, item[1]), item[2]);
+        }
+        pos += 2 + itemLen;
+    }
+    return h;
+}
+
+// The layout of the advertisement (AD types and lengths), service UUIDs,
+// the company ID and, where known, vendor fields that survive rotation.
+// Counters, keys and nonces are left out.
+uint32_t clusterFingerprint(int16_t sigIndex, bool randomAddr,
+                            const uint8_t* payload, uint8_t len, const adv_view_t* view) {
+    if (!randomAddr) {
+        return CLUSTER_FP_NONE;
+    }
+
+    uint32_t h = 2166136261u;
+    h = fpMix(fpMix(h, (uint8_t)sigIndex), (uint8_t)(sigIndex >> 8));
+
+    uint8_t pos = 0;
+    while (pos + 2 <= len && payload[pos] != 0) {
+        uint8_t adLen = payload[pos];
+        uint8_t type = payload[pos + 1];
+        if (pos + 1 + adLen > len) {
+            break;
+        }
+        h = fpMix(fpMix(h, type), adLen);
+        if (type == AD_TYPE_SERVICE_DATA16 && adLen >= 3) {
+            h = fpMix(fpMix(h, payload[pos + 2]), payload[pos + 3]);
+        }
+        pos += 1 + adLen;
+    }
+
+    for (uint8_t i = 0; i < view->uuid16Count; i++) {
+        h = fpMix(fpMix(h, (uint8_t)view->uuid16[i]), (uint8_t)(view->uuid16[i] >> 8));
+    }
+    if (advHasMfgData(view)) {
+        h = fpMix(fpMix(h, (uint8_t)view->companyId), (uint8_t)(view->companyId >> 8));
+        if (view->companyId == APPLE_COMPANY_ID) {
+            h = fpApple(h, payload + view->mfgOffset + 2, view->mfgLen - 2);
+        }
+    }
+    return h != CLUSTER_FP_NONE ? h : 1;
+}
+
+// =============================================================================
+// LINKING
+// =============================================================================
+ClusterEngine::ClusterEngine() {
+    _nextId = 0;
+    _links = 0;
+}
+
+uint16_t ClusterEngine::nextId() {
+    if (++_nextId == 0) {
+        _nextId = 1;
+    }
+    return _nextId;
+}
+
+// Candidates must have gone quiet (a live device isn't rotating), must not
+// have been linked very recently (two identical tags would trade places),
+// and keep RSSI within CLUSTER_RSSI_DELTA. The closest RSSI wins; on a tie
+// the one that went quiet last.
+int ClusterEngine::findLink(uint32_t fingerprint, int8_t rssi, uint32_t now) {
+    if (!CLUSTER_ENABLED || fingerprint == CLUSTER_FP_NONE) {
+        return DEVICE_TABLE_NONE;
+    }
+
+    int best = DEVICE_TABLE_NONE;
+    int bestDelta = CLUSTER_RSSI_DELTA + 1;
+    int probed = 0;
+    for (int i = deviceTable.newest(); i != DEVICE_TABLE_NONE && probed < CLUSTER_MAX_PROBE;
+         i = deviceTable.older(i), probed++) {
+        const DetectedDevice* dev = deviceTable.at(i);
+        uint32_t quiet = now - dev->lastSeen;
+        if (quiet > CLUSTER_WINDOW_MS) {
+            break;      // Everything further down is older still
+        }
+        if (quiet < CLUSTER_MIN_GAP_MS || dev->fingerprint != fingerprint) {
+            continue;
+        }
+        // Detail record only for candidates
+        const DeviceDetail* detail = deviceTable.detail(i);
+        if (detail->macCount > 1 && now - detail->lastLinked < CLUSTER_MIN_HOLD_MS) {
+            continue;
+        }
+        int delta = abs(dev->rssi - rssi);
+        if (delta < bestDelta) {
+            best = i;
+            bestDelta = delta;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,53 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Tracker Clustering - Follow devices across address rotation
+ *
+ * Find My and SmartTag trackers switch to a new random address about every
+ * 15 minutes. When a matched device shows up under a MAC that isn't in the
+ * table, the clusterer looks for an entry that went quiet shortly before,
+ * matched the same signature, has the same payload fingerprint (the stable
+ * bytes of its advertisement) and a similar RSSI. If one is found, the new
+ * MAC takes over that entry, which keeps its cluster ID, history and slot.
+ *
+ * Only the most recently seen part of the device table is searched (the
+ * LRU list, newest first, up to CLUSTER_WINDOW_MS back and CLUSTER_MAX_PROBE
+ * entries), so each lookup is bounded and needs no extra memory.
+ */
+
+#ifndef CLUSTER_H
+#define CLUSTER_H
+
+#include <Arduino.h>
+#include "../config.h"
+#include "adv_parser.h"
+
+#define CLUSTER_FP_NONE     0           // Never linked (public address etc.)
+
+// Stable features of an advertisement from a rotating (random) address;
+// CLUSTER_FP_NONE for public addresses
+uint32_t clusterFingerprint(int16_t sigIndex, bool randomAddr,
+                            const uint8_t* payload, uint8_t len, const adv_view_t* view);
+
+class ClusterEngine {
+public:
+    ClusterEngine();
+
+    // Device table index of the entry a new MAC continues, or -1
+    int findLink(uint32_t fingerprint, int8_t rssi, uint32_t now);
+
+    // Cluster ID for a device that starts a new cluster (never 0)
+    uint16_t nextId();
+
+    // Statistics
+    void countLink() { _links++; }
+    uint32_t getLinkCount() { return _links; }
+
+private:
+    uint16_t _nextId;
+    uint32_t _links;
+};
+
+// Global clustering instance
+extern ClusterEngine clusterEngine;
+
+#endif // CLUSTER_H
@@ -0,0 +1,53 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Detection Events Implementation
+ */
+
+#include "det_events.h"
+
+// Global instance
+DetectionEvents detEvents;
+
+DetectionEvents::DetectionEvents() {
+    _queue = nullptr;
+    _consumer = nullptr;
+    _posted = 0;
+    _dropped = 0;
+}
+
+bool DetectionEvents::init() {
+    if (_queue == nullptr) {
+        _queue = xQueueCreate(DET_EVENT_QUEUE_SIZE, sizeof(det_event_t));
+    }
+    return _queue != nullptr;
+}
+
+bool DetectionEvents::post(det_event_type_t type, int index) {
+    if (_queue == nullptr) {
+        return false;
+    }
+    det_event_t ev;
+    ev.type = type;
+    deviceTable.snapshot(index, &ev.snapshot);
+    if (xQueueSend(_queue, &ev, 0) != pdTRUE) {
+        _dropped++;
+        return false;
+    }
+    _posted++;
+    TaskHandle_t consumer = _consumer;
+    if (consumer != nullptr) {
+        xTaskNotifyGive(consumer);
+    }
+    return true;
+}
+
+bool DetectionEvents::receive(det_event_t* out, TickType_t timeout) {
+    if (_queue == nullptr) {
+        return false;
+    }
+    return xQueueReceive(_queue, out, timeout) == pdTRUE;
+}
+
+int DetectionEvents::getQueuedCount() {
+    return _queue != nullptr ? (int)uxQueueMessagesWaiting(_queue) : 0;
+}
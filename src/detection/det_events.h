@@ -0,0 +1,60 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Detection Events - Matcher to serial encoder queue
+ *
+ * The match task never formats output itself: detections and follower
+ * alerts are posted here with a copy of the device as it was at that
+ * moment, and the serial task encodes them. A backed-up UART therefore
+ * only fills this queue; when it is full, events are dropped and counted
+ * instead of stalling the matcher and, behind it, the scan queue.
+ */
+
+#ifndef DET_EVENTS_H
+#define DET_EVENTS_H
+
+#include <Arduino.h>
+#include "../config.h"
+#include "device_table.h"
+
+typedef enum {
+    DET_EVENT_DETECT = 1,               // New device or linked MAC
+    DET_EVENT_FOLLOWER                  // Follower alert
+} det_event_type_t;
+
+typedef struct {
+    uint8_t type;                       // det_event_type_t
+    device_snapshot_t snapshot;         // Both halves of the device
+} det_event_t;
+
+class DetectionEvents {
+public:
+    DetectionEvents();
+
+    bool init();
+
+    // Task notified after each post (the serial task)
+    void setConsumer(TaskHandle_t task) { _consumer = task; }
+
+    // Producer (match task, table locked); copies device table slot index.
+    // Never blocks. Returns false if dropped.
+    bool post(det_event_type_t type, int index);
+
+    // Consumer (serial task); waits up to timeout for the next event
+    bool receive(det_event_t* out, TickType_t timeout);
+
+    // Status
+    uint32_t getPostedCount() { return _posted; }
+    uint32_t getDroppedCount() { return _dropped; }
+    int getQueuedCount();
+
+private:
+    QueueHandle_t _queue;
+    volatile TaskHandle_t _consumer;
+    uint32_t _posted;
+    uint32_t _dropped;
+};
+
+// Global event queue instance
+extern DetectionEvents detEvents;
+
+#endif // DET_EVENTS_H
@@ -0,0 +1,398 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Detection Log Implementation
+ */
+
+#include "det_log.h"
+#include "sig_db.h"
+#include <FS.h>
+#include <SPIFFS.h>
+
+// Global instance
+DetectionLog detLog;
+
+// =============================================================================
+// CONSTRUCTOR
+// =============================================================================
+DetectionLog::DetectionLog() : _pending(-1) {
+    memset(_fill, 0, sizeof(_fill));
+    _active = 0;
+    _activeSince = 0;
+    memset(_segSeq, 0, sizeof(_segSeq));
+    _segment = 0;
+    _segBytes = 0;
+    _boot = 0;
+    _written = 0;
+    _dropped = 0;
+    _flushes = 0;
+    _task = nullptr;
+    _lock = nullptr;
+    _bufLock = nullptr;
+}
+
+// =============================================================================
+// INITIALIZATION
+// =============================================================================
+void DetectionLog::segmentPath(uint8_t segment, char* out, size_t outSize) {
+    snprintf(out, outSize, DET_LOG_FILE_PREFIX "%u.bin", segment);
+}
+
+bool DetectionLog::init() {
+    if (_task != nullptr) {
+        return true;
+    }
+    if (!SPIFFS.begin()) {
+        Serial.println("[LOG] SPIFFS not mounted, detection log disabled");
+        return false;
+    }
+
+    // Find the newest segment; anything unreadable is discarded
+    uint32_t newestSeq = 0;
+    uint32_t newestSize = 0;
+    uint16_t newestBoot = 0;
+    char path[24];
+    for (uint8_t i = 0; i < DET_LOG_SEGMENTS; i++) {
+        segmentPath(i, path, sizeof(path));
+        if (!SPIFFS.exists(path)) {
+            continue;
+        }
+        fs::File f = SPIFFS.open(path, "r");
+        det_log_header_t hdr;
+        bool valid = f && f.read((uint8_t*)&hdr, sizeof(hdr)) == sizeof(hdr) &&
+                     hdr.magic == DET_LOG_MAGIC && hdr.recordSize == sizeof(det_log_record_t);
+        uint32_t size = f ? f.size() : 0;
+        if (f) {
+            f.close();
+        }
+        if (!valid) {
+            SPIFFS.remove(path);
+            continue;
+        }
+        _segSeq[i] = hdr.seq;
+        if (hdr.seq > newestSeq) {
+            newestSeq = hdr.seq;
+            newestSize = size;
+            newestBoot = hdr.boot;
+            _segment = i;
+        }
+    }
+
+    if (newestSeq > 0) {
+        _segBytes = newestSize;
+        if (newestSize % sizeof(det_log_record_t) != 0) {
+            // Torn write at power loss; start a fresh segment rather than misalign
+            _segBytes = DET_LOG_SEGMENT_SIZE;
+        }
+
+        // The boot counter continues from the boot that started the newest
+        // segment, or from its last record if that was written later
+        _boot = newestBoot + 1;
+        uint32_t records = newestSize / sizeof(det_log_record_t);
+        if (records > 1) {
+            segmentPath(_segment, path, sizeof(path));
+            fs::File f = SPIFFS.open(path, "r");
+            det_log_record_t last;
+            if (f && f.seek((records - 1) * sizeof(det_log_record_t)) &&
+                f.read((uint8_t*)&last, sizeof(last)) == sizeof(last) &&
+                (uint16_t)(last.boot - newestBoot) < 0x8000) {
+                _boot = last.boot + 1;
+            }
+            if (f) {
+                f.close();
+            }
+        }
+    }
+
+    _lock = xSemaphoreCreateMutex();
+    _bufLock = xSemaphoreCreateMutex();
+    BaseType_t rc = xTaskCreatePinnedToCore(taskEntry, "det_log",
+                                            TASK_LOG_STACK, this,
+                                            TASK_LOG_PRIORITY, &_task,
+                                            TASK_LOG_CORE);
+    if (rc != pdPASS) {
+        _task = nullptr;
+        Serial.println("[LOG] Failed to create log task");
+        return false;
+    }
+
+    Serial.printf("[LOG] Boot %u, segment %u (%lu bytes)\n", _boot, _segment, _segBytes);
+    return true;
+}
+
+// =============================================================================
+// PRODUCER SIDE
+// =============================================================================
+void DetectionLog::append(const uint8_t* mac, int16_t sigIndex, int8_t rssi, det_log_event_t event) {
+    if (_task == nullptr) {
+        return;
+    }
+    xSemaphoreTake(_bufLock, portMAX_DELAY);
+    if (_fill[_active] >= DET_LOG_BATCH_RECORDS && !handOff()) {
+        _dropped++;     // Both batches full; the writer is behind
+        xSemaphoreGive(_bufLock);
+        return;
+    }
+
+    det_log_record_t* rec = &_buf[_active][_fill[_active]];
+    rec->timestamp = millis();
+    rec->boot = _boot;
+    memcpy(rec->mac, mac, 6);
+    rec->sigId = sigIndex >= 0 ? sigIndex : DET_LOG_SIG_NONE;
+    rec->rssi = rssi;
+    rec->event = event;
+    if (_fill[_active]++ == 0) {
+        _activeSince = rec->timestamp;
+    }
+
+    // High-water mark: a full batch goes out right away
+    if (_fill[_active] >= DET_LOG_BATCH_RECORDS) {
+        handOff();
+    }
+    xSemaphoreGive(_bufLock);
+}
+
+void DetectionLog::poll(uint32_t now) {
+    if (_task == nullptr) {
+        return;
+    }
+    xSemaphoreTake(_bufLock, portMAX_DELAY);
+    if (_fill[_active] > 0 && now - _activeSince >= DET_LOG_FLUSH_MS) {
+        handOff();
+    }
+    xSemaphoreGive(_bufLock);
+}
+
+// Give the active batch to the writer and switch to the other one.
+// Fails if the writer still owns the other batch. Caller holds _bufLock.
+bool DetectionLog::handOff() {
+    if (_fill[_active] == 0) {
+        return true;
+    }
+    if (_pending.load(std::memory_order_acquire) >= 0) {
+        return false;
+    }
+    _pending.store(_active, std::memory_order_release);
+    _active ^= 1;
+    _fill[_active] = 0;
+    xTaskNotifyGive(_task);
+    return true;
+}
+
+void DetectionLog::waitIdle() {
+    while (_pending.load(std::memory_order_acquire) >= 0) {
+        delay(1);
+    }
+}
+
+// =============================================================================
+// WRITER TASK
+// =============================================================================
+void DetectionLog::taskEntry(void* param) {
+    static_cast<DetectionLog*>(param)->run();
+}
+
+void DetectionLog::run() {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        int8_t batch = _pending.load(std::memory_order_acquire);
+        if (batch < 0) {
+            continue;
+        }
+        xSemaphoreTake(_lock, portMAX_DELAY);
+        writeBatch(_buf[batch], _fill[batch]);
+        xSemaphoreGive(_lock);
+        _fill[batch] = 0;
+        _pending.store(-1, std::memory_order_release);
+    }
+}
+
+// Start a new segment after the current one, overwriting the oldest
+bool DetectionLog::rotate() {
+    uint8_t next = _segSeq[_segment] == 0 ? _segment : (_segment + 1) % DET_LOG_SEGMENTS;
+    uint32_t seq = 0;
+    for (uint8_t i = 0; i < DET_LOG_SEGMENTS; i++) {
+        if (_segSeq[i] > seq) {
+            seq = _segSeq[i];
+        }
+    }
+
+    char path[24];
+    segmentPath(next, path, sizeof(path));
+    fs::File f = SPIFFS.open(path, "w");
+    if (!f) {
+        return false;
+    }
+    det_log_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = DET_LOG_MAGIC;
+    hdr.seq = seq + 1;
+    hdr.recordSize = sizeof(det_log_record_t);
+    hdr.boot = _boot;
+    bool ok = f.write((const uint8_t*)&hdr, sizeof(hdr)) == sizeof(hdr);
+    f.close();
+    if (!ok) {
+        return false;
+    }
+
+    _segSeq[next] = hdr.seq;
+    _segment = next;
+    _segBytes = sizeof(hdr);
+    return true;
+}
+
+// Caller holds _lock. The file is reopened per batch so a power loss can
+// at most cost the batch being written.
+void DetectionLog::writeBatch(const det_log_record_t* records, uint16_t count) {
+    size_t bytes = count * sizeof(det_log_record_t);
+    if (count == 0) {
+        return;
+    }
+    if ((_segSeq[_segment] == 0 || _segBytes + bytes > DET_LOG_SEGMENT_SIZE) && !rotate()) {
+        _dropped += count;
+        return;
+    }
+
+    char path[24];
+    segmentPath(_segment, path, sizeof(path));
+    fs::File f = SPIFFS.open(path, "a");
+    if (!f) {
+        _dropped += count;
+        return;
+    }
+    size_t written = f.write((const uint8_t*)records, bytes);
+    f.close();
+
+    _segBytes += written;
+    _written += written / sizeof(det_log_record_t);
+    _dropped += count - written / sizeof(det_log_record_t);
+    _flushes++;
+    if (written != bytes) {
+        _segBytes = DET_LOG_SEGMENT_SIZE;   // Misaligned now; rotate next time
+    }
+}
+
+// =============================================================================
+// COMMANDS
+// =============================================================================
+void DetectionLog::flush() {
+    if (_task == nullptr) {
+        return;
+    }
+    // Hand the active batch over once the writer is free, then wait for it
+    // without holding the producer off
+    for (;;) {
+        xSemaphoreTake(_bufLock, portMAX_DELAY);
+        bool handed = handOff();
+        xSemaphoreGive(_bufLock);
+        if (handed) {
+            break;
+        }
+        delay(1);
+    }
+    waitIdle();
+}
+
+static const char* eventName(uint8_t event, bool json) {
+    switch (event) {
+        case DET_LOG_NEW:       return json ? "new" : "NEW";
+        case DET_LOG_SEEN:      return json ? "seen" : "SEEN";
+        case DET_LOG_LINKED:    return json ? "linked" : "LINK";
+        case DET_LOG_FOLLOWER:  return json ? "follower" : "FOLW";
+        default:                return "?";
+    }
+}
+
+static void printRecord(const det_log_record_t* rec, bool json) {
+    char macStr[18];
+    snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
+             rec->mac[0], rec->mac[1], rec->mac[2], rec->mac[3], rec->mac[4], rec->mac[5]);
+    const char* name = rec->sigId < sigDb.count() ? sigDb.get(rec->sigId)->name : "?";
+
+    if (json) {
+        Serial.printf("{\"event\":\"log\",\"boot\":%u,\"ts\":%lu,\"type\":\"%s\","
+                      "\"device\":\"%s\",\"mac\":\"%s\",\"rssi\":%d}\n",
+                      rec->boot, (unsigned long)rec->timestamp, eventName(rec->event, true),
+                      name, macStr, rec->rssi);
+    } else {
+        Serial.printf("  [boot %u +%lu.%03lus] %-4s %s MAC=%s RSSI=%d\n",
+                      rec->boot, (unsigned long)rec->timestamp / 1000,
+                      (unsigned long)rec->timestamp % 1000,
+                      eventName(rec->event, false), name, macStr, rec->rssi);
+    }
+}
+
+// Prints every record, oldest segment first
+int DetectionLog::dump(bool json) {
+    if (_task == nullptr) {
+        return 0;
+    }
+    flush();
+
+    uint8_t order[DET_LOG_SEGMENTS];
+    uint8_t segCount = 0;
+    for (uint8_t i = 0; i < DET_LOG_SEGMENTS; i++) {
+        if (_segSeq[i] == 0) {
+            continue;
+        }
+        uint8_t pos = segCount++;
+        while (pos > 0 && _segSeq[order[pos - 1]] > _segSeq[i]) {
+            order[pos] = order[pos - 1];
+            pos--;
+        }
+        order[pos] = i;
+    }
+
+    int printed = 0;
+    det_log_record_t chunk[DET_LOG_BATCH_RECORDS];
+    char path[24];
+
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    for (uint8_t s = 0; s < segCount; s++) {
+        segmentPath(order[s], path, sizeof(path));
+        fs::File f = SPIFFS.open(path, "r");
+        if (!f || !f.seek(sizeof(det_log_header_t))) {
+            if (f) {
+                f.close();
+            }
+            continue;
+        }
+        size_t n;
+        while ((n = f.read((uint8_t*)chunk, sizeof(chunk)) / sizeof(det_log_record_t)) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                printRecord(&chunk[i], json);
+                printed++;
+            }
+        }
+        f.close();
+    }
+    xSemaphoreGive(_lock);
+    return printed;
+}
+
+// Drops buffered records and deletes every segment. The producer is only
+// held off while the active batch is dropped; the files are removed under
+// _lock alone, so the matcher keeps appending meanwhile.
+void DetectionLog::clear() {
+    if (_task == nullptr) {
+        return;
+    }
+    xSemaphoreTake(_bufLock, portMAX_DELAY);
+    _fill[_active] = 0;
+    xSemaphoreGive(_bufLock);
+
+    // A batch the writer already owns goes into the files removed below
+    waitIdle();
+
+    char path[24];
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    for (uint8_t i = 0; i < DET_LOG_SEGMENTS; i++) {
+        segmentPath(i, path, sizeof(path));
+        if (SPIFFS.exists(path)) {
+            SPIFFS.remove(path);
+        }
+        _segSeq[i] = 0;
+    }
+    _segment = 0;
+    _segBytes = 0;
+    xSemaphoreGive(_lock);
+}
@@ -0,0 +1,118 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Detection Log - Append-only journal on SPIFFS
+ *
+ * Detections are appended as fixed-size records to a RAM batch by the matcher;
+ * full batches (or batches older than DET_LOG_FLUSH_MS) are handed to a
+ * low-priority writer task, so flash writes never run on the scan path.
+ * The journal rotates over DET_LOG_SEGMENTS files; when the newest one is
+ * full the oldest is overwritten.
+ */
+
+#ifndef DET_LOG_H
+#define DET_LOG_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "../config.h"
+
+// =============================================================================
+// ON-FLASH FORMAT
+// =============================================================================
+#define DET_LOG_MAGIC       0x31474C44  // "DLG1"
+#define DET_LOG_SIG_NONE    0xFFFF
+
+typedef enum {
+    DET_LOG_NEW  = 1,                   // First sighting since boot/eviction
+    DET_LOG_SEEN = 2,                   // Still present (every DET_LOG_RESIGHT_MS)
+    DET_LOG_LINKED = 3,                 // New MAC continuing a known device (cluster.h)
+    DET_LOG_FOLLOWER = 4                // Follower alert (rssi_track.h)
+} det_log_event_t;
+
+// Each segment starts with this header, padded to one record
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint32_t seq;                       // Increases with every rotation
+    uint16_t recordSize;
+    uint16_t boot;                      // Boot that started the segment
+    uint8_t reserved[4];
+} det_log_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp;                 // millis() since boot
+    uint16_t boot;                      // Boot counter, orders records across resets
+    uint8_t mac[6];
+    uint16_t sigId;                     // sigDb index at the time, or DET_LOG_SIG_NONE
+    int8_t rssi;
+    uint8_t event;                      // det_log_event_t
+} det_log_record_t;
+
+static_assert(sizeof(det_log_header_t) == sizeof(det_log_record_t), "Header must fill one record");
+static_assert(DET_LOG_BATCH_BYTES % sizeof(det_log_record_t) == 0, "Batch must hold whole records");
+static_assert(DET_LOG_SEGMENT_SIZE % DET_LOG_BATCH_BYTES == 0, "Segment must hold whole batches");
+
+#define DET_LOG_BATCH_RECORDS   (DET_LOG_BATCH_BYTES / sizeof(det_log_record_t))
+
+// =============================================================================
+// DETECTION LOG CLASS
+// =============================================================================
+class DetectionLog {
+public:
+    DetectionLog();
+
+    // Scan the segments and start the writer task (SPIFFS must be mounted)
+    bool init();
+
+    // Producer side; never touches flash
+    void append(const uint8_t* mac, int16_t sigIndex, int8_t rssi, det_log_event_t event);
+    void poll(uint32_t now);            // Hands over a batch older than DET_LOG_FLUSH_MS
+
+    // Commands; these wait for pending writes, but hold the producer off
+    // only while the batches change hands, never during flash work
+    void flush();
+    int dump(bool json);                // Returns the number of records printed
+    void clear();
+
+    // Status
+    bool isReady() { return _task != nullptr; }
+    uint32_t getWrittenCount() { return _written; }
+    uint32_t getDroppedCount() { return _dropped; }
+    uint32_t getFlushCount() { return _flushes; }
+    uint16_t getBufferedCount() { return _fill[_active]; }
+    uint16_t getBootId() { return _boot; }
+    uint8_t getSegment() { return _segment; }
+    uint32_t getSegmentBytes() { return _segBytes; }
+
+private:
+    det_log_record_t _buf[2][DET_LOG_BATCH_RECORDS];
+    uint16_t _fill[2];
+    uint8_t _active;                    // Batch being filled by the matcher
+    std::atomic<int8_t> _pending;       // Batch owned by the writer, or -1
+    uint32_t _activeSince;              // millis() of the first record in the active batch
+
+    uint32_t _segSeq[DET_LOG_SEGMENTS]; // 0 = segment empty
+    uint8_t _segment;                   // Segment being appended to
+    uint32_t _segBytes;                 // Its size, header included
+    uint16_t _boot;
+
+    uint32_t _written;
+    uint32_t _dropped;
+    uint32_t _flushes;
+
+    TaskHandle_t _task;
+    SemaphoreHandle_t _lock;            // Held by whoever touches the files
+    SemaphoreHandle_t _bufLock;         // Producer side vs. commands
+
+    static void taskEntry(void* param);
+    void run();
+    bool handOff();
+    void waitIdle();
+    void writeBatch(const det_log_record_t* records, uint16_t count);
+    bool rotate();
+    void segmentPath(uint8_t segment, char* out, size_t outSize);
+};
+
+// Global detection log instance
+extern DetectionLog detLog;
+
+#endif // DET_LOG_H
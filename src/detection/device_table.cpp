@@ -0,0 +1,216 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Device Table Implementation
+ */
+
+#include "device_table.h"
+
+// Global instance
+DeviceTable deviceTable;
+
+#define HASH_MASK   (DEVICE_TABLE_HASH_SIZE - 1)
+
+// =============================================================================
+// CONSTRUCTOR
+// =============================================================================
+DeviceTable::DeviceTable() {
+    _evictedCount = 0;
+    _version = 0;
+    _lock = nullptr;
+    _details = nullptr;
+    _detailPsram = false;
+    clear();
+}
+
+bool DeviceTable::init() {
+    if (_lock == nullptr) {
+        _lock = xSemaphoreCreateMutex();
+    }
+    if (_details == nullptr) {
+#if DEVICE_DETAIL_PSRAM
+        if (psramFound()) {
+            _details = (DeviceDetail*)ps_calloc(DETECTED_DEVICES_MAX, sizeof(DeviceDetail));
+            _detailPsram = (_details != nullptr);
+        }
+#endif
+        if (_details == nullptr) {
+            _details = (DeviceDetail*)calloc(DETECTED_DEVICES_MAX, sizeof(DeviceDetail));
+        }
+        if (_details == nullptr) {
+            Serial.printf("[DEV] Cannot allocate %u bytes of device details\n",
+                          (unsigned)getDetailBytes());
+            return false;
+        }
+    }
+    return true;
+}
+
+void DeviceTable::snapshot(int index, device_snapshot_t* out) {
+    out->dev = _devices[index];
+    out->detail = _details[index];
+}
+
+void DeviceTable::clear() {
+    memset(_devices, 0, sizeof(_devices));
+    if (_details != nullptr) {
+        memset(_details, 0, getDetailBytes());
+    }
+    for (int i = 0; i < DEVICE_TABLE_HASH_SIZE; i++) {
+        _hash[i] = DEVICE_TABLE_NONE;
+    }
+    _lruHead = DEVICE_TABLE_NONE;
+    _lruTail = DEVICE_TABLE_NONE;
+    _count = 0;
+    _version++;
+}
+
+// =============================================================================
+// LOOKUP
+// =============================================================================
+uint16_t DeviceTable::hashMac(const uint8_t* mac) {
+    // Random/rotating addresses vary most in the low octets
+    uint32_t key = ((uint32_t)mac[2] << 24) | ((uint32_t)mac[3] << 16) |
+                   ((uint32_t)mac[4] << 8) | mac[5];
+    key ^= ((uint32_t)mac[0] << 8) | mac[1];
+    return (uint16_t)((key * 2654435761u) >> 16) & HASH_MASK;
+}
+
+// Bucket holding mac, or the empty bucket where it would be inserted
+int DeviceTable::findBucket(const uint8_t* mac) {
+    int b = hashMac(mac);
+    while (_hash[b] != DEVICE_TABLE_NONE) {
+        if (memcmp(_devices[_hash[b]].mac, mac, 6) == 0) {
+            return b;
+        }
+        b = (b + 1) & HASH_MASK;
+    }
+    return b;
+}
+
+int DeviceTable::find(const uint8_t* mac) {
+    return _hash[findBucket(mac)];
+}
+
+// =============================================================================
+// HASH INDEX MAINTENANCE
+// =============================================================================
+void DeviceTable::hashInsert(int index) {
+    _hash[findBucket(_devices[index].mac)] = index;
+}
+
+// Linear probing removal with backward shift, so no tombstones build up
+void DeviceTable::hashRemove(int index) {
+    int i = findBucket(_devices[index].mac);
+    if (_hash[i] != index) {
+        return;
+    }
+
+    int j = i;
+    for (;;) {
+        j = (j + 1) & HASH_MASK;
+        if (_hash[j] == DEVICE_TABLE_NONE) {
+            break;
+        }
+        // Move j back into the hole unless its home bucket lies in (i, j]
+        int home = hashMac(_devices[_hash[j]].mac);
+        bool homeBetween = (i <= j) ? (home > i && home <= j) : (home > i || home <= j);
+        if (!homeBetween) {
+            _hash[i] = _hash[j];
+            i = j;
+        }
+    }
+    _hash[i] = DEVICE_TABLE_NONE;
+}
+
+// =============================================================================
+// LRU LIST
+// =============================================================================
+void DeviceTable::lruUnlink(int index) {
+    int16_t prev = _lruPrev[index];
+    int16_t next = _lruNext[index];
+    if (prev != DEVICE_TABLE_NONE) _lruNext[prev] = next;
+    else _lruHead = next;
+    if (next != DEVICE_TABLE_NONE) _lruPrev[next] = prev;
+    else _lruTail = prev;
+}
+
+void DeviceTable::lruPushHead(int index) {
+    _lruPrev[index] = DEVICE_TABLE_NONE;
+    _lruNext[index] = _lruHead;
+    if (_lruHead != DEVICE_TABLE_NONE) _lruPrev[_lruHead] = index;
+    else _lruTail = index;
+    _lruHead = index;
+}
+
+// =============================================================================
+// UPDATES
+// =============================================================================
+int DeviceTable::insert(const uint8_t* mac, uint32_t now) {
+    if (_details == nullptr) {
+        return DEVICE_TABLE_NONE;
+    }
+
+    int index;
+    if (_count < DETECTED_DEVICES_MAX) {
+        index = _count++;
+    } else {
+        // Reuse the least recently seen slot
+        index = _lruTail;
+        hashRemove(index);
+        lruUnlink(index);
+        _evictedCount++;
+    }
+
+    DetectedDevice* dev = &_devices[index];
+    memset(dev, 0, sizeof(*dev));
+    memcpy(dev->mac, mac, 6);
+    dev->lastSeen = now;
+    dev->flags = DEVICE_FLAG_ACTIVE;
+
+    DeviceDetail* detail = &_details[index];
+    memset(detail, 0, sizeof(*detail));
+    detail->firstSeen = now;
+
+    hashInsert(index);
+    lruPushHead(index);
+    _version++;
+    return index;
+}
+
+void DeviceTable::touch(int index, uint32_t now) {
+    DetectedDevice* dev = &_devices[index];
+    dev->lastSeen = now;
+    if (!dev->isActive()) {
+        dev->flags |= DEVICE_FLAG_ACTIVE;
+        _version++;
+    }
+    if (_lruHead != index) {
+        lruUnlink(index);
+        lruPushHead(index);
+    }
+}
+
+void DeviceTable::rekey(int index, const uint8_t* mac) {
+    hashRemove(index);
+    memcpy(_devices[index].mac, mac, 6);
+    hashInsert(index);
+    _version++;
+}
+
+int DeviceTable::expire(uint32_t now) {
+    int expired = 0;
+    // The LRU tail is the oldest sighting; stop at the first recent device
+    for (int16_t i = _lruTail; i != DEVICE_TABLE_NONE; i = _lruPrev[i]) {
+        if (now - _devices[i].lastSeen < DEVICE_INACTIVE_SEC * 1000UL) {
+            break;
+        }
+        if (_devices[i].isActive()) {
+            _devices[i].flags &= ~DEVICE_FLAG_ACTIVE;
+            expired++;
+        }
+    }
+    if (expired > 0) {
+        _version++;
+    }
+    return expired;
+}
@@ -0,0 +1,188 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Device Table - Detected device storage
+ *
+ * Fixed-capacity table of detected devices with an open-addressing hash index
+ * on the MAC address and an LRU list ordered by last sighting. Devices occupy
+ * slots 0..count()-1 contiguously; when the table is full a new device takes
+ * over the slot of the least recently seen one.
+ *
+ * Each slot is split in two: a small hot record in internal RAM that the
+ * per-advertisement paths and the list walks touch, and a detail record
+ * (payload, RSSI track, history) at the same index in a separate array,
+ * allocated from PSRAM when there is some (DEVICE_DETAIL_PSRAM). Without
+ * PSRAM the detail array comes from the internal heap.
+ *
+ * The match task is the only writer. Other tasks lock the table, copy what
+ * they need and unlock before drawing or printing, so readers never hold
+ * the matcher up for longer than a copy. count() and getVersion() are
+ * single word reads and may be used without the lock as change hints.
+ */
+
+#ifndef DEVICE_TABLE_H
+#define DEVICE_TABLE_H
+
+#include <Arduino.h>
+#include "../config.h"
+#include "adv_parser.h"
+#include "rssi_track.h"
+#include "sig_db.h"
+
+// =============================================================================
+// DETECTED DEVICE
+// =============================================================================
+// Hot record: what the matcher, the expiry walk, the cluster probe and the
+// scan list read for every device. Name, company ID and threat level come
+// from the signature (deviceSignature()).
+#define DEVICE_FLAG_ACTIVE      0x01        // Seen within DEVICE_INACTIVE_SEC
+#define DEVICE_FLAG_FOLLOWER    0x02        // Mirrors DeviceDetail::track.follower
+
+struct DetectedDevice {
+    uint8_t mac[6];
+    int8_t rssi;                            // Filtered (track.est), dBm
+    uint8_t category;
+    int16_t sigIndex;                       // Matched signature (sigDb index)
+    uint8_t flags;                          // DEVICE_FLAG_*
+    uint8_t reserved;
+    uint32_t lastSeen;
+    uint32_t payloadHash;                   // matchCacheHash() of payload
+    uint32_t fingerprint;                   // clusterFingerprint(), stable across rotation
+
+    bool isActive() const { return flags & DEVICE_FLAG_ACTIVE; }
+    bool isFollower() const { return flags & DEVICE_FLAG_FOLLOWER; }
+};
+
+static_assert(sizeof(DetectedDevice) <= 24, "DetectedDevice grew past its budget");
+
+// Cold record: history, last payload and cluster state, read per sighting
+// of one device or by the detail screen and the encoders. Kept in a
+// separate array that lives in PSRAM when the board has it.
+struct DeviceDetail {
+    uint32_t firstSeen;
+    uint32_t lastLogged;                    // millis() of the last log record
+    uint32_t lastLinked;                    // millis() the current MAC was linked
+    uint16_t detectionCount;
+    uint16_t clusterId;                     // Same physical device across MACs
+    uint8_t macCount;                       // Addresses seen for this cluster
+    uint8_t payloadLen;                     // Last advertising payload seen
+    uint8_t payload[ADV_RECORD_PAYLOAD_MAX];
+    adv_view_t view;                        // Parsed view of payload
+    rssi_track_t track;                     // RSSI estimate, trend and dwell time
+};
+
+// Both halves of a device, copied under the lock
+typedef struct {
+    DetectedDevice dev;
+    DeviceDetail detail;
+} device_snapshot_t;
+
+// Signature of a device in the table (always matched)
+inline const device_signature_t* deviceSignature(const DetectedDevice* dev) {
+    return sigDb.get(dev->sigIndex);
+}
+
+// =============================================================================
+// HASH INDEX SIZING
+// =============================================================================
+// At least twice the capacity, rounded up to a power of two, so probe
+// sequences stay short at full load
+constexpr uint16_t deviceTableHashSize(uint16_t capacity) {
+    uint16_t size = 1;
+    while (size < capacity * 2) {
+        size <<= 1;
+    }
+    return size;
+}
+
+#define DEVICE_TABLE_HASH_SIZE  deviceTableHashSize(DETECTED_DEVICES_MAX)
+#define DEVICE_TABLE_NONE       (-1)
+
+static_assert(DETECTED_DEVICES_MAX > 0 && DETECTED_DEVICES_MAX <= 16384,
+              "DETECTED_DEVICES_MAX out of range");
+
+// =============================================================================
+// DEVICE TABLE CLASS
+// =============================================================================
+class DeviceTable {
+public:
+    DeviceTable();
+
+    // Creates the lock and allocates the detail array (call from setup,
+    // before the tasks start). False if the details could not be allocated;
+    // insert() then refuses new devices.
+    bool init();
+    void lock() { xSemaphoreTake(_lock, portMAX_DELAY); }
+    void unlock() { xSemaphoreGive(_lock); }
+
+    // Lookup
+    int find(const uint8_t* mac);
+    DetectedDevice* at(int index) { return &_devices[index]; }
+    DeviceDetail* detail(int index) { return &_details[index]; }
+    void snapshot(int index, device_snapshot_t* out);
+    int count() { return _count; }
+    static constexpr int capacity() { return DETECTED_DEVICES_MAX; }
+
+    // Returns the slot for a new device with mac set and other fields zeroed
+    // (both halves), evicting the least recently seen device if the table is
+    // full; DEVICE_TABLE_NONE if init() could not allocate the details
+    int insert(const uint8_t* mac, uint32_t now);
+
+    // Record a sighting: refreshes lastSeen, the active flag and LRU position
+    void touch(int index, uint32_t now);
+
+    // Move a device to a new address (tracker rotated its MAC)
+    void rekey(int index, const uint8_t* mac);
+
+    // Walk by last sighting, newest first; DEVICE_TABLE_NONE ends the walk
+    int newest() { return _lruHead; }
+    int older(int index) { return _lruNext[index]; }
+
+    // Clear the active flag on devices not seen for DEVICE_INACTIVE_SEC.
+    // Returns the number of devices that became inactive.
+    int expire(uint32_t now);
+
+    void clear();
+
+    // Statistics
+    uint32_t getEvictedCount() { return _evictedCount; }
+    uint32_t getVersion() { return _version; }     // Bumps on add/evict/expire
+    bool isDetailInPsram() { return _detailPsram; }
+    static constexpr size_t getHotBytes() { return sizeof(DetectedDevice) * DETECTED_DEVICES_MAX; }
+    static constexpr size_t getDetailBytes() { return sizeof(DeviceDetail) * DETECTED_DEVICES_MAX; }
+
+private:
+    DetectedDevice _devices[DETECTED_DEVICES_MAX];
+    DeviceDetail* _details;                     // DETECTED_DEVICES_MAX, from init()
+    bool _detailPsram;
+    int16_t _hash[DEVICE_TABLE_HASH_SIZE];      // Device index per bucket
+    int16_t _lruPrev[DETECTED_DEVICES_MAX];     // Towards most recent
+    int16_t _lruNext[DETECTED_DEVICES_MAX];     // Towards least recent
+    int16_t _lruHead;                           // Most recently seen
+    int16_t _lruTail;                           // Least recently seen
+    int _count;
+    uint32_t _evictedCount;
+    uint32_t _version;
+    SemaphoreHandle_t _lock;
+
+    // Internal methods
+    static uint16_t hashMac(const uint8_t* mac);
+    int findBucket(const uint8_t* mac);
+    void hashInsert(int index);
+    void hashRemove(int index);
+    void lruUnlink(int index);
+    void lruPushHead(int index);
+};
+
+// Global device table instance
+extern DeviceTable deviceTable;
+
+// Holds the device table lock for the enclosing scope
+class DeviceTableLock {
+public:
+    DeviceTableLock() { deviceTable.lock(); }
+    ~DeviceTableLock() { deviceTable.unlock(); }
+    DeviceTableLock(const DeviceTableLock&) = delete;
+    DeviceTableLock& operator=(const DeviceTableLock&) = delete;
+};
+
+#endif // DEVICE_TABLE_H
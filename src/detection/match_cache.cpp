@@ -0,0 +1,43 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Match Cache Implementation
+ */
+
+#include "match_cache.h"
+
+// Global instance
+MatchCache matchCache;
+
+MatchCache::MatchCache() {
+    clear();
+    _knownHits = 0;
+    _unmatchedHits = 0;
+    _misses = 0;
+}
+
+// The low address bytes vary the most, random addresses included
+match_cache_entry_t* MatchCache::slotFor(const uint8_t* mac) {
+    uint32_t key = ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | mac[5];
+    return &_entries[(key * 2654435761u) >> 16 & (MATCH_CACHE_SIZE - 1)];
+}
+
+bool MatchCache::isUnmatched(const uint8_t* mac, uint32_t payloadHash) {
+    const match_cache_entry_t* e = slotFor(mac);
+    if (e->used && e->payloadHash == payloadHash && memcmp(e->mac, mac, 6) == 0) {
+        _unmatchedHits++;
+        return true;
+    }
+    return false;
+}
+
+// A colliding advertiser simply takes over the slot
+void MatchCache::storeUnmatched(const uint8_t* mac, uint32_t payloadHash) {
+    match_cache_entry_t* e = slotFor(mac);
+    memcpy(e->mac, mac, 6);
+    e->payloadHash = payloadHash;
+    e->used = true;
+}
+
+void MatchCache::clear() {
+    memset(_entries, 0, sizeof(_entries));
+}
@@ -0,0 +1,64 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Match Cache - Skip matching for repeated advertisements
+ *
+ * Stationary devices repeat the same payload several times per second. A
+ * known device whose payload hash is unchanged (DetectedDevice::payloadHash)
+ * only needs its RSSI and lastSeen refreshed. Payloads that matched nothing
+ * are remembered here in a direct-mapped table keyed by MAC, so the next
+ * identical report from that advertiser is dropped without matching.
+ */
+
+#ifndef MATCH_CACHE_H
+#define MATCH_CACHE_H
+
+#include <Arduino.h>
+#include "../config.h"
+
+static_assert((MATCH_CACHE_SIZE & (MATCH_CACHE_SIZE - 1)) == 0,
+              "MATCH_CACHE_SIZE must be a power of two");
+
+// FNV-1a over the payload, seeded with its length
+inline uint32_t matchCacheHash(const uint8_t* payload, size_t len) {
+    uint32_t h = 2166136261u ^ (uint32_t)len;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ payload[i]) * 16777619u;
+    }
+    return h;
+}
+
+typedef struct {
+    uint8_t mac[6];
+    bool used;
+    uint32_t payloadHash;
+} match_cache_entry_t;
+
+class MatchCache {
+public:
+    MatchCache();
+
+    // True if mac last sent this payload and it matched no signature
+    bool isUnmatched(const uint8_t* mac, uint32_t payloadHash);
+    void storeUnmatched(const uint8_t* mac, uint32_t payloadHash);
+    void clear();
+
+    // Statistics
+    void countKnownHit() { _knownHits++; }
+    void countMiss() { _misses++; }
+    uint32_t getKnownHits() { return _knownHits; }
+    uint32_t getUnmatchedHits() { return _unmatchedHits; }
+    uint32_t getMisses() { return _misses; }
+
+private:
+    match_cache_entry_t _entries[MATCH_CACHE_SIZE];
+    uint32_t _knownHits;                // Known device, payload unchanged
+    uint32_t _unmatchedHits;            // Unmatched payload repeated
+    uint32_t _misses;                   // Went through the matcher
+
+    match_cache_entry_t* slotFor(const uint8_t* mac);
+};
+
+// Global cache instance
+extern MatchCache matchCache;
+
+#endif // MATCH_CACHE_H
@@ -0,0 +1,259 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Signature Matcher Implementation
+ */
+
+#include "matcher.h"
+#include <string.h>
+#include <ctype.h>
+
+// =============================================================================
+// FIELD HELPERS
+// =============================================================================
+// Case-insensitive "needle occurs in haystack" without building copies
+static bool containsIgnoreCase(const char* hay, size_t hayLen, const char* needle, size_t needleLen) {
+    if (needleLen == 0 || needleLen > hayLen) {
+        return needleLen == 0;
+    }
+    for (size_t i = 0; i + needleLen <= hayLen; i++) {
+        size_t j = 0;
+        while (j < needleLen && tolower((uint8_t)hay[i + j]) == tolower((uint8_t)needle[j])) {
+            j++;
+        }
+        if (j == needleLen) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Search for a byte pattern anywhere in the payload
+static bool findPattern(const uint8_t* data, size_t dataLen, const uint8_t* pattern, size_t patternLen) {
+    if (patternLen > dataLen) {
+        return false;
+    }
+    const uint8_t* p = data;
+    const uint8_t* last = data + (dataLen - patternLen);
+    while (p <= last) {
+        p = (const uint8_t*)memchr(p, pattern[0], last - p + 1);
+        if (p == nullptr) {
+            return false;
+        }
+        if (memcmp(p, pattern, patternLen) == 0) {
+            return true;
+        }
+        p++;
+    }
+    return false;
+}
+
+// =============================================================================
+// PAYLOAD SCAN
+// =============================================================================
+// One pass over the payload resolves every compiled pattern (see
+// sig_index.h) into a bit per signature
+static void scanPayload(const sig_table_t* table, const uint8_t* payload, size_t payloadLen,
+                        uint32_t* hits) {
+    const sig_index_t* index = table->index;
+
+    if (index->shiftEnd != 0) {
+        uint64_t state = 0;
+        uint64_t found = 0;
+        for (size_t i = 0; i < payloadLen; i++) {
+            state = ((state << 1) | index->shiftStart) & index->shiftMask[index->shiftClass[payload[i]]];
+            found |= state & index->shiftEnd;
+        }
+        while (found != 0) {
+            int16_t si = index->shiftSig[__builtin_ctzll(found)];
+            hits[si >> 5] |= (uint32_t)1 << (si & 31);
+            found &= found - 1;
+        }
+    }
+
+    for (uint8_t a = 0; a < index->anchorCount; a++) {
+        uint8_t offset = index->anchorOffset[a];
+        if (offset >= payloadLen) {
+            continue;
+        }
+        int16_t head = index->anchorHead[sigIndexHashAnchor(offset, payload[offset])];
+        for (int16_t si = head; si != SIG_INDEX_NONE; si = index->anchorNext[si]) {
+            const device_signature_t* sig = table->sigs[si];
+            if ((uint8_t)sig->pattern_offset == offset &&
+                offset + (size_t)sig->pattern_length <= payloadLen &&
+                memcmp(payload + offset, sig->payload_pattern, sig->pattern_length) == 0) {
+                hits[si >> 5] |= (uint32_t)1 << (si & 31);
+            }
+        }
+    }
+}
+
+// =============================================================================
+// SIGNATURE EVALUATION
+// =============================================================================
+typedef struct {
+    const uint8_t* payload;
+    size_t payloadLen;
+    const adv_view_t* view;
+    const uint32_t* compiled;           // Patterns resolved by scanPayload()
+    const uint32_t* hits;               // Its result
+} match_input_t;
+
+static bool signatureMatches(int16_t si, const device_signature_t* sig, const match_input_t* in) {
+    const adv_view_t* view = in->view;
+    bool matched = false;
+
+    // Company ID matching
+    if ((sig->flags & SIG_FLAG_COMPANY_ID) && advHasMfgData(view)) {
+        if (sig->company_id == view->companyId) {
+            matched = true;
+        }
+    }
+
+    // 16-bit Service UUID matching (any advertised UUID)
+    if ((sig->flags & SIG_FLAG_SERVICE_UUID) && sig->service_uuid != 0 &&
+        !(sig->flags & SIG_FLAG_EXACT_MATCH)) {
+        for (uint8_t i = 0; i < view->uuid16Count; i++) {
+            if (view->uuid16[i] == sig->service_uuid) {
+                matched = true;
+                break;
+            }
+        }
+    }
+
+    // 128-bit Service UUID matching (any advertised UUID)
+    if ((sig->flags & SIG_FLAG_SERVICE_UUID_128) && !(sig->flags & SIG_FLAG_EXACT_MATCH) &&
+        !sigIndexUuid128Empty(sig->service_uuid_128)) {
+        for (uint8_t i = 0; i < view->uuid128Count; i++) {
+            if (memcmp(sig->service_uuid_128, advUuid128(view, in->payload, i), 16) == 0) {
+                matched = true;
+                break;
+            }
+        }
+    }
+
+    // Device name pattern matching (case-insensitive contains, either way)
+    if ((sig->flags & SIG_FLAG_NAME_PATTERN) && advHasName(view)) {
+        const char* name = advName(view, in->payload);
+        size_t sigNameLen = strnlen(sig->name, sizeof(sig->name));
+        if (containsIgnoreCase(name, view->nameLen, sig->name, sigNameLen) ||
+            containsIgnoreCase(sig->name, sigNameLen, name, view->nameLen)) {
+            if (!(sig->flags & SIG_FLAG_EXACT_MATCH)) {
+                matched = true;
+            }
+        }
+    }
+
+    // Payload pattern matching
+    if ((sig->flags & SIG_FLAG_PAYLOAD) && sig->pattern_length > 0) {
+        bool patternFound = false;
+
+        if (sigIndexBitTest(in->compiled, si)) {
+            patternFound = sigIndexBitTest(in->hits, si);
+        } else if (sig->pattern_offset >= 0) {
+            // Match at specific offset
+            if ((size_t)(sig->pattern_offset + sig->pattern_length) <= in->payloadLen) {
+                patternFound = memcmp(in->payload + sig->pattern_offset,
+                                      sig->payload_pattern, sig->pattern_length) == 0;
+            }
+        } else {
+            // Search anywhere in payload
+            patternFound = findPattern(in->payload, in->payloadLen,
+                                       sig->payload_pattern, sig->pattern_length);
+        }
+
+        if (sig->flags & SIG_FLAG_EXACT_MATCH) {
+            matched = matched && patternFound;
+        } else {
+            matched = matched || patternFound;
+        }
+    }
+
+    return matched;
+}
+
+// =============================================================================
+// INDEXED MATCHING
+// =============================================================================
+// Candidates are evaluated from every applicable chain; the lowest signature
+// index that matches wins, which preserves the table-order priority.
+typedef struct {
+    const sig_table_t* table;
+    const match_input_t* in;
+    int best;
+} match_state_t;
+
+static void evaluateChain(match_state_t* st, const int16_t* next, int16_t head) {
+    for (int16_t i = head; i != SIG_INDEX_NONE; i = next[i]) {
+        if (st->best != SIG_INDEX_NONE && i >= st->best) {
+            return;  // Chains are ascending; nothing better remains
+        }
+        if (signatureMatches(i, st->table->sigs[i], st->in)) {
+            st->best = i;
+            return;
+        }
+    }
+}
+
+static void evaluateList(match_state_t* st, const int16_t* list, uint16_t count) {
+    for (uint16_t n = 0; n < count; n++) {
+        int16_t i = list[n];
+        if (st->best != SIG_INDEX_NONE && i >= st->best) {
+            return;
+        }
+        if (signatureMatches(i, st->table->sigs[i], st->in)) {
+            st->best = i;
+            return;
+        }
+    }
+}
+
+// Signatures whose compiled pattern was found, ascending
+static void evaluateHits(match_state_t* st, const uint32_t* candidate, const uint32_t* hits) {
+    for (int w = 0; w < SIG_INDEX_SIG_WORDS; w++) {
+        uint32_t bits = candidate[w] & hits[w];
+        while (bits != 0) {
+            int16_t i = (int16_t)(w * 32 + __builtin_ctz(bits));
+            if (st->best != SIG_INDEX_NONE && i >= st->best) {
+                return;
+            }
+            if (signatureMatches(i, st->table->sigs[i], st->in)) {
+                st->best = i;
+                return;
+            }
+            bits &= bits - 1;
+        }
+    }
+}
+
+const device_signature_t* matchSignatureIn(const sig_table_t* table,
+                                           const uint8_t* payload, size_t payloadLen,
+                                           const adv_view_t* view, int16_t* outIndex) {
+    const sig_index_t* index = table->index;
+
+    uint32_t hits[SIG_INDEX_SIG_WORDS] = {};
+    scanPayload(table, payload, payloadLen, hits);
+
+    match_input_t in = { payload, payloadLen, view, index->payloadCompiled, hits };
+    match_state_t st = { table, &in, SIG_INDEX_NONE };
+
+    if (advHasMfgData(view)) {
+        evaluateChain(&st, index->companyNext, index->companyHead[sigIndexHash16(view->companyId)]);
+    }
+    for (uint8_t i = 0; i < view->uuid16Count; i++) {
+        evaluateChain(&st, index->uuid16Next, index->uuid16Head[sigIndexHash16(view->uuid16[i])]);
+    }
+    for (uint8_t i = 0; i < view->uuid128Count; i++) {
+        evaluateChain(&st, index->uuid128Next,
+                      index->uuid128Head[sigIndexHash128(advUuid128(view, payload, i))]);
+    }
+    if (advHasName(view)) {
+        evaluateList(&st, index->nameList, index->nameCount);
+    }
+    evaluateHits(&st, index->payloadCandidate, hits);
+    evaluateList(&st, index->payloadList, index->payloadCount);
+
+    if (outIndex != nullptr) {
+        *outIndex = (int16_t)st.best;
+    }
+    return st.best != SIG_INDEX_NONE ? table->sigs[st.best] : nullptr;
+}
@@ -0,0 +1,38 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Signature Matcher
+ *
+ * Matches parsed advertising payloads against a signature table through its
+ * signature index. The matcher only deals in plain bytes and tables, so it
+ * also builds on the host (see the native env and bench/).
+ */
+
+#ifndef MATCHER_H
+#define MATCHER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "signatures.h"
+#include "sig_index.h"
+#include "adv_parser.h"
+
+// Signatures in priority order together with the index built over them
+typedef struct {
+    const device_signature_t* const* sigs;
+    uint16_t count;
+    const sig_index_t* index;
+} sig_table_t;
+
+// Returns the first signature (in table order) matching the payload, or nullptr.
+// view must come from advParse() on the same payload. If outIndex is given it
+// receives the signature's position in the table, SIG_INDEX_NONE if none.
+const device_signature_t* matchSignatureIn(const sig_table_t* table,
+                                           const uint8_t* payload, size_t payloadLen,
+                                           const adv_view_t* view, int16_t* outIndex = nullptr);
+
+// Same, against the signature database (builtin + SPIFFS, see sig_db.h); the
+// index is the one sigDb.get() takes
+const device_signature_t* matchSignature(const uint8_t* payload, size_t payloadLen,
+                                         const adv_view_t* view, int16_t* outIndex = nullptr);
+
+#endif // MATCHER_H
@@ -0,0 +1,80 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * RSSI Tracking Implementation
+ */
+
+#include "rssi_track.h"
+#include <string.h>
+
+#define FOLLOWER_DWELL_MS   (FOLLOWER_DWELL_MIN * 60000UL)
+
+static void pushSample(rssi_track_t* t, uint32_t now) {
+    rssi_sample_t* s = &t->ring[t->ringHead];
+    s->sec = (uint16_t)(now / 1000);
+    s->rssi = rssiTrackValue(t);
+    t->ringHead = (t->ringHead + 1) % RSSI_TRACK_RING;
+    if (t->ringCount < RSSI_TRACK_RING) {
+        t->ringCount++;
+    }
+    t->lastSample = now;
+}
+
+void rssiTrackInit(rssi_track_t* t, int8_t rssi, uint32_t now) {
+    memset(t, 0, sizeof(*t));
+    rssiTrackUpdate(t, rssi, now);
+}
+
+bool rssiTrackUpdate(rssi_track_t* t, int8_t rssi, uint32_t now) {
+    int16_t x = rssi * (1 << RSSI_TRACK_FRAC_BITS);
+    if (t->n > 0 && now - t->lastUpdate > RSSI_TRACK_RESET_MS) {
+        t->n = 0;       // Too old to smooth against
+    }
+
+    // Running mean until the window fills, then a plain EWMA, so the first
+    // few reports don't drag the estimate towards a stale value
+    if (t->n == 0) {
+        t->est = x;
+    } else {
+        int16_t div = t->n < (1 << RSSI_EWMA_SHIFT) ? t->n + 1 : (1 << RSSI_EWMA_SHIFT);
+        t->est += (x - t->est) / div;
+    }
+    if (t->n < 255) {
+        t->n++;
+    }
+    t->raw = rssi;
+    t->lastUpdate = now;
+
+    if (t->ringCount == 0 || now - t->lastSample >= RSSI_TRACK_SAMPLE_MS) {
+        pushSample(t, now);
+    }
+
+    // Dwell streak
+    if (t->est < FOLLOWER_RSSI_MIN * (1 << RSSI_TRACK_FRAC_BITS)) {
+        return false;
+    }
+    if (!t->inRange || now - t->lastInRange > FOLLOWER_GAP_MS) {
+        t->inRange = true;
+        t->follower = false;
+        t->dwellStart = now;
+    }
+    t->lastInRange = now;
+
+    if (!t->follower && now - t->dwellStart >= FOLLOWER_DWELL_MS) {
+        t->follower = true;
+        return true;
+    }
+    return false;
+}
+
+uint32_t rssiTrackDwellMs(const rssi_track_t* t) {
+    return t->inRange ? t->lastInRange - t->dwellStart : 0;
+}
+
+int rssiTrackTrend(const rssi_track_t* t) {
+    if (t->ringCount < 2) {
+        return 0;
+    }
+    uint8_t newest = (t->ringHead + RSSI_TRACK_RING - 1) % RSSI_TRACK_RING;
+    uint8_t oldest = (t->ringHead + RSSI_TRACK_RING - t->ringCount) % RSSI_TRACK_RING;
+    return t->ring[newest].rssi - t->ring[oldest].rssi;
+}
@@ -0,0 +1,64 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * RSSI Tracking - Filtered signal strength and dwell time per device
+ *
+ * Fixed-size state embedded in every DeviceDetail, updated in O(1) per
+ * sighting. A single report's RSSI swings by 10 dB or more with body shadow
+ * and multipath. The EWMA estimate is what the UI and the events show, and
+ * a short ring of estimates gives the recent trend. The dwell time is how
+ * long the device has stayed in range without a break longer than
+ * FOLLOWER_GAP_MS; a tracker that dwells FOLLOWER_DWELL_MIN minutes is
+ * reported as a persistent follower.
+ */
+
+#ifndef RSSI_TRACK_H
+#define RSSI_TRACK_H
+
+#include <stdint.h>
+#include "../config.h"
+
+// Estimates are fixed point, 1/16 dBm
+#define RSSI_TRACK_FRAC_BITS    4
+
+typedef struct __attribute__((packed)) {
+    uint16_t sec;                       // Seconds since boot (wraps)
+    int8_t rssi;                        // Estimate at that time
+} rssi_sample_t;
+
+typedef struct {
+    int16_t est;                        // Filtered RSSI, 1/16 dBm
+    int8_t raw;                         // Last reported RSSI
+    uint8_t n;                          // Updates since (re)start, saturating
+    uint8_t ringHead;                   // Next slot to write
+    uint8_t ringCount;
+    bool inRange;                       // Dwell streak running
+    bool follower;                      // Alert raised for this streak
+    uint32_t lastUpdate;                // millis() of the last sighting
+    uint32_t lastSample;                // millis() of the last ring entry
+    uint32_t dwellStart;                // millis() the streak started
+    uint32_t lastInRange;               // millis() last seen in range
+    rssi_sample_t ring[RSSI_TRACK_RING];
+} rssi_track_t;
+
+static_assert(sizeof(rssi_track_t) <= 48, "RSSI state eats into the device table budget");
+
+// Start tracking with the first sighting
+void rssiTrackInit(rssi_track_t* t, int8_t rssi, uint32_t now);
+
+// Add a sighting. Returns true when the dwell time reaches the follower
+// threshold (once per streak); the caller decides if the device qualifies.
+bool rssiTrackUpdate(rssi_track_t* t, int8_t rssi, uint32_t now);
+
+// Estimate rounded to dBm
+inline int8_t rssiTrackValue(const rssi_track_t* t) {
+    const int16_t one = 1 << RSSI_TRACK_FRAC_BITS;
+    return (int8_t)((t->est + (t->est >= 0 ? one / 2 : -one / 2)) / one);
+}
+
+// Length of the current in-range streak (0 if none)
+uint32_t rssiTrackDwellMs(const rssi_track_t* t);
+
+// Change of the estimate over the ring, in dB (positive = getting closer)
+int rssiTrackTrend(const rssi_track_t* t);
+
+#endif // RSSI_TRACK_H
@@ -0,0 +1,383 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Signature Database Implementation
+ */
+
+#include "sig_db.h"
+#include <FS.h>
+#include <SPIFFS.h>
+#include <ArduinoJson.h>
+#include "../util/perf_stats.h"
+
+// Global instance
+SignatureDB sigDb;
+
+// =============================================================================
+// BUILTIN INDEX
+// =============================================================================
+// Used as long as nothing was loaded from SPIFFS, so the common case keeps
+// the index in flash
+static_assert(BUILTIN_SIGNATURE_COUNT <= SIG_INDEX_MAX_SIGS, "Signature index too small");
+
+static constexpr sig_index_t BUILTIN_SIG_INDEX = sigIndexBuild(
+    [](size_t i) -> const device_signature_t& { return BUILTIN_SIGNATURES[i]; },
+    BUILTIN_SIGNATURE_COUNT);
+
+// Loaded signatures beyond this are ignored
+#define SIG_DB_LOAD_MAX     (SIG_DB_MAX_ENTRIES < SIG_INDEX_MAX_SIGS ? \
+                             SIG_DB_MAX_ENTRIES : SIG_INDEX_MAX_SIGS)
+
+// =============================================================================
+// JSON FIELD PARSING
+// =============================================================================
+typedef struct {
+    const char* name;
+    uint32_t flag;
+} sig_flag_name_t;
+
+static const sig_flag_name_t FLAG_NAMES[] = {
+    { "COMPANY_ID",       SIG_FLAG_COMPANY_ID },
+    { "PAYLOAD",          SIG_FLAG_PAYLOAD },
+    { "SERVICE_UUID",     SIG_FLAG_SERVICE_UUID },
+    { "NAME_PATTERN",     SIG_FLAG_NAME_PATTERN },
+    { "EXACT_MATCH",      SIG_FLAG_EXACT_MATCH },
+    { "TRANSMITTABLE",    SIG_FLAG_TRANSMITTABLE },
+    { "MEDICAL",          SIG_FLAG_MEDICAL },
+    { "SERVICE_UUID_128", SIG_FLAG_SERVICE_UUID_128 },
+};
+
+static uint8_t parseCategory(const char* str) {
+    if (strcasecmp(str, "TRACKER") == 0)  return CAT_TRACKER;
+    if (strcasecmp(str, "GLASSES") == 0)  return CAT_GLASSES;
+    if (strcasecmp(str, "MEDICAL") == 0)  return CAT_MEDICAL;
+    if (strcasecmp(str, "WEARABLE") == 0) return CAT_WEARABLE;
+    if (strcasecmp(str, "AUDIO") == 0)    return CAT_AUDIO;
+    return CAT_UNKNOWN;
+}
+
+static int hexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Parse hex digits into bytes, skipping '-' separators. Returns bytes parsed.
+static size_t parseHexBytes(const char* str, uint8_t* out, size_t maxLen) {
+    size_t n = 0;
+    int hi = -1;
+    for (; *str != '\0' && n < maxLen; str++) {
+        if (*str == '-') {
+            continue;
+        }
+        int v = hexNibble(*str);
+        if (v < 0) {
+            break;
+        }
+        if (hi < 0) {
+            hi = v;
+        } else {
+            out[n++] = (uint8_t)((hi << 4) | v);
+            hi = -1;
+        }
+    }
+    return n;
+}
+
+// Returns false if the object has no usable name
+static bool parseSignature(JsonVariantConst obj, device_signature_t* sig) {
+    memset(sig, 0, sizeof(*sig));
+
+    const char* name = obj["name"] | "";
+    if (name[0] == '\0') {
+        return false;
+    }
+    strncpy(sig->name, name, sizeof(sig->name) - 1);
+
+    sig->category = parseCategory(obj["category"] | "");
+    sig->company_id = (uint16_t)strtoul(obj["company_id"] | "0", nullptr, 16);
+    sig->service_uuid = (uint16_t)strtoul(obj["service_uuid"] | "0", nullptr, 16);
+    sig->threat_level = (uint8_t)(obj["threat_level"] | 1);
+
+    const char* pattern = obj["payload_pattern"] | "";
+    sig->pattern_length = parseHexBytes(pattern, sig->payload_pattern, sizeof(sig->payload_pattern));
+    sig->pattern_offset = (int8_t)(obj["pattern_offset"] | (sig->pattern_length > 0 ? -1 : 0));
+
+    // Written like the usual UUID notation (big-endian); stored little-endian
+    const char* uuid128 = obj["service_uuid_128"] | "";
+    uint8_t uuid[16];
+    if (parseHexBytes(uuid128, uuid, sizeof(uuid)) == sizeof(uuid)) {
+        for (int i = 0; i < 16; i++) {
+            sig->service_uuid_128[i] = uuid[15 - i];
+        }
+    }
+
+    JsonArrayConst flags = obj["flags"];
+    for (JsonVariantConst flag : flags) {
+        const char* flagName = flag.as<const char*>();
+        if (flagName == nullptr) {
+            continue;
+        }
+        for (size_t i = 0; i < sizeof(FLAG_NAMES) / sizeof(FLAG_NAMES[0]); i++) {
+            if (strcasecmp(flagName, FLAG_NAMES[i].name) == 0) {
+                sig->flags |= FLAG_NAMES[i].flag;
+            }
+        }
+    }
+
+    return true;
+}
+
+// =============================================================================
+// CONSTRUCTOR
+// =============================================================================
+SignatureDB::SignatureDB() {
+    _count = 0;
+    _index = &BUILTIN_SIG_INDEX;
+    _records = nullptr;
+    _loadedCount = 0;
+    _overrideCount = 0;
+    buildTable();
+}
+
+// =============================================================================
+// LOADING
+// =============================================================================
+// FNV-1a over the file, so an edit that keeps the size still invalidates
+// the binary
+static uint32_t hashFile(fs::File& file) {
+    uint32_t h = 2166136261u;
+    uint8_t buf[128];
+    size_t n;
+    while ((n = file.read(buf, sizeof(buf))) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            h = (h ^ buf[i]) * 16777619u;
+        }
+    }
+    return h;
+}
+
+int SignatureDB::init() {
+    uint32_t sourceSize = 0;
+    uint32_t sourceHash = 0;
+    if (SPIFFS.exists(SIG_DB_JSON_FILE)) {
+        fs::File json = SPIFFS.open(SIG_DB_JSON_FILE, "r");
+        if (json) {
+            sourceSize = json.size();
+            sourceHash = hashFile(json);
+            json.close();
+        }
+    }
+
+    int rc = loadBinary(sourceSize, sourceHash);
+    if (rc < 0 && sourceSize > 0) {
+        // Missing or stale binary: convert the JSON once and cache the result
+        uint32_t start = millis();
+        rc = convertJson();
+        if (rc >= 0) {
+            Serial.printf("[SIG] Converted %d signatures from JSON in %lu ms\n",
+                          rc, millis() - start);
+            if (writeBinary(sourceSize, sourceHash) < 0) {
+                Serial.println("[SIG] Failed to write " SIG_DB_BIN_FILE);
+            }
+        }
+    }
+
+    buildTable();
+    Serial.printf("[SIG] %d signatures (%d builtin, %d loaded, %d overrides)\n",
+                  _count, (int)BUILTIN_SIGNATURE_COUNT, _loadedCount, _overrideCount);
+    return rc;
+}
+
+// Returns the record count, -1 if missing, -2 if invalid or stale, -3 if out of memory
+int SignatureDB::loadBinary(uint32_t sourceSize, uint32_t sourceHash) {
+    if (!SPIFFS.exists(SIG_DB_BIN_FILE)) {
+        return -1;
+    }
+    fs::File bin = SPIFFS.open(SIG_DB_BIN_FILE, "r");
+    if (!bin) {
+        return -1;
+    }
+
+    sig_db_header_t header;
+    if (bin.read((uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+        header.magic != SIG_DB_MAGIC || header.version != SIG_DB_FORMAT_VERSION ||
+        header.recordSize != sizeof(device_signature_t) || header.count > SIG_DB_LOAD_MAX ||
+        (sourceSize > 0 &&
+         (header.sourceSize != sourceSize || header.sourceHash != sourceHash))) {
+        bin.close();
+        return -2;
+    }
+
+    size_t bytes = header.count * sizeof(device_signature_t);
+    device_signature_t* records = (device_signature_t*)malloc(bytes > 0 ? bytes : 1);
+    if (records == nullptr) {
+        bin.close();
+        return -3;
+    }
+    if (bin.read((uint8_t*)records, bytes) != bytes) {
+        free(records);
+        bin.close();
+        return -2;
+    }
+    bin.close();
+
+    free(_records);
+    _records = records;
+    _loadedCount = header.count;
+    return _loadedCount;
+}
+
+// Streams the "signatures" array one object at a time so only a single
+// signature is ever deserialized. Returns the record count or a negative error.
+int SignatureDB::convertJson() {
+    fs::File json = SPIFFS.open(SIG_DB_JSON_FILE, "r");
+    if (!json) {
+        return -1;
+    }
+    if (!json.find("\"signatures\"") || !json.find("[")) {
+        json.close();
+        return -2;
+    }
+
+    device_signature_t* records =
+        (device_signature_t*)malloc(SIG_DB_LOAD_MAX * sizeof(device_signature_t));
+    if (records == nullptr) {
+        json.close();
+        return -3;
+    }
+
+    int count = 0;
+    StaticJsonDocument<768> doc;
+    while (count < SIG_DB_LOAD_MAX) {
+        DeserializationError err = deserializeJson(doc, json);
+        if (err) {
+            if (count == 0 && err != DeserializationError::InvalidInput) {
+                Serial.printf("[SIG] JSON error: %s\n", err.c_str());
+            }
+            break;  // InvalidInput here is the closing ']' of an empty array
+        }
+        if (parseSignature(doc.as<JsonVariantConst>(), &records[count])) {
+            count++;
+        }
+        if (!json.findUntil(",", "]")) {
+            break;  // End of array
+        }
+    }
+    json.close();
+
+    // Give back the unused part of the buffer
+    device_signature_t* shrunk =
+        (device_signature_t*)realloc(records, (count > 0 ? count : 1) * sizeof(device_signature_t));
+    if (shrunk != nullptr) {
+        records = shrunk;
+    }
+
+    free(_records);
+    _records = records;
+    _loadedCount = count;
+    return count;
+}
+
+int SignatureDB::writeBinary(uint32_t sourceSize, uint32_t sourceHash) {
+    // Write to a temporary file so a power cut never leaves a torn database
+    const char* tmpPath = SIG_DB_BIN_FILE ".tmp";
+    fs::File bin = SPIFFS.open(tmpPath, "w");
+    if (!bin) {
+        return -1;
+    }
+
+    sig_db_header_t header;
+    header.magic = SIG_DB_MAGIC;
+    header.version = SIG_DB_FORMAT_VERSION;
+    header.recordSize = sizeof(device_signature_t);
+    header.count = _loadedCount;
+    header.sourceSize = sourceSize;
+    header.sourceHash = sourceHash;
+
+    size_t bytes = _loadedCount * sizeof(device_signature_t);
+    bool ok = bin.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+              bin.write((const uint8_t*)_records, bytes) == bytes;
+    bin.close();
+
+    if (!ok) {
+        SPIFFS.remove(tmpPath);
+        return -2;
+    }
+    SPIFFS.remove(SIG_DB_BIN_FILE);
+    if (!SPIFFS.rename(tmpPath, SIG_DB_BIN_FILE)) {
+        return -3;
+    }
+    return 0;
+}
+
+// =============================================================================
+// COMBINED TABLE
+// =============================================================================
+void SignatureDB::buildTable() {
+    _count = 0;
+    for (size_t i = 0; i < BUILTIN_SIGNATURE_COUNT; i++) {
+        _table[_count++] = &BUILTIN_SIGNATURES[i];
+    }
+
+    // A loaded signature takes over the slot (and priority) of the builtin
+    // with the same name; new names are appended after the builtins
+    _overrideCount = 0;
+    for (int i = 0; i < _loadedCount; i++) {
+        const device_signature_t* sig = &_records[i];
+        bool replaced = false;
+        for (size_t b = 0; b < BUILTIN_SIGNATURE_COUNT; b++) {
+            if (strcasecmp(BUILTIN_SIGNATURES[b].name, sig->name) == 0) {
+                _table[b] = sig;
+                _overrideCount++;
+                replaced = true;
+                break;
+            }
+        }
+        if (!replaced && _count < SIG_INDEX_MAX_SIGS) {
+            _table[_count++] = sig;
+        }
+    }
+
+    if (_loadedCount == 0) {
+        _index = &BUILTIN_SIG_INDEX;
+    } else {
+        static sig_index_t runtimeIndex;
+        memset(&runtimeIndex, 0, sizeof(runtimeIndex));
+        sigIndexBuildInto(
+            [this](size_t i) -> const device_signature_t& { return *_table[i]; }, _count,
+            runtimeIndex);
+        _index = &runtimeIndex;
+    }
+
+    _matchTable.sigs = _table;
+    _matchTable.count = _count;
+    _matchTable.index = _index;
+}
+
+// =============================================================================
+// MATCHING
+// =============================================================================
+const device_signature_t* matchSignature(const uint8_t* payload, size_t payloadLen,
+                                         const adv_view_t* view, int16_t* outIndex) {
+    PERF_SCOPE(PERF_MATCH);
+    return matchSignatureIn(sigDb.getMatchTable(), payload, payloadLen, view, outIndex);
+}
+
+int SignatureDB::indexOf(const device_signature_t* sig) {
+    for (int i = 0; i < _count; i++) {
+        if (_table[i] == sig) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const device_signature_t* SignatureDB::findByName(const char* name) {
+    for (int i = 0; i < _count; i++) {
+        if (strcasecmp(_table[i]->name, name) == 0) {
+            return _table[i];
+        }
+    }
+    return nullptr;
+}
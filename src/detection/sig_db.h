@@ -0,0 +1,78 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Signature Database
+ *
+ * Combines the compiled-in signatures with signatures loaded from SPIFFS.
+ * /signatures.json is converted once into /signatures.bin, a header followed
+ * by raw device_signature_t records, which later boots read with a single
+ * file read. Loaded signatures replace builtins of the same name; the rest
+ * are appended. The matcher index covers the combined table.
+ */
+
+#ifndef SIG_DB_H
+#define SIG_DB_H
+
+#include <Arduino.h>
+#include "../config.h"
+#include "signatures.h"
+#include "sig_index.h"
+#include "matcher.h"
+
+// =============================================================================
+// BINARY FORMAT
+// =============================================================================
+#define SIG_DB_MAGIC            0x47495342  // "BSIG"
+#define SIG_DB_FORMAT_VERSION   2
+
+typedef struct {
+    uint32_t magic;                 // SIG_DB_MAGIC
+    uint16_t version;               // SIG_DB_FORMAT_VERSION
+    uint16_t recordSize;            // sizeof(device_signature_t)
+    uint32_t count;                 // Records following the header
+    uint32_t sourceSize;            // Size of the JSON it was built from
+    uint32_t sourceHash;            // FNV-1a of that JSON
+} sig_db_header_t;
+
+// =============================================================================
+// SIGNATURE DATABASE CLASS
+// =============================================================================
+class SignatureDB {
+public:
+    SignatureDB();
+
+    // Load SPIFFS signatures (SPIFFS must be mounted). Returns the number of
+    // signatures loaded, or a negative error; builtins are always available.
+    int init();
+
+    // Combined table
+    int count() { return _count; }
+    const device_signature_t* get(int index) { return _table[index]; }
+    const sig_index_t* getIndex() { return _index; }
+    const sig_table_t* getMatchTable() { return &_matchTable; }
+    const device_signature_t* findByName(const char* name);
+    int indexOf(const device_signature_t* sig);     // -1 if not in the table
+
+    // Statistics
+    int getLoadedCount() { return _loadedCount; }
+    int getOverrideCount() { return _overrideCount; }
+
+private:
+    const device_signature_t* _table[SIG_INDEX_MAX_SIGS];
+    int _count;
+    sig_table_t _matchTable;            // _table + _index for the matcher
+    const sig_index_t* _index;
+    device_signature_t* _records;       // Loaded records (heap)
+    int _loadedCount;
+    int _overrideCount;
+
+    // Internal methods
+    int loadBinary(uint32_t sourceSize, uint32_t sourceHash);
+    int convertJson();
+    int writeBinary(uint32_t sourceSize, uint32_t sourceHash);
+    void buildTable();
+};
+
+// Global signature database instance
+extern SignatureDB sigDb;
+
+#endif // SIG_DB_H
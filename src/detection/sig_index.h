@@ -0,0 +1,240 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Signature Index
+ *
+ * Hash dispatch tables that map the fields of an advertisement (company ID,
+ * 16-bit and 128-bit service UUIDs) to the few signatures that can match it,
+ * so the matcher never walks the whole signature table. Payload patterns are
+ * compiled as well: unanchored ones into a single shift-and automaton that
+ * finds all of them in one pass over the payload, anchored ones into a jump
+ * table keyed by offset and first byte. The builder is constexpr: the index
+ * for BUILTIN_SIGNATURES is generated at compile time.
+ */
+
+#ifndef SIG_INDEX_H
+#define SIG_INDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "signatures.h"
+
+// =============================================================================
+// INDEX SIZING
+// =============================================================================
+#ifndef SIG_INDEX_MAX_SIGS
+#define SIG_INDEX_MAX_SIGS      (SIG_DB_MAX_ENTRIES + 64)   // Builtins + loaded
+#endif
+#define SIG_INDEX_BUCKET_BITS   6
+#define SIG_INDEX_BUCKETS       (1 << SIG_INDEX_BUCKET_BITS)
+#define SIG_INDEX_NONE          (-1)
+#define SIG_INDEX_SIG_WORDS     ((SIG_INDEX_MAX_SIGS + 31) / 32)
+
+// Payload automaton: pattern bytes share one 64-bit state word, so the
+// unanchored patterns may total 64 bytes; the rest are searched one by one
+#define SIG_INDEX_SHIFT_BITS    64
+#define SIG_INDEX_SHIFT_CLASSES (SIG_INDEX_SHIFT_BITS + 1)  // Class 0 = in no pattern
+#define SIG_INDEX_MAX_ANCHORS   16                          // Distinct pattern offsets
+
+// =============================================================================
+// INDEX STRUCTURE
+// =============================================================================
+// Each bucket heads a chain of signature indices linked through the matching
+// *Next array. Chains and lists are kept in ascending signature order so the
+// matcher can stop a chain as soon as it passes the best match found so far.
+// Buckets may hold colliding keys; candidates are always fully verified.
+typedef struct {
+    uint16_t count;                                 // Signatures indexed
+    int16_t companyHead[SIG_INDEX_BUCKETS];         // By company ID
+    int16_t uuid16Head[SIG_INDEX_BUCKETS];          // By 16-bit service UUID
+    int16_t uuid128Head[SIG_INDEX_BUCKETS];         // By 128-bit service UUID
+    int16_t companyNext[SIG_INDEX_MAX_SIGS];
+    int16_t uuid16Next[SIG_INDEX_MAX_SIGS];
+    int16_t uuid128Next[SIG_INDEX_MAX_SIGS];
+    uint16_t nameCount;                             // Name pattern signatures
+    int16_t nameList[SIG_INDEX_MAX_SIGS];
+
+    // Payload patterns (SIG_FLAG_PAYLOAD). Pattern j owns state bits
+    // start_j..end_j; a byte keeps a bit alive only where the pattern holds
+    // that byte, so a set end bit means the whole pattern was seen.
+    uint8_t shiftClass[256];                        // Byte -> class
+    uint64_t shiftMask[SIG_INDEX_SHIFT_CLASSES];    // Class -> bits holding it
+    uint64_t shiftStart;                            // First bit of each pattern
+    uint64_t shiftEnd;                              // Last bit of each pattern
+    int16_t shiftSig[SIG_INDEX_SHIFT_BITS];         // Signature ending at a bit
+    uint8_t anchorCount;                            // Offsets in use
+    uint8_t anchorOffset[SIG_INDEX_MAX_ANCHORS];
+    int16_t anchorHead[SIG_INDEX_BUCKETS];          // By offset and first byte
+    int16_t anchorNext[SIG_INDEX_MAX_SIGS];
+    uint32_t payloadCompiled[SIG_INDEX_SIG_WORDS];  // Resolved by the tables above
+    uint32_t payloadCandidate[SIG_INDEX_SIG_WORDS]; // May match by payload alone
+    uint16_t payloadCount;                          // Payload-only candidates that
+    int16_t payloadList[SIG_INDEX_MAX_SIGS];        // did not fit the tables
+} sig_index_t;
+
+// =============================================================================
+// HASH FUNCTIONS
+// =============================================================================
+constexpr uint8_t sigIndexHash16(uint16_t key) {
+    return (uint8_t)((uint16_t)(key * 40503u) >> (16 - SIG_INDEX_BUCKET_BITS));
+}
+
+constexpr uint8_t sigIndexHash128(const uint8_t* uuid) {
+    uint32_t h = 2166136261u;   // FNV-1a
+    for (int i = 0; i < 16; i++) {
+        h = (h ^ uuid[i]) * 16777619u;
+    }
+    return (uint8_t)(h >> (32 - SIG_INDEX_BUCKET_BITS));
+}
+
+constexpr uint8_t sigIndexHashAnchor(uint8_t offset, uint8_t first) {
+    return sigIndexHash16((uint16_t)((offset << 8) | first));
+}
+
+constexpr bool sigIndexBitTest(const uint32_t* bits, int16_t i) {
+    return (bits[i >> 5] >> (i & 31)) & 1;
+}
+
+constexpr bool sigIndexUuid128Empty(const uint8_t* uuid) {
+    for (int i = 0; i < 16; i++) {
+        if (uuid[i] != 0) return false;
+    }
+    return true;
+}
+
+// =============================================================================
+// INDEX BUILDER
+// =============================================================================
+// sigAt(i) must return a reference to signature i. Usable at compile time for
+// the builtin table and at runtime for tables assembled after boot.
+//
+// A signature with SIG_FLAG_EXACT_MATCH can only match once its company ID
+// matched, so it is reachable through the company chain alone. Its payload
+// pattern is still compiled so the check costs nothing extra.
+//
+// Patterns that no longer fit the automaton or the anchor table fall back
+// to a search of their own (payloadList for candidates).
+//
+// Builds into idx, which must be zero-initialized. The index is several KB,
+// so runtime callers build straight into static storage rather than
+// returning it through the stack.
+template <typename SigAt>
+constexpr void sigIndexBuildInto(SigAt sigAt, size_t count, sig_index_t& idx) {
+    int16_t companyTail[SIG_INDEX_BUCKETS] = {};
+    int16_t uuid16Tail[SIG_INDEX_BUCKETS] = {};
+    int16_t uuid128Tail[SIG_INDEX_BUCKETS] = {};
+    int16_t anchorTail[SIG_INDEX_BUCKETS] = {};
+    uint8_t shiftBits = 0;
+    uint8_t shiftClasses = 1;
+
+    for (int b = 0; b < SIG_INDEX_BUCKETS; b++) {
+        idx.companyHead[b] = SIG_INDEX_NONE;
+        idx.uuid16Head[b] = SIG_INDEX_NONE;
+        idx.uuid128Head[b] = SIG_INDEX_NONE;
+        companyTail[b] = SIG_INDEX_NONE;
+        uuid16Tail[b] = SIG_INDEX_NONE;
+        uuid128Tail[b] = SIG_INDEX_NONE;
+        idx.anchorHead[b] = SIG_INDEX_NONE;
+        anchorTail[b] = SIG_INDEX_NONE;
+    }
+    for (int b = 0; b < SIG_INDEX_SHIFT_BITS; b++) {
+        idx.shiftSig[b] = SIG_INDEX_NONE;
+    }
+
+    if (count > SIG_INDEX_MAX_SIGS) {
+        count = SIG_INDEX_MAX_SIGS;
+    }
+    idx.count = (uint16_t)count;
+
+    for (size_t i = 0; i < count; i++) {
+        const device_signature_t& sig = sigAt(i);
+        const int16_t si = (int16_t)i;
+        const bool exact = (sig.flags & SIG_FLAG_EXACT_MATCH) != 0;
+
+        idx.companyNext[i] = SIG_INDEX_NONE;
+        idx.uuid16Next[i] = SIG_INDEX_NONE;
+        idx.uuid128Next[i] = SIG_INDEX_NONE;
+        idx.anchorNext[i] = SIG_INDEX_NONE;
+
+        const bool payload = (sig.flags & SIG_FLAG_PAYLOAD) && sig.pattern_length > 0;
+        bool compiled = false;
+        if (payload && sig.pattern_length <= sizeof(sig.payload_pattern)) {
+            const uint8_t len = sig.pattern_length;
+            if (sig.pattern_offset < 0 && shiftBits + len <= SIG_INDEX_SHIFT_BITS) {
+                for (uint8_t k = 0; k < len; k++) {
+                    uint8_t byte = sig.payload_pattern[k];
+                    if (idx.shiftClass[byte] == 0) {
+                        idx.shiftClass[byte] = shiftClasses++;
+                    }
+                    idx.shiftMask[idx.shiftClass[byte]] |= (uint64_t)1 << (shiftBits + k);
+                }
+                idx.shiftStart |= (uint64_t)1 << shiftBits;
+                idx.shiftEnd |= (uint64_t)1 << (shiftBits + len - 1);
+                idx.shiftSig[shiftBits + len - 1] = si;
+                shiftBits += len;
+                compiled = true;
+            } else if (sig.pattern_offset >= 0) {
+                const uint8_t offset = (uint8_t)sig.pattern_offset;
+                uint8_t a = 0;
+                while (a < idx.anchorCount && idx.anchorOffset[a] != offset) a++;
+                if (a == idx.anchorCount && a < SIG_INDEX_MAX_ANCHORS) {
+                    idx.anchorOffset[idx.anchorCount++] = offset;
+                }
+                if (a < idx.anchorCount) {
+                    uint8_t b = sigIndexHashAnchor(offset, sig.payload_pattern[0]);
+                    if (anchorTail[b] == SIG_INDEX_NONE) idx.anchorHead[b] = si;
+                    else idx.anchorNext[anchorTail[b]] = si;
+                    anchorTail[b] = si;
+                    compiled = true;
+                }
+            }
+        }
+        if (compiled) {
+            idx.payloadCompiled[i >> 5] |= (uint32_t)1 << (i & 31);
+        }
+
+        if (sig.flags & SIG_FLAG_COMPANY_ID) {
+            uint8_t b = sigIndexHash16(sig.company_id);
+            if (companyTail[b] == SIG_INDEX_NONE) idx.companyHead[b] = si;
+            else idx.companyNext[companyTail[b]] = si;
+            companyTail[b] = si;
+        }
+
+        if (exact) {
+            continue;
+        }
+
+        if ((sig.flags & SIG_FLAG_SERVICE_UUID) && sig.service_uuid != 0) {
+            uint8_t b = sigIndexHash16(sig.service_uuid);
+            if (uuid16Tail[b] == SIG_INDEX_NONE) idx.uuid16Head[b] = si;
+            else idx.uuid16Next[uuid16Tail[b]] = si;
+            uuid16Tail[b] = si;
+        }
+
+        if ((sig.flags & SIG_FLAG_SERVICE_UUID_128) && !sigIndexUuid128Empty(sig.service_uuid_128)) {
+            uint8_t b = sigIndexHash128(sig.service_uuid_128);
+            if (uuid128Tail[b] == SIG_INDEX_NONE) idx.uuid128Head[b] = si;
+            else idx.uuid128Next[uuid128Tail[b]] = si;
+            uuid128Tail[b] = si;
+        }
+
+        if (sig.flags & SIG_FLAG_NAME_PATTERN) {
+            idx.nameList[idx.nameCount++] = si;
+        }
+
+        if (payload && compiled) {
+            idx.payloadCandidate[i >> 5] |= (uint32_t)1 << (i & 31);
+        } else if (payload) {
+            idx.payloadList[idx.payloadCount++] = si;
+        }
+    }
+}
+
+// Compile-time form, for the builtin table
+template <typename SigAt>
+constexpr sig_index_t sigIndexBuild(SigAt sigAt, size_t count) {
+    sig_index_t idx = {};
+    sigIndexBuildInto(sigAt, count, idx);
+    return idx;
+}
+
+#endif // SIG_INDEX_H
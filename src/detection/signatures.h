@@ -9,7 +9,8 @@
 #ifndef SIGNATURES_H
 #define SIGNATURES_H
 
-#include <Arduino.h>
+#include <stdint.h>
+#include <stddef.h>
 #include "../config.h"
 
 // =============================================================================
@@ -145,7 +146,7 @@ typedef struct {
 // BUILT-IN SIGNATURES
 // Format: {name, category, company_id, {pattern[8]}, pattern_len, offset, svc_uuid, svc_uuid_128[16], threat, flags}
 // =============================================================================
-static const device_signature_t BUILTIN_SIGNATURES[] = {
+static constexpr device_signature_t BUILTIN_SIGNATURES[] = {
     // =========================================================================
     // TRACKERS - High privacy threat, can be used for stalking
     // =========================================================================
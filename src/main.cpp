@@ -14,23 +14,52 @@
 #include <XPT2046_Touchscreen.h>
 #include <BLEDevice.h>
 #include <BLEUtils.h>
-#include <BLEScan.h>
-#include <BLEAdvertisedDevice.h>
 #include <FS.h>
 #include <SPIFFS.h>
 
 #include "config.h"
 #include "detection/signatures.h"
+#include "detection/adv_parser.h"
+#include "detection/sig_db.h"
+#include "detection/matcher.h"
+#include "detection/device_table.h"
+#include "detection/det_log.h"
+#include "detection/det_events.h"
+#include "detection/match_cache.h"
+#include "detection/cluster.h"
+#include "detection/allow_list.h"
 #include "packet/tx_mgr.h"
+#include "ble/ble_hal.h"
+#include "ble/scanner.h"
+#include "ble/scan_sched.h"
+#include "ble/scan_rsp_cache.h"
+#include "ui/content_frame.h"
+#include "ui/ui_events.h"
+#include "serial/bin_proto.h"
+#include "serial/raw_stream.h"
+#include "serial/cmd_parser.h"
+#include "net/uplink.h"
+#include "util/perf_stats.h"
+#include "util/power_mgr.h"
 
 // =============================================================================
 // TOUCH SCREEN PINS (CYD uses separate VSPI for touch)
 // =============================================================================
+#if defined(BLEPTD_VARIANT_S3)
+#define XPT2046_IRQ   TOUCH_IRQ_PIN
+#define XPT2046_MOSI  6
+#define XPT2046_MISO  5
+#define XPT2046_CLK   4
+#define XPT2046_CS    TOUCH_CS_PIN
+#define XPT2046_SPI   FSPI          // The S3 has no VSPI; TFT_eSPI takes HSPI
+#else
 #define XPT2046_IRQ   36
 #define XPT2046_MOSI  32
 #define XPT2046_MISO  39
 #define XPT2046_CLK   25
 #define XPT2046_CS    33
+#define XPT2046_SPI   VSPI
+#endif
 
 // =============================================================================
 // GLOBAL OBJECTS
@@ -48,9 +77,8 @@ TFT_eSPI tft = TFT_eSPI(240, 320);
 #else
 TFT_eSPI tft = TFT_eSPI();
 #endif
-SPIClass touchSpi(VSPI);
-XPT2046_Touchscreen ts(XPT2046_CS);  // No IRQ, just poll
-BLEScan* pBLEScan = nullptr;
+SPIClass touchSpi(XPT2046_SPI);
+XPT2046_Touchscreen ts(XPT2046_CS);  // PENIRQ is handled by touchIrq()
 
 // State
 volatile bool scanning = false;
@@ -61,26 +89,11 @@ int8_t rssiThreshold = -80;
 
 // List scrolling and detail view
 int scrollOffset = 0;           // Current scroll position in device list
-int selectedDeviceIdx = -1;     // Index of device shown in detail view
+uint8_t selectedMac[6] = {0};   // Device shown in detail view; slots are
+bool deviceSelected = false;    // reused after eviction, so keep the MAC
 const int ITEMS_PER_PAGE = 9;   // Number of devices visible on screen
 const int ITEM_HEIGHT = 18;     // Height of each list item in pixels
 
-// Detected devices storage
-struct DetectedDevice {
-    char name[32];
-    uint8_t mac[6];
-    int8_t rssi;
-    uint8_t category;
-    uint16_t companyId;
-    uint32_t firstSeen;
-    uint32_t lastSeen;
-    uint16_t detectionCount;
-    uint8_t threatLevel;
-    bool active;
-};
-
-DetectedDevice detectedDevices[DETECTED_DEVICES_MAX];
-int detectedCount = 0;
 
 // Serial command buffer
 char cmdBuffer[SERIAL_CMD_BUFFER_SIZE];
@@ -88,12 +101,19 @@ int cmdIndex = 0;
 
 // JSON output mode
 bool jsonOutput = SERIAL_JSON_OUTPUT;
+bool binaryOutput = false;          // COBS framed records; overrides JSON/text
+uint32_t serialBaudRate = SERIAL_BAUD_RATE;
 
 // Power save state
 bool powerSaveEnabled = POWERSAVE_ENABLED_DEFAULT;
 uint32_t powerSaveTimeoutSec = POWERSAVE_TIMEOUT_SEC_DEFAULT;
 uint32_t lastNewDeviceTime = 0;     // Timestamp of last new device detection
-bool screenAsleep = false;          // True when screen backlight is off
+volatile bool screenAsleep = false; // True when screen backlight is off
+
+// Pipeline tasks (see setup)
+static TaskHandle_t matchTaskHandle = nullptr;
+static TaskHandle_t serialTaskHandle = nullptr;
+static TaskHandle_t uiTaskHandle = nullptr;
 
 // =============================================================================
 // FORWARD DECLARATIONS
@@ -104,248 +124,262 @@ void initSerial();
 void drawStatusBar();
 void drawNavBar();
 void drawScanScreen();
+void updateScanScreen();
 void drawFilterScreen();
 void drawTXScreen();
 void drawSettingsScreen();
 void drawDetailScreen();
-void processSerialCommand(const char* cmd);
-void outputDetection(const DetectedDevice* device);
-const device_signature_t* matchSignature(BLEAdvertisedDevice* device);
+void processSerialCommand(char* line);
+void outputDetection(const device_snapshot_t* device);
+void outputFollower(const device_snapshot_t* device);
+void processScanResults();
 void outputTxEvent(const char* event, const char* device, uint32_t intervalMs, int32_t count, uint32_t sent);
+void outputRemote(const uplink_packet_t* pkt);
 const char* getCategoryString(uint8_t category);
 void initTouch();
 void handleTouch();
 void loadPowerSaveConfig();
 void wakeScreen();
+void requestScreenWake();
 void sleepScreen();
 void checkPowerSave();
 
 // =============================================================================
-// BLE SCAN CALLBACK
+// SCAN RESULT PROCESSING
 // =============================================================================
-class ScanCallbacks : public BLEAdvertisedDeviceCallbacks {
-    void onResult(BLEAdvertisedDevice advertisedDevice) override {
-        // Get raw payload
-        uint8_t* payload = advertisedDevice.getPayload();
-        size_t payloadLen = advertisedDevice.getPayloadLength();
-
-        // Try to match against known signatures
-        const device_signature_t* sig = matchSignature(&advertisedDevice);
-
-        if (sig != nullptr) {
-            // Check category filter
-            if (!(sig->category & categoryFilter)) {
-                return;
-            }
-
-            // Check RSSI threshold
-            if (advertisedDevice.getRSSI() < rssiThreshold) {
-                return;
-            }
+// Keep the latest payload with its view; the view's offsets stay valid
+// because they are relative to the copied payload
+static void storeAdvPayload(DeviceDetail* detail, const adv_record_t* rec, const adv_view_t* view) {
+    detail->payloadLen = rec->payloadLen;
+    memcpy(detail->payload, rec->payload, rec->payloadLen);
+    detail->view = *view;
+}
 
-            // Get MAC address
-            uint8_t mac[6];
-            memcpy(mac, advertisedDevice.getAddress().getNative(), 6);
-
-            // Check if already detected
-            int existingIdx = -1;
-            for (int i = 0; i < detectedCount; i++) {
-                if (memcmp(detectedDevices[i].mac, mac, 6) == 0) {
-                    existingIdx = i;
-                    break;
-                }
-            }
+// Hybrid scanning: remember scan responses by MAC and append the cached one
+// to reports that arrive without it (passive scan). Returns the record to use.
+static const adv_record_t* mergeScanResponse(const adv_record_t* rec, adv_record_t* merged) {
+    // A legacy scan response report repeats the adv data ahead of the
+    // response, so only the bytes after advLen are cached
+    if (rec->payloadLen > rec->advLen) {
+        scanRspCache.store(rec->mac, rec->payload + rec->advLen,
+                           rec->payloadLen - rec->advLen, rec->timestamp);
+        return rec;
+    }
+    if (rec->evtType == ESP_BLE_EVT_SCAN_RSP) {
+        return rec;     // Empty response
+    }
+
+    const scan_rsp_entry_t* rsp = scanRspCache.find(rec->mac, rec->timestamp);
+    if (rsp == nullptr || rsp->state != SCAN_RSP_VALID || rsp->len == 0 ||
+        rec->advLen + rsp->len > sizeof(merged->payload)) {
+        return rec;
+    }
+    *merged = *rec;
+    memcpy(merged->payload + rec->advLen, rsp->data, rsp->len);
+    merged->payloadLen = rec->advLen + rsp->len;
+    scanRspCache.countMerged();
+    return merged;
+}
 
-            if (existingIdx >= 0) {
-                // Update existing
-                detectedDevices[existingIdx].rssi = advertisedDevice.getRSSI();
-                detectedDevices[existingIdx].lastSeen = millis();
-                detectedDevices[existingIdx].detectionCount++;
-                detectedDevices[existingIdx].active = true;
-            } else if (detectedCount < DETECTED_DEVICES_MAX) {
-                // Add new device
-                DetectedDevice* dev = &detectedDevices[detectedCount];
-                strncpy(dev->name, sig->name, sizeof(dev->name) - 1);
-                memcpy(dev->mac, mac, 6);
-                dev->rssi = advertisedDevice.getRSSI();
-                dev->category = sig->category;
-                dev->companyId = sig->company_id;
-                dev->firstSeen = millis();
-                dev->lastSeen = millis();
-                dev->detectionCount = 1;
-                dev->threatLevel = sig->threat_level;
-                dev->active = true;
-                detectedCount++;
-
-                // Output detection event
-                outputDetection(dev);
-
-                // Wake screen if in power save mode (new device detected)
-                wakeScreen();
-
-                // Update display if on scan screen
-                if (currentScreen == 0) {
-                    // TODO: Update display
-                }
-            }
-        }
+// An unmatched, scannable advertiser without a name could still match a
+// name pattern through its scan response: ask for an active burst, once.
+// Returns false if the burst was refused and a later report should retry.
+static bool requestScanResponse(const adv_record_t* rec, const adv_view_t* view) {
+    if (!BLE_HYBRID_SCAN || advHasName(view) || rec->payloadLen > rec->advLen) {
+        return true;
     }
-};
-
-// =============================================================================
-// SIGNATURE MATCHING
-// =============================================================================
-// Helper to check if 128-bit UUID is empty (all zeros)
-static bool isUuid128Empty(const uint8_t* uuid) {
-    for (int i = 0; i < 16; i++) {
-        if (uuid[i] != 0) return false;
+    if (rec->evtType != ESP_BLE_EVT_CONN_ADV && rec->evtType != ESP_BLE_EVT_DISC_ADV) {
+        return true;    // Not scannable
+    }
+    if (sigDb.getMatchTable()->index->nameCount == 0 ||
+        scanRspCache.find(rec->mac, rec->timestamp) != nullptr) {
+        return true;
     }
+    if (!scanScheduler.requestActiveBurst(rec->timestamp)) {
+        return false;
+    }
+    scanRspCache.markRequested(rec->mac, rec->timestamp);
     return true;
 }
 
-const device_signature_t* matchSignature(BLEAdvertisedDevice* device) {
-    uint8_t* payload = device->getPayload();
-    size_t payloadLen = device->getPayloadLength();
-
-    // Extract company ID from manufacturer data if present
-    uint16_t mfgCompanyId = 0;
-    bool hasMfgData = false;
-
-    // Extract 16-bit and 128-bit service UUIDs from advertisement
-    uint16_t serviceUuid16 = 0;
-    bool hasServiceUuid16 = false;
-    uint8_t serviceUuid128[16] = {0};
-    bool hasServiceUuid128 = false;
-
-    // Get device name for pattern matching
-    std::string deviceName = device->getName();
+// UI events raised by the current batch; posted once per batch
+static uint32_t batchUiEvents = 0;
+
+// Another sighting of a device already in the table
+static void updateDevice(int index, const adv_record_t* rec) {
+    DetectedDevice* dev = deviceTable.at(index);
+    DeviceDetail* detail = deviceTable.detail(index);
+    bool follower = rssiTrackUpdate(&detail->track, rec->rssi, rec->timestamp);
+    int8_t rssi = rssiTrackValue(&detail->track);
+    if (rssi != dev->rssi) {
+        dev->rssi = rssi;
+        batchUiEvents |= UI_EVENT_DEVICE_RSSI;
+    }
+    if (detail->track.follower) {
+        dev->flags |= DEVICE_FLAG_FOLLOWER;
+    } else {
+        dev->flags &= ~DEVICE_FLAG_FOLLOWER;
+    }
+    detail->detectionCount++;
+    deviceTable.touch(index, rec->timestamp);
 
-    // Parse advertisement data
-    size_t idx = 0;
-    while (idx < payloadLen) {
-        uint8_t len = payload[idx];
-        if (len == 0 || idx + len >= payloadLen) break;
+    if (follower && (dev->category & FOLLOWER_CATEGORIES)) {
+        detLog.append(dev->mac, dev->sigIndex, dev->rssi, DET_LOG_FOLLOWER);
+        detEvents.post(DET_EVENT_FOLLOWER, index);
+        batchUiEvents |= UI_EVENT_DEVICE_LIST;
+        requestScreenWake();
+    }
 
-        uint8_t type = payload[idx + 1];
+    // Long-present devices get a periodic journal entry
+    if (rec->timestamp - detail->lastLogged >= DET_LOG_RESIGHT_MS) {
+        detLog.append(dev->mac, dev->sigIndex, dev->rssi, DET_LOG_SEEN);
+        detail->lastLogged = rec->timestamp;
+    }
+}
 
-        switch (type) {
-            case 0xFF:  // Manufacturer specific data
-                if (len >= 3) {
-                    mfgCompanyId = payload[idx + 2] | (payload[idx + 3] << 8);
-                    hasMfgData = true;
-                }
-                break;
+void processAdvRecord(const adv_record_t* rec) {
+    PERF_SCOPE(PERF_ADV_PROCESS);
+
+    adv_record_t merged;
+    rec = mergeScanResponse(rec, &merged);
+
+    // Repeated payload: the match result can't have changed
+    uint32_t payloadHash = matchCacheHash(rec->payload, rec->payloadLen);
+    int existingIdx = deviceTable.find(rec->mac);
+    if (MATCH_CACHE_ENABLED) {
+        if (existingIdx >= 0 && deviceTable.at(existingIdx)->payloadHash == payloadHash) {
+            matchCache.countKnownHit();
+            if ((deviceTable.at(existingIdx)->category & categoryFilter) &&
+                rec->rssi >= rssiThreshold) {
+                updateDevice(existingIdx, rec);
+            }
+            return;
+        }
+        if (matchCache.isUnmatched(rec->mac, payloadHash)) {
+            return;
+        }
+        matchCache.countMiss();
+    }
 
-            case 0x02:  // Incomplete 16-bit Service UUIDs
-            case 0x03:  // Complete 16-bit Service UUIDs
-                if (len >= 3) {
-                    serviceUuid16 = payload[idx + 2] | (payload[idx + 3] << 8);
-                    hasServiceUuid16 = true;
-                }
-                break;
+    // Parse once; the view is shared by matching, display and logging
+    adv_view_t view;
+    advParse(rec->payload, rec->payloadLen, &view);
 
-            case 0x06:  // Incomplete 128-bit Service UUIDs
-            case 0x07:  // Complete 128-bit Service UUIDs
-                if (len >= 17) {
-                    memcpy(serviceUuid128, &payload[idx + 2], 16);
-                    hasServiceUuid128 = true;
-                }
-                break;
+    // Try to match against known signatures
+    int16_t sigIndex;
+    const device_signature_t* sig = matchSignature(rec->payload, rec->payloadLen, &view, &sigIndex);
+    if (sig == nullptr) {
+        if (requestScanResponse(rec, &view) && MATCH_CACHE_ENABLED) {
+            matchCache.storeUnmatched(rec->mac, payloadHash);
         }
-        idx += len + 1;
+        return;
     }
 
-    // Match against signatures
-    for (size_t i = 0; i < BUILTIN_SIGNATURE_COUNT; i++) {
-        const device_signature_t* sig = &BUILTIN_SIGNATURES[i];
-        bool matched = false;
+    // Check category filter
+    if (!(sig->category & categoryFilter)) {
+        return;
+    }
 
-        // Company ID matching
-        if ((sig->flags & SIG_FLAG_COMPANY_ID) && hasMfgData) {
-            if (sig->company_id == mfgCompanyId) {
-                matched = true;
-            }
-        }
+    // Check RSSI threshold
+    if (rec->rssi < rssiThreshold) {
+        return;
+    }
 
-        // 16-bit Service UUID matching
-        if ((sig->flags & SIG_FLAG_SERVICE_UUID) && hasServiceUuid16 && sig->service_uuid != 0) {
-            if (sig->service_uuid == serviceUuid16) {
-                if (sig->flags & SIG_FLAG_EXACT_MATCH) {
-                    matched = matched && true;
-                } else {
-                    matched = true;
-                }
-            }
-        }
+    uint32_t fingerprint = clusterFingerprint(sigIndex, rec->addrType != BLE_ADDR_TYPE_PUBLIC,
+                                              rec->payload, rec->payloadLen, &view);
 
-        // 128-bit Service UUID matching
-        if ((sig->flags & SIG_FLAG_SERVICE_UUID_128) && hasServiceUuid128 && !isUuid128Empty(sig->service_uuid_128)) {
-            if (memcmp(sig->service_uuid_128, serviceUuid128, 16) == 0) {
-                if (sig->flags & SIG_FLAG_EXACT_MATCH) {
-                    matched = matched && true;
-                } else {
-                    matched = true;
-                }
+    // A new address may be a tracker that rotated its MAC
+    bool linked = false;
+    if (existingIdx < 0) {
+        existingIdx = clusterEngine.findLink(fingerprint, rec->rssi, rec->timestamp);
+        if (existingIdx >= 0) {
+            DeviceDetail* detail = deviceTable.detail(existingIdx);
+            deviceTable.rekey(existingIdx, rec->mac);
+            if (detail->macCount < 255) {
+                detail->macCount++;
             }
+            detail->lastLinked = rec->timestamp;
+            clusterEngine.countLink();
+            linked = true;
         }
+    }
 
-        // Device name pattern matching (case-insensitive contains)
-        if ((sig->flags & SIG_FLAG_NAME_PATTERN) && deviceName.length() > 0) {
-            // Convert both to lowercase for case-insensitive matching
-            std::string lowerName = deviceName;
-            std::string lowerSig = sig->name;
-            for (auto& c : lowerName) c = tolower(c);
-            for (auto& c : lowerSig) c = tolower(c);
-
-            // Check if device name contains signature name or vice versa
-            if (lowerName.find(lowerSig) != std::string::npos ||
-                lowerSig.find(lowerName) != std::string::npos) {
-                if (sig->flags & SIG_FLAG_EXACT_MATCH) {
-                    matched = matched && true;
-                } else {
-                    matched = true;
-                }
-            }
+    if (existingIdx >= 0) {
+        // Update existing
+        DetectedDevice* dev = deviceTable.at(existingIdx);
+        updateDevice(existingIdx, rec);
+        storeAdvPayload(deviceTable.detail(existingIdx), rec, &view);
+        dev->payloadHash = payloadHash;
+        dev->fingerprint = fingerprint;
+        if (linked) {
+            detLog.append(dev->mac, dev->sigIndex, dev->rssi, DET_LOG_LINKED);
+            detEvents.post(DET_EVENT_DETECT, existingIdx);
         }
+    } else {
+        // Add new device (evicts the least recently seen one when full)
+        int index = deviceTable.insert(rec->mac, rec->timestamp);
+        if (index == DEVICE_TABLE_NONE) {
+            return;     // No detail storage (see DeviceTable::init)
+        }
+        DetectedDevice* dev = deviceTable.at(index);
+        DeviceDetail* detail = deviceTable.detail(index);
+        rssiTrackInit(&detail->track, rec->rssi, rec->timestamp);
+        dev->rssi = rssiTrackValue(&detail->track);
+        dev->category = sig->category;
+        dev->sigIndex = sigIndex;
+        dev->payloadHash = payloadHash;
+        dev->fingerprint = fingerprint;
+        detail->detectionCount = 1;
+        detail->lastLogged = rec->timestamp;
+        detail->clusterId = clusterEngine.nextId();
+        detail->macCount = 1;
+        storeAdvPayload(detail, rec, &view);
+        detLog.append(dev->mac, dev->sigIndex, dev->rssi, DET_LOG_NEW);
+
+        // Output detection event (serial task)
+        detEvents.post(DET_EVENT_DETECT, index);
+
+        // Wake screen if in power save mode (new device detected)
+        requestScreenWake();
+    }
+}
 
-        // Payload pattern matching
-        if ((sig->flags & SIG_FLAG_PAYLOAD) && sig->pattern_length > 0) {
-            bool patternFound = false;
+// Tell the UI what a batch changed. Nothing is posted while the screen is
+// off: waking up redraws everything anyway.
+static void postTableEvents(uint32_t versionBefore) {
+    if (deviceTable.getVersion() != versionBefore) {
+        batchUiEvents |= UI_EVENT_DEVICE_LIST;
+    }
+    if (!screenAsleep) {
+        uiEvents.post(batchUiEvents);
+    }
+    batchUiEvents = 0;
+}
 
-            if (sig->pattern_offset >= 0) {
-                // Match at specific offset
-                if ((size_t)(sig->pattern_offset + sig->pattern_length) <= payloadLen) {
-                    if (memcmp(payload + sig->pattern_offset,
-                              sig->payload_pattern,
-                              sig->pattern_length) == 0) {
-                        patternFound = true;
-                    }
-                }
-            } else {
-                // Search anywhere in payload
-                for (size_t j = 0; j + sig->pattern_length <= payloadLen; j++) {
-                    if (memcmp(payload + j,
-                              sig->payload_pattern,
-                              sig->pattern_length) == 0) {
-                        patternFound = true;
-                        break;
-                    }
-                }
-            }
+// Drain the scan queue in batches (match task). The device table is locked
+// per batch, so readers wait at most one batch.
+void processScanResults() {
+    adv_record_t batch[ADV_DRAIN_BATCH];
+    size_t processed = 0;
 
-            if (sig->flags & SIG_FLAG_EXACT_MATCH) {
-                matched = matched && patternFound;
-            } else {
-                matched = matched || patternFound;
+    while (processed < ADV_RING_SIZE) {
+        size_t count = bleScanner.drain(batch, ADV_DRAIN_BATCH);
+        for (size_t i = 0; i < count; i++) {
+            rawStreamPush(&batch[i]);
+        }
+        if (count > 0) {
+            DeviceTableLock lock;
+            uint32_t version = deviceTable.getVersion();
+            for (size_t i = 0; i < count; i++) {
+                processAdvRecord(&batch[i]);
             }
+            postTableEvents(version);
         }
-
-        if (matched) {
-            return sig;
+        processed += count;
+        if (count < ADV_DRAIN_BATCH) {
+            break;
         }
     }
-
-    return nullptr;
 }
 
 // =============================================================================
@@ -365,7 +399,23 @@ const char* getCategoryString(uint8_t category) {
 // =============================================================================
 // SERIAL OUTPUT
 // =============================================================================
-void outputDetection(const DetectedDevice* device) {
+void outputDetection(const device_snapshot_t* snap) {
+    const DetectedDevice* device = &snap->dev;
+    const DeviceDetail* detail = &snap->detail;
+    const device_signature_t* sig = deviceSignature(device);
+    if (binaryOutput) {
+        bin_detect_t rec;
+        rec.timestamp = millis();
+        memcpy(rec.mac, device->mac, 6);
+        rec.rssi = device->rssi;
+        rec.sigId = device->sigIndex >= 0 ? device->sigIndex : BIN_SIG_NONE;
+        rec.category = device->category;
+        rec.threatLevel = sig->threat_level;
+        rec.companyId = sig->company_id;
+        binSendFrame(BIN_FRAME_DETECT, &rec, sizeof(rec));
+        return;
+    }
+
     char macStr[18];
     snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
              device->mac[0], device->mac[1], device->mac[2],
@@ -374,18 +424,157 @@ void outputDetection(const DetectedDevice* device) {
     const char* catStr = getCategoryString(device->category);
 
     if (jsonOutput) {
+        // Manufacturer data (company ID onward) as hex, per the event format
+        char payloadHex[ADV_RECORD_PAYLOAD_MAX * 2 + 1];
+        payloadHex[0] = '\0';
+        if (advHasMfgData(&detail->view)) {
+            const uint8_t* mfg = detail->payload + detail->view.mfgOffset;
+            for (uint8_t i = 0; i < detail->view.mfgLen; i++) {
+                snprintf(&payloadHex[i * 2], 3, "%02X", mfg[i]);
+            }
+        }
+
         Serial.printf("{\"event\":\"detect\",\"ts\":%lu,\"device\":\"%s\","
                       "\"mac\":\"%s\",\"rssi\":%d,\"category\":\"%s\","
-                      "\"company_id\":\"0x%04X\"}\n",
-                      millis(), device->name, macStr, device->rssi,
-                      catStr, device->companyId);
+                      "\"company_id\":\"0x%04X\",\"payload\":\"%s\","
+                      "\"cluster\":%u,\"macs\":%u}\n",
+                      millis(), sig->name, macStr, device->rssi,
+                      catStr, sig->company_id, payloadHex,
+                      detail->clusterId, detail->macCount);
+    } else {
+        Serial.printf("[%lu] DETECT %s MAC=%s RSSI=%d CAT=%s CLUSTER=%u MACS=%u\n",
+                      millis(), sig->name, macStr, device->rssi, catStr,
+                      detail->clusterId, detail->macCount);
+    }
+}
+
+void outputFollower(const device_snapshot_t* snap) {
+    const DetectedDevice* device = &snap->dev;
+    const DeviceDetail* detail = &snap->detail;
+    const char* name = deviceSignature(device)->name;
+    uint32_t dwellSec = rssiTrackDwellMs(&detail->track) / 1000;
+    if (binaryOutput) {
+        bin_follower_t rec;
+        rec.timestamp = millis();
+        memcpy(rec.mac, device->mac, 6);
+        rec.rssi = device->rssi;
+        rec.sigId = device->sigIndex >= 0 ? device->sigIndex : BIN_SIG_NONE;
+        rec.clusterId = detail->clusterId;
+        rec.dwellSec = dwellSec;
+        binSendFrame(BIN_FRAME_FOLLOWER, &rec, sizeof(rec));
+        return;
+    }
+
+    char macStr[18];
+    snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
+             device->mac[0], device->mac[1], device->mac[2],
+             device->mac[3], device->mac[4], device->mac[5]);
+
+    if (jsonOutput) {
+        Serial.printf("{\"event\":\"follower\",\"ts\":%lu,\"device\":\"%s\","
+                      "\"mac\":\"%s\",\"rssi\":%d,\"cluster\":%u,\"macs\":%u,"
+                      "\"dwell_s\":%lu}\n",
+                      millis(), name, macStr, device->rssi,
+                      detail->clusterId, detail->macCount, dwellSec);
     } else {
-        Serial.printf("[%lu] DETECT %s MAC=%s RSSI=%d CAT=%s\n",
-                      millis(), device->name, macStr, device->rssi, catStr);
+        Serial.printf("[%lu] FOLLOWER %s MAC=%s RSSI=%d CLUSTER=%u DWELL=%lus\n",
+                      millis(), name, macStr, device->rssi,
+                      detail->clusterId, dwellSec);
+    }
+}
+
+// One record per device in a packet from an uplink node (collector)
+void outputRemote(const uplink_packet_t* pkt) {
+    const uplink_header_t* hdr = (const uplink_header_t*)pkt->data;
+    char nodeStr[18];
+    snprintf(nodeStr, sizeof(nodeStr), "%02X:%02X:%02X:%02X:%02X:%02X",
+             pkt->node[0], pkt->node[1], pkt->node[2],
+             pkt->node[3], pkt->node[4], pkt->node[5]);
+
+    if (pkt->lost > 0 && !binaryOutput) {
+        if (jsonOutput) {
+            Serial.printf("{\"event\":\"uplink_loss\",\"ts\":%lu,\"node\":\"%s\","
+                          "\"seq\":%u,\"lost\":%lu}\n",
+                          pkt->received, nodeStr, hdr->seq, pkt->lost);
+        } else {
+            Serial.printf("[%lu] UPLINK_LOSS node=%s seq=%u lost=%lu\n",
+                          pkt->received, nodeStr, hdr->seq, pkt->lost);
+        }
+    }
+
+    uplink_entry_t e;
+    size_t pos = sizeof(uplink_header_t);
+    for (uint8_t n = 0; n < hdr->count && uplinkNextEntry(pkt->data, pkt->len, &pos, &e); n++) {
+        if (binaryOutput) {
+            bin_remote_t rec;
+            rec.timestamp = pkt->received;
+            memcpy(rec.node, pkt->node, 6);
+            rec.seq = hdr->seq;
+            rec.lost = pkt->lost > 0xFFFF ? 0xFFFF : (uint16_t)pkt->lost;
+            rec.fields = e.fields;
+            memcpy(rec.mac, e.mac, 6);
+            rec.rssi = e.rssi;
+            rec.sigId = e.sigId;
+            rec.category = e.category;
+            rec.threatLevel = e.threatLevel;
+            rec.ageMs = e.ageMs;
+            binSendFrame(BIN_FRAME_REMOTE, &rec, sizeof(rec));
+            continue;
+        }
+
+        char macStr[18];
+        snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
+                 e.mac[0], e.mac[1], e.mac[2], e.mac[3], e.mac[4], e.mac[5]);
+
+        // Only the fields the node sent
+        char fields[96];
+        int len = 0;
+        fields[0] = '\0';
+        if (e.fields & UPLINK_FIELD_GONE) {
+            len += snprintf(&fields[len], sizeof(fields) - len, jsonOutput ? ",\"gone\":true" : " GONE");
+        }
+        if (e.fields & UPLINK_FIELD_SIG) {
+            len += snprintf(&fields[len], sizeof(fields) - len,
+                            jsonOutput ? ",\"sig_id\":%u,\"category\":\"%s\",\"threat\":%u"
+                                       : " SIG=%u CAT=%s THREAT=%u",
+                            e.sigId, getCategoryString(e.category), e.threatLevel);
+        }
+        if (e.fields & UPLINK_FIELD_RSSI) {
+            len += snprintf(&fields[len], sizeof(fields) - len,
+                            jsonOutput ? ",\"rssi\":%d" : " RSSI=%d", e.rssi);
+        }
+        if (e.fields & UPLINK_FIELD_SEEN) {
+            snprintf(&fields[len], sizeof(fields) - len,
+                     jsonOutput ? ",\"age_ms\":%lu" : " AGE=%lums", e.ageMs);
+        }
+
+        if (jsonOutput) {
+            Serial.printf("{\"event\":\"remote\",\"ts\":%lu,\"node\":\"%s\",\"seq\":%u,"
+                          "\"mac\":\"%s\"%s}\n",
+                          pkt->received, nodeStr, hdr->seq, macStr, fields);
+        } else {
+            Serial.printf("[%lu] REMOTE node=%s seq=%u MAC=%s%s\n",
+                          pkt->received, nodeStr, hdr->seq, macStr, fields);
+        }
     }
 }
 
 void outputTxEvent(const char* event, const char* device, uint32_t intervalMs, int32_t count, uint32_t sent) {
+    if (binaryOutput) {
+        bin_tx_event_t rec;
+        const device_signature_t* sig = txManager.findSignatureByName(device);
+        int sigIndex = sig != nullptr ? sigDb.indexOf(sig) : -1;
+        rec.timestamp = millis();
+        rec.event = strcmp(event, "tx_start") == 0 ? BIN_TX_START :
+                    strcmp(event, "tx_stop") == 0 ? BIN_TX_STOP : BIN_TX_STOP_ALL;
+        rec.sigId = (rec.event != BIN_TX_STOP_ALL && sigIndex >= 0) ? sigIndex : BIN_SIG_NONE;
+        rec.intervalMs = intervalMs;
+        rec.count = count;
+        rec.packetsSent = sent;
+        binSendFrame(BIN_FRAME_TX_EVENT, &rec, sizeof(rec));
+        return;
+    }
+
     if (jsonOutput) {
         if (strcmp(event, "tx_start") == 0) {
             Serial.printf("{\"event\":\"%s\",\"ts\":%lu,\"device\":\"%s\","
@@ -415,379 +604,865 @@ void outputTxEvent(const char* event, const char* device, uint32_t intervalMs, i
 // =============================================================================
 // SERIAL COMMAND PROCESSING
 // =============================================================================
-void processSerialCommand(const char* cmd) {
-    // Keep original for case-sensitive parsing
-    String origCmd = String(cmd);
-    origCmd.trim();
-
-    // Convert to uppercase for command matching
-    String cmdStr = origCmd;
-    cmdStr.toUpperCase();
-
-    // =========================================================================
-    // HELP & INFO
-    // =========================================================================
-    if (cmdStr == "HELP") {
-        Serial.println("BLEPTD Commands:");
-        Serial.println("  HELP              - Show this help");
-        Serial.println("  VERSION           - Show firmware version");
-        Serial.println("  STATUS            - Current status");
-        Serial.println("");
-        Serial.println("Scanning:");
-        Serial.println("  SCAN START        - Begin BLE scanning");
-        Serial.println("  SCAN STOP         - Stop BLE scanning");
-        Serial.println("  SCAN CLEAR        - Clear detected devices");
-        Serial.println("  SCAN LIST         - List detected devices");
-        Serial.println("");
-        Serial.println("Transmission:");
-        Serial.println("  TX LIST           - List transmittable devices");
-        Serial.println("  TX START <device> [interval_ms] [count]");
-        Serial.println("  TX STOP <device|ALL>");
-        Serial.println("  TX STATUS         - Show active transmissions");
-        Serial.println("");
-        Serial.println("Confusion Mode:");
-        Serial.println("  CONFUSE ADD <device> [count]");
-        Serial.println("  CONFUSE REMOVE <device>");
-        Serial.println("  CONFUSE LIST      - Show confusion entries");
-        Serial.println("  CONFUSE START     - Start confusion broadcast");
-        Serial.println("  CONFUSE STOP      - Stop confusion broadcast");
-        Serial.println("  CONFUSE CLEAR     - Clear all entries");
-        Serial.println("");
-        Serial.println("Other:");
-        Serial.println("  JSON <ON|OFF>     - Toggle JSON output");
-        Serial.println("  DISPLAY SCREEN <N> - Switch screen (0-3)");
-        Serial.println("");
-        Serial.println("Power Save:");
-        Serial.println("  POWERSAVE STATUS  - Show power save status");
-        Serial.println("  POWERSAVE ON/OFF  - Enable/disable power save");
-        Serial.println("  POWERSAVE TIMEOUT <sec> - Set timeout (10-3600s)");
-        Serial.println("  POWERSAVE WAKE    - Wake screen immediately");
-        Serial.println("OK");
-    }
-    else if (cmdStr == "VERSION") {
-        Serial.printf("BLEPTD v%s (%s)\n", BLEPTD_VERSION, BLEPTD_VARIANT_STRING);
-        Serial.println("OK");
-    }
-    else if (cmdStr == "STATUS") {
-        Serial.printf("Scanning: %s\n", scanning ? "ON" : "OFF");
-        Serial.printf("TX Sessions: %d active\n", txManager.getActiveCount());
-        Serial.printf("Confusion: %s (%d entries)\n",
-                      txManager.isConfusionActive() ? "ON" : "OFF",
-                      txManager.getConfusionEntryCount());
-        Serial.printf("Total TX Packets: %lu\n", txManager.getTotalPacketsSent());
-        Serial.printf("Detected: %d devices\n", detectedCount);
-        Serial.printf("Filter: 0x%02X\n", categoryFilter);
-        Serial.printf("RSSI Threshold: %d dBm\n", rssiThreshold);
-        Serial.println("OK");
-    }
-
-    // =========================================================================
-    // SCANNING COMMANDS
-    // =========================================================================
-    else if (cmdStr == "SCAN START") {
-        scanning = true;
-        Serial.println("OK Scanning started");
-    }
-    else if (cmdStr == "SCAN STOP") {
-        scanning = false;
-        pBLEScan->stop();
-        Serial.println("OK Scanning stopped");
-    }
-    else if (cmdStr == "SCAN CLEAR") {
-        detectedCount = 0;
-        memset(detectedDevices, 0, sizeof(detectedDevices));
-        Serial.println("OK Devices cleared");
-    }
-    else if (cmdStr == "SCAN LIST") {
-        for (int i = 0; i < detectedCount; i++) {
-            outputDetection(&detectedDevices[i]);
-        }
-        Serial.printf("Total: %d devices\n", detectedCount);
-        Serial.println("OK");
-    }
-
-    // =========================================================================
-    // TX COMMANDS
-    // =========================================================================
-    else if (cmdStr == "TX LIST") {
-        Serial.println("Transmittable Devices:");
-        int count = txManager.getTransmittableCount();
-        for (int i = 0; i < count; i++) {
-            const device_signature_t* sig = txManager.getTransmittableSignature(i);
-            if (sig) {
-                Serial.printf("  [%d] %s (0x%04X) - %s\n",
-                              i, sig->name, sig->company_id,
-                              getCategoryString(sig->category));
-            }
-        }
-        Serial.printf("Total: %d devices\n", count);
-        Serial.println("OK");
-    }
-    else if (cmdStr.startsWith("TX START ")) {
-        // Parse: TX START <device> [interval_ms] [count]
-        String args = origCmd.substring(9);
-        args.trim();
-
-        // Parse arguments
-        String deviceName;
-        uint32_t interval = TX_DEFAULT_INTERVAL_MS;
-        int32_t count = -1;
-
-        // Find device name (may be quoted)
-        int argStart = 0;
-        if (args.charAt(0) == '"') {
-            int endQuote = args.indexOf('"', 1);
-            if (endQuote > 0) {
-                deviceName = args.substring(1, endQuote);
-                argStart = endQuote + 1;
-            }
-        } else {
-            int space = args.indexOf(' ');
-            if (space > 0) {
-                deviceName = args.substring(0, space);
-                argStart = space + 1;
-            } else {
-                deviceName = args;
-                argStart = args.length();
-            }
-        }
+// Each handler gets the tokens after the command name; see COMMANDS below
+
+// =========================================================================
+// HELP & INFO
+// =========================================================================
+static void cmdHelp(char** argv, uint8_t argc) {
+    Serial.println("BLEPTD Commands:");
+    Serial.println("  HELP              - Show this help");
+    Serial.println("  VERSION           - Show firmware version");
+    Serial.println("  STATUS            - Current status");
+    Serial.println("  STATS [RESET]     - Per-stage timing histograms");
+    Serial.println("");
+    Serial.println("Scanning:");
+    Serial.println("  SCAN START        - Begin BLE scanning");
+    Serial.println("  SCAN STOP         - Stop BLE scanning");
+    Serial.println("  SCAN CLEAR        - Clear detected devices");
+    Serial.println("  SCAN LIST         - List detected devices");
+    Serial.println("  SCAN DUPFILTER <ON|OFF> - Controller duplicate filter");
+    Serial.println("  SCAN SAMPLE <ms>  - RSSI sample period with DUPFILTER");
+    Serial.println("");
+    Serial.println("Allow List:");
+    Serial.println("  IGNORE ADD <mac>  - Never match or list this device");
+    Serial.println("  IGNORE REMOVE <mac> - Detect it again");
+    Serial.println("  IGNORE LIST       - Show ignored devices");
+    Serial.println("  IGNORE CLEAR      - Empty the allow list");
+    Serial.println("");
+    Serial.println("Detection Log:");
+    Serial.println("  LOG STATUS        - Journal state");
+    Serial.println("  LOG DUMP          - Print all logged detections");
+    Serial.println("  LOG CLEAR         - Erase the journal");
+    Serial.println("");
+    Serial.println("Signatures:");
+    Serial.println("  SIG LIST          - List device signatures");
+    Serial.println("");
+    Serial.println("Transmission:");
+    Serial.println("  TX LIST           - List transmittable devices");
+    Serial.println("  TX START <device> [interval_ms] [count]");
+    Serial.println("  TX STOP <device|ALL>");
+    Serial.println("  TX STATUS         - Show active transmissions");
+    Serial.println("  TX PAYLOAD <STATIC|RANDOM> - Fixed or per-packet filler bytes");
+    Serial.println("");
+    Serial.println("Confusion Mode:");
+    Serial.println("  CONFUSE ADD <device> [count]");
+    Serial.println("  CONFUSE REMOVE <device>");
+    Serial.println("  CONFUSE LIST      - Show confusion entries");
+    Serial.println("  CONFUSE START     - Start confusion broadcast");
+    Serial.println("  CONFUSE STOP      - Stop confusion broadcast");
+    Serial.println("  CONFUSE CLEAR     - Clear all entries");
+    Serial.println("");
+    Serial.println("Other:");
+    Serial.println("  JSON <ON|OFF>     - Toggle JSON output");
+    Serial.println("  BINARY <ON|OFF>   - Toggle COBS framed binary events");
+    Serial.println("  BAUD <rate>       - Change serial baud rate");
+    Serial.println("  STREAM <RAW|OFF>  - Stream every advertisement (binary)");
+    Serial.println("  DISPLAY SCREEN <N> - Switch screen (0-3)");
+    Serial.println("");
+    Serial.println("Uplink (ESP-NOW):");
+    Serial.println("  UPLINK STATUS     - Mode, counters, nodes heard");
+    Serial.println("  UPLINK NODE [mac] - Send to a collector (default broadcast)");
+    Serial.println("  UPLINK COLLECTOR  - Receive from nodes and print them");
+    Serial.println("  UPLINK OFF        - Stop the uplink");
+    Serial.println("  UPLINK INTERVAL <ms> - Batch period");
+    Serial.println("  UPLINK CHANNEL <1-13> - Wi-Fi channel, same on all units");
+    Serial.println("");
+    Serial.println("Power Save:");
+    Serial.println("  POWERSAVE STATUS  - Show power save status");
+    Serial.println("  POWERSAVE ON/OFF  - Enable/disable power save");
+    Serial.println("  POWERSAVE TIMEOUT <sec> - Set timeout (10-3600s)");
+    Serial.println("  POWERSAVE WAKE    - Wake screen immediately");
+    Serial.println("");
+    Serial.println("Several commands can share a line, separated by ';'.");
+    Serial.println("Quote names that contain spaces: TX START \"Meta Ray-Ban\"");
+    Serial.println("OK");
+}
 
-        // Parse optional interval and count
-        if (argStart < (int)args.length()) {
-            String remaining = args.substring(argStart);
-            remaining.trim();
-            int space = remaining.indexOf(' ');
-            if (space > 0) {
-                interval = remaining.substring(0, space).toInt();
-                count = remaining.substring(space + 1).toInt();
-            } else if (remaining.length() > 0) {
-                interval = remaining.toInt();
-            }
-        }
+static void cmdVersion(char** argv, uint8_t argc) {
+    Serial.printf("BLEPTD v%s (%s)\n", BLEPTD_VERSION, BLEPTD_VARIANT_STRING);
+    Serial.println("OK");
+}
 
-        if (deviceName.length() == 0) {
-            Serial.println("ERROR 102 Missing device name");
-        } else {
-            // Stop any active scan before starting TX
-            if (scanning) {
-                pBLEScan->stop();
-                delay(50);  // Give BLE stack time to stop scan
-            }
+static void cmdStatus(char** argv, uint8_t argc) {
+    Serial.printf("Scanning: %s\n", scanning ? "ON" : "OFF");
+    Serial.printf("Scanner: %s (%lu restarts)\n",
+                  bleScanner.isRunning() ? "RUNNING" : "PAUSED",
+                  bleScanner.getRestartCount());
+    Serial.printf("Scan Params: %u/%u ms (%u%% duty), %s, %.1f adv/s [%s]\n",
+                  scanScheduler.getIntervalMs(), scanScheduler.getWindowMs(),
+                  scanScheduler.getDutyPct(), scanScheduler.isActiveScan() ? "active" : "passive",
+                  scanScheduler.getAdvRate(), scanScheduler.getReasonString());
+    Serial.printf("Hybrid Scan: %s, %d responses cached, %lu merged, %lu active bursts\n",
+                  BLE_HYBRID_SCAN ? "hybrid" : "off", scanRspCache.count(),
+                  scanRspCache.getMergedCount(), scanScheduler.getBurstCount());
+    Serial.printf("Match Cache: %s, %lu repeats, %lu unmatched repeats, %lu matcher runs; "
+                  "dup filter %s (%u ms)\n",
+                  MATCH_CACHE_ENABLED ? "ON" : "OFF", matchCache.getKnownHits(),
+                  matchCache.getUnmatchedHits(), matchCache.getMisses(),
+                  bleScanner.isDuplicateFilterEnabled() ? "ON" : "OFF",
+                  bleScanner.getDuplicateResetMs());
+    Serial.printf("TX Sessions: %d active\n", txManager.getActiveCount());
+    Serial.printf("Confusion: %s (%d entries)\n",
+                  txManager.isConfusionActive() ? "ON" : "OFF",
+                  txManager.getConfusionEntryCount());
+    Serial.printf("Total TX Packets: %lu\n", txManager.getTotalPacketsSent());
+    Serial.printf("Detected: %d/%d devices (%lu evicted, %lu MAC rotations linked)\n",
+                  deviceTable.count(), deviceTable.capacity(),
+                  deviceTable.getEvictedCount(), clusterEngine.getLinkCount());
+    Serial.printf("Device Storage: %u B hot, %u B detail in %s\n",
+                  (unsigned)deviceTable.getHotBytes(), (unsigned)deviceTable.getDetailBytes(),
+                  deviceTable.isDetailInPsram() ? "PSRAM" : "internal RAM");
+    Serial.printf("Scan Queue: %u pending, %lu dropped\n",
+                  (unsigned)bleScanner.getQueuedCount(), bleScanner.getDroppedCount());
+    Serial.printf("Events: %lu posted, %lu dropped, %u queued\n",
+                  detEvents.getPostedCount(), detEvents.getDroppedCount(),
+                  (unsigned)detEvents.getQueuedCount());
+    Serial.printf("UI: %lu frames, %lu events\n",
+                  uiEvents.getFrameCount(), uiEvents.getPostedCount());
+    Serial.printf("Power: %s, %lu MHz, %.1f wakeups/s, ~%u mA\n",
+                  powerMgr.isLightSleepActive() ? "light sleep" : (powerMgr.isIdle() ? "idle" : "active"),
+                  ESP.getCpuFreqMHz(), powerMgr.getWakeupRate(),
+                  powerMgr.estimateCurrentMa(scanning ? scanScheduler.getDutyPct() : 0, !screenAsleep));
+    Serial.printf("Allow List: %d/%d devices, %lu reports ignored, %lu false positives\n",
+                  allowList.count(), ALLOW_LIST_MAX, allowList.getIgnoredCount(),
+                  allowList.getFalsePositives());
+    Serial.printf("Uplink: %s, ch %u, %lu packets sent (%lu failed), %lu received (%lu lost)\n",
+                  uplink.getModeString(), uplink.getChannel(), uplink.getSentCount(),
+                  uplink.getFailedCount(), uplink.getReceivedCount(), uplink.getLostCount());
+    Serial.printf("Signatures: %d (%d loaded, %d overrides)\n", sigDb.count(),
+                  sigDb.getLoadedCount(), sigDb.getOverrideCount());
+    Serial.printf("Filter: 0x%02X\n", categoryFilter);
+    Serial.printf("RSSI Threshold: %d dBm\n", rssiThreshold);
+    Serial.printf("Serial: %lu baud, %s output, %lu frames (%lu dropped)\n",
+                  serialBaudRate, binaryOutput ? "binary" : (jsonOutput ? "JSON" : "text"),
+                  binGetFramesSent(), binGetFramesDropped());
+    Serial.printf("Raw Stream: %s (%lu sent, %lu dropped)\n",
+                  rawStreamIsEnabled() ? "ON" : "OFF",
+                  rawStreamGetSent(), rawStreamGetDropped());
+    Serial.printf("Detection Log: %s (%lu written, %lu dropped)\n",
+                  detLog.isReady() ? "ON" : "OFF",
+                  detLog.getWrittenCount(), detLog.getDroppedCount());
+    Serial.println("OK");
+}
 
-            // Use consistent MAC for standard TX (randomMac=false)
-            // MAC is generated once at session start, stays same until stop
-            int result = txManager.startTx(deviceName.c_str(), interval, count, false);
-            if (result >= 0) {
-                txActive = true;
-                outputTxEvent("tx_start", deviceName.c_str(), interval, count, 0);
-                Serial.println("OK TX started");
-            } else if (result == -1) {
-                Serial.printf("ERROR 103 Device not found: %s\n", deviceName.c_str());
-            } else if (result == -2) {
-                Serial.printf("ERROR 105 Already transmitting: %s\n", deviceName.c_str());
-            } else if (result == -3) {
-                Serial.println("ERROR 105 No free TX slots");
-            }
-        }
+static void cmdStats(char** argv, uint8_t argc) {
+#if PERF_STATS_ENABLED
+    perfPrint(jsonOutput);
+    Serial.println("OK");
+#else
+    Serial.println("ERROR 104 Built without PERF_STATS_ENABLED");
+#endif
+}
+
+static void cmdStatsReset(char** argv, uint8_t argc) {
+#if PERF_STATS_ENABLED
+    perfReset();
+    Serial.println("OK Statistics reset");
+#else
+    Serial.println("ERROR 104 Built without PERF_STATS_ENABLED");
+#endif
+}
+
+// =========================================================================
+// SCANNING COMMANDS
+// =========================================================================
+static void cmdScanStart(char** argv, uint8_t argc) {
+    scanning = true;
+    uiEvents.post(UI_EVENT_MODE);
+    Serial.println("OK Scanning started");
+}
+
+static void cmdScanStop(char** argv, uint8_t argc) {
+    scanning = false;
+    bleScanner.stop();
+    uiEvents.post(UI_EVENT_MODE);
+    Serial.println("OK Scanning stopped");
+}
+
+static void cmdScanClear(char** argv, uint8_t argc) {
+    DeviceTableLock lock;
+    deviceTable.clear();
+    matchCache.clear();
+    uiEvents.post(UI_EVENT_DEVICE_LIST);
+    Serial.println("OK Devices cleared");
+}
+
+static void cmdScanDupFilter(char** argv, uint8_t argc) {
+    if (argc < 1) {
+        Serial.println("ERROR 102 Missing ON|OFF");
+        return;
     }
-    else if (cmdStr.startsWith("TX STOP ")) {
-        String deviceName = origCmd.substring(8);
-        deviceName.trim();
+    bool enable;
+    if (strcasecmp(argv[0], "ON") == 0) {
+        enable = true;
+    } else if (strcasecmp(argv[0], "OFF") == 0) {
+        enable = false;
+    } else {
+        Serial.println("ERROR 101 Expected ON or OFF");
+        return;
+    }
+    bleScanner.setDuplicateFilter(enable, bleScanner.getDuplicateResetMs());
+    Serial.printf("OK Duplicate filter %s\n", enable ? "ON" : "OFF");
+}
 
-        if (deviceName.equalsIgnoreCase("ALL")) {
-            txManager.stopAll();
-            txActive = false;
-            outputTxEvent("tx_stop_all", "ALL", 0, 0, txManager.getTotalPacketsSent());
-            Serial.println("OK All TX stopped");
-        } else {
-            tx_session_t* session = txManager.findSession(deviceName.c_str());
-            uint32_t sent = session ? session->packetsSent : 0;
-
-            int result = txManager.stopTx(deviceName.c_str());
-            if (result == 0) {
-                outputTxEvent("tx_stop", deviceName.c_str(), 0, 0, sent);
-                txActive = txManager.getActiveCount() > 0;
-                Serial.println("OK TX stopped");
-            } else {
-                Serial.printf("ERROR 103 Device not found or not transmitting: %s\n", deviceName.c_str());
-            }
-        }
+static void cmdScanSample(char** argv, uint8_t argc) {
+    uint32_t ms = 0;
+    if (argc >= 1 && cmdParseUint(argv[0], &ms) &&
+        ms >= BLE_RSSI_SAMPLE_MIN_MS && ms <= 60000) {
+        bleScanner.setDuplicateFilter(bleScanner.isDuplicateFilterEnabled(), ms);
+        Serial.printf("OK RSSI sample period set to %lu ms\n", ms);
+    } else {
+        Serial.printf("ERROR 101 Period must be %d-60000 ms\n", BLE_RSSI_SAMPLE_MIN_MS);
     }
-    else if (cmdStr == "TX STATUS") {
-        Serial.println("Active TX Sessions:");
-        int activeCount = 0;
-        for (int i = 0; i < TX_MAX_CONCURRENT; i++) {
-            tx_session_t* session = txManager.getSession(i);
-            if (session && session->active) {
-                Serial.printf("  [%d] %s - %lu pkts @ %lums (remaining: %ld)\n",
-                              i, session->deviceName, session->packetsSent,
-                              session->intervalMs, session->remainingCount);
-                activeCount++;
+}
+
+// Each device is copied under the lock and printed after releasing it
+static void cmdScanList(char** argv, uint8_t argc) {
+    device_snapshot_t dev;
+    int printed = 0;
+    for (;;) {
+        {
+            DeviceTableLock lock;
+            if (printed >= deviceTable.count()) {
+                break;
             }
+            deviceTable.snapshot(printed, &dev);
         }
-        if (activeCount == 0) {
-            Serial.println("  (none)");
-        }
-        Serial.printf("Total packets sent: %lu\n", txManager.getTotalPacketsSent());
-        Serial.println("OK");
+        outputDetection(&dev);
+        printed++;
     }
+    Serial.printf("Total: %d devices\n", printed);
+    Serial.println("OK");
+}
+
+// =========================================================================
+// ALLOW LIST COMMANDS
+// =========================================================================
+static void cmdIgnoreAdd(char** argv, uint8_t argc) {
+    uint8_t mac[6];
+    if (argc < 1) {
+        Serial.println("ERROR 102 Missing MAC address");
+        return;
+    }
+    if (!macParse(argv[0], mac)) {
+        Serial.println("ERROR 101 Invalid MAC address");
+        return;
+    }
+    int rc = allowList.add(mac);
+    if (rc < 0) {
+        Serial.printf("ERROR 105 Allow list full (%d entries)\n", ALLOW_LIST_MAX);
+    } else {
+        // An existing table entry stops updating and ages out
+        Serial.printf("OK Ignoring %s%s\n", argv[0], rc > 0 ? " (already listed)" : "");
+    }
+}
 
-    // =========================================================================
-    // CONFUSION MODE COMMANDS
-    // =========================================================================
-    else if (cmdStr.startsWith("CONFUSE ADD ")) {
-        String args = origCmd.substring(12);
-        args.trim();
+static void cmdIgnoreRemove(char** argv, uint8_t argc) {
+    uint8_t mac[6];
+    if (argc < 1) {
+        Serial.println("ERROR 102 Missing MAC address");
+        return;
+    }
+    if (!macParse(argv[0], mac)) {
+        Serial.println("ERROR 101 Invalid MAC address");
+        return;
+    }
+    if (allowList.remove(mac)) {
+        Serial.printf("OK %s is detected again\n", argv[0]);
+    } else {
+        Serial.println("ERROR 103 Not in allow list");
+    }
+}
 
-        String deviceName;
-        uint8_t instanceCount = 1;
+static void cmdIgnoreList(char** argv, uint8_t argc) {
+    for (int i = 0; i < allowList.count(); i++) {
+        const uint8_t* m = allowList.at(i);
+        Serial.printf("%02X:%02X:%02X:%02X:%02X:%02X\n", m[0], m[1], m[2], m[3], m[4], m[5]);
+    }
+    Serial.printf("Total: %d/%d devices, %u bytes, est. false positive rate %.3f%%\n",
+                  allowList.count(), ALLOW_LIST_MAX, (unsigned)allowList.getMemoryBytes(),
+                  allowList.getEstimatedFpRate() * 100.0f);
+    Serial.println("OK");
+}
 
-        // Parse device name and optional count
-        int space = args.lastIndexOf(' ');
-        if (space > 0) {
-            String lastPart = args.substring(space + 1);
-            if (lastPart.toInt() > 0) {
-                instanceCount = lastPart.toInt();
-                deviceName = args.substring(0, space);
-            } else {
-                deviceName = args;
-            }
-        } else {
-            deviceName = args;
-        }
+static void cmdIgnoreClear(char** argv, uint8_t argc) {
+    allowList.clear();
+    Serial.println("OK Allow list cleared");
+}
 
-        deviceName.trim();
+// =========================================================================
+// DETECTION LOG COMMANDS
+// =========================================================================
+static bool requireLog() {
+    if (!detLog.isReady()) {
+        Serial.println("ERROR 104 Detection log unavailable (SPIFFS)");
+        return false;
+    }
+    return true;
+}
 
-        int result = txManager.confuseAdd(deviceName.c_str(), instanceCount);
-        if (result >= 0) {
-            Serial.printf("OK Added %s x%d to confusion list\n", deviceName.c_str(), instanceCount);
-        } else if (result == -1) {
-            Serial.printf("ERROR 103 Device not found: %s\n", deviceName.c_str());
-        } else {
-            Serial.println("ERROR 105 Confusion list full");
+static void cmdLogStatus(char** argv, uint8_t argc) {
+    if (!requireLog()) {
+        return;
+    }
+    Serial.printf("Boot: %u\n", detLog.getBootId());
+    Serial.printf("Segment: %u of %d (%lu/%d bytes)\n", detLog.getSegment(),
+                  DET_LOG_SEGMENTS, detLog.getSegmentBytes(), DET_LOG_SEGMENT_SIZE);
+    Serial.printf("Records: %lu written, %u buffered, %lu dropped\n",
+                  detLog.getWrittenCount(), detLog.getBufferedCount(),
+                  detLog.getDroppedCount());
+    Serial.printf("Flushes: %lu\n", detLog.getFlushCount());
+    Serial.println("OK");
+}
+
+static void cmdLogDump(char** argv, uint8_t argc) {
+    if (!requireLog()) {
+        return;
+    }
+    int count = detLog.dump(jsonOutput);
+    Serial.printf("Total: %d records\n", count);
+    Serial.println("OK");
+}
+
+static void cmdLogClear(char** argv, uint8_t argc) {
+    if (!requireLog()) {
+        return;
+    }
+    detLog.clear();
+    Serial.println("OK Detection log cleared");
+}
+
+// =========================================================================
+// SIGNATURE COMMANDS
+// =========================================================================
+static void cmdSigList(char** argv, uint8_t argc) {
+    Serial.println("Device Signatures:");
+    for (int i = 0; i < sigDb.count(); i++) {
+        const device_signature_t* sig = sigDb.get(i);
+        Serial.printf("  [%d] %s (0x%04X) - %s, threat %d, flags 0x%04lX\n",
+                      i, sig->name, sig->company_id,
+                      getCategoryString(sig->category), sig->threat_level,
+                      (unsigned long)sig->flags);
+    }
+    Serial.printf("Total: %d signatures (%d loaded from SPIFFS)\n",
+                  sigDb.count(), sigDb.getLoadedCount());
+    Serial.println("OK");
+}
+
+// =========================================================================
+// TX COMMANDS
+// =========================================================================
+static void cmdTxList(char** argv, uint8_t argc) {
+    Serial.println("Transmittable Devices:");
+    int count = txManager.getTransmittableCount();
+    for (int i = 0; i < count; i++) {
+        const device_signature_t* sig = txManager.getTransmittableSignature(i);
+        if (sig) {
+            Serial.printf("  [%d] %s (0x%04X) - %s\n",
+                          i, sig->name, sig->company_id,
+                          getCategoryString(sig->category));
         }
     }
-    else if (cmdStr.startsWith("CONFUSE REMOVE ")) {
-        String deviceName = origCmd.substring(15);
-        deviceName.trim();
+    Serial.printf("Total: %d devices\n", count);
+    Serial.println("OK");
+}
 
-        int result = txManager.confuseRemove(deviceName.c_str());
-        if (result == 0) {
-            Serial.printf("OK Removed %s from confusion list\n", deviceName.c_str());
-        } else {
-            Serial.printf("ERROR 103 Device not in list: %s\n", deviceName.c_str());
+// TX START <device> [interval_ms] [count]; quote names containing spaces
+static void cmdTxStart(char** argv, uint8_t argc) {
+    uint32_t interval = TX_DEFAULT_INTERVAL_MS;
+    int32_t count = -1;
+
+    if (argc == 0 || argv[0][0] == '\0') {
+        Serial.println("ERROR 102 Missing device name");
+        return;
+    }
+    if (argc >= 2 && !cmdParseUint(argv[1], &interval)) {
+        Serial.printf("ERROR 101 Invalid interval: %s\n", argv[1]);
+        return;
+    }
+    if (argc >= 3 && !cmdParseInt(argv[2], &count)) {
+        Serial.printf("ERROR 101 Invalid count: %s\n", argv[2]);
+        return;
+    }
+    const char* deviceName = argv[0];
+
+    // Use consistent MAC for standard TX (randomMac=false)
+    // MAC is generated once at session start, stays same until stop
+    int result = txManager.startTx(deviceName, interval, count, false);
+    if (result >= 0) {
+        txActive = true;
+        outputTxEvent("tx_start", deviceName, interval, count, 0);
+        Serial.println("OK TX started");
+    } else if (result == -1) {
+        Serial.printf("ERROR 103 Device not found: %s\n", deviceName);
+    } else if (result == -2) {
+        Serial.printf("ERROR 105 Already transmitting: %s\n", deviceName);
+    } else if (result == -3) {
+        Serial.println("ERROR 105 No free TX slots");
+    }
+}
+
+static void cmdTxStop(char** argv, uint8_t argc) {
+    const char* deviceName = cmdJoin(argv, argc);
+    if (deviceName[0] == '\0') {
+        Serial.println("ERROR 102 Missing device name");
+        return;
+    }
+
+    if (strcasecmp(deviceName, "ALL") == 0) {
+        txManager.stopAll();
+        txActive = false;
+        outputTxEvent("tx_stop_all", "ALL", 0, 0, txManager.getTotalPacketsSent());
+        Serial.println("OK All TX stopped");
+        return;
+    }
+
+    tx_session_t* session = txManager.findSession(deviceName);
+    uint32_t sent = session ? session->packetsSent : 0;
+
+    int result = txManager.stopTx(deviceName);
+    if (result == 0) {
+        outputTxEvent("tx_stop", deviceName, 0, 0, sent);
+        txActive = txManager.getActiveCount() > 0;
+        Serial.println("OK TX stopped");
+    } else {
+        Serial.printf("ERROR 103 Device not found or not transmitting: %s\n", deviceName);
+    }
+}
+
+static void cmdTxPayload(char** argv, uint8_t argc) {
+    if (argc >= 1 && strcasecmp(argv[0], "STATIC") == 0) {
+        txManager.setStaticPayload(true);
+        Serial.println("OK Static payload (address changes only)");
+    } else if (argc >= 1 && strcasecmp(argv[0], "RANDOM") == 0) {
+        txManager.setStaticPayload(false);
+        Serial.println("OK Random payload bytes per packet");
+    } else {
+        Serial.println("ERROR 101 Use TX PAYLOAD STATIC or RANDOM");
+    }
+}
+
+// Achieved interval vs. the requested one, and lateness against the deadline
+static void printTxTiming(const tx_timing_t* timing) {
+    Serial.printf("      interval error: mean %+.0f us, jitter %.0f us, min %+ld, max %+ld "
+                  "(%lu samples)\n",
+                  timing->meanErrUs, txTimingJitterUs(timing),
+                  timing->samples > 0 ? (long)timing->minErrUs : 0L,
+                  timing->samples > 0 ? (long)timing->maxErrUs : 0L, timing->samples);
+    Serial.printf("      late: mean %lu us, max %lu us, %lu deadlines missed\n",
+                  timing->packets > 0 ? (unsigned long)(timing->latenessSumUs / timing->packets) : 0UL,
+                  timing->latenessMaxUs, timing->missed);
+    Serial.printf("      histogram (us): <%ld:%lu", (long)txTimingEdgesUs[0], timing->hist[0]);
+    for (int b = 1; b < TX_TIMING_BINS - 1; b++) {
+        Serial.printf(" <%ld:%lu", (long)txTimingEdgesUs[b], timing->hist[b]);
+    }
+    Serial.printf(" >=%ld:%lu\n", (long)txTimingEdgesUs[TX_TIMING_BINS - 2],
+                  timing->hist[TX_TIMING_BINS - 1]);
+}
+
+static void cmdTxStatus(char** argv, uint8_t argc) {
+    Serial.println("Active TX Sessions:");
+    int activeCount = 0;
+    tx_session_t session;
+    for (int i = 0; i < TX_MAX_CONCURRENT; i++) {
+        if (txManager.getSessionSnapshot(i, &session)) {
+            Serial.printf("  [%d] %s - %lu pkts @ %lums (remaining: %ld), "
+                          "rate %.1f/%.1f pkt/s\n",
+                          i, session.deviceName, session.packetsSent,
+                          session.intervalMs, session.remainingCount,
+                          txManager.getAchievedRate(&session),
+                          txManager.getRequestedRate(&session));
+            printTxTiming(&session.timing);
+            activeCount++;
         }
     }
-    else if (cmdStr == "CONFUSE LIST") {
-        Serial.println("Confusion Entries:");
-        int count = txManager.getConfusionEntryCount();
-        for (int i = 0; i < count; i++) {
-            confusion_entry_t* entry = txManager.getConfusionEntry(i);
-            if (entry) {
-                Serial.printf("  [%d] %s x%d\n", i, entry->deviceName, entry->instanceCount);
-            }
+    if (activeCount == 0) {
+        Serial.println("  (none)");
+    }
+    if (txManager.isConfusionActive()) {
+        Serial.printf("  Confusion - rate %.1f/%.1f pkt/s\n",
+                      txManager.getConfusionAchievedRate(),
+                      txManager.getConfusionRequestedRate());
+        if (txManager.isExtendedAdv()) {
+            // Each instance advertises on its own set; the controller does
+            // the timing
+            Serial.printf("  Confusion - %d of %d instances on air\n",
+                          txManager.getConfusionSetCount(),
+                          txManager.getConfusionInstanceCount());
+        } else {
+            tx_timing_t timing;
+            txManager.getConfusionTiming(&timing);
+            printTxTiming(&timing);
         }
-        if (count == 0) {
-            Serial.println("  (none)");
+    }
+    Serial.printf("Backend: %s advertising\n", txManager.isExtendedAdv() ? "extended" : "legacy");
+    Serial.printf("Payload: %s (%lu data uploads skipped)\n",
+                  txManager.isStaticPayload() ? "static" : "random",
+                  txManager.getUploadsSkipped());
+    Serial.printf("Address: %lu changes%s (%lu skipped)\n",
+                  txManager.getAddrChanges(),
+                  txManager.isExtendedAdv() ? "" : " with scan pause",
+                  txManager.getAddrSkipped());
+    Serial.printf("Total packets sent: %lu (%lu failed)\n",
+                  txManager.getTotalPacketsSent(), txManager.getFailedCount());
+    Serial.println("OK");
+}
+
+// =========================================================================
+// CONFUSION MODE COMMANDS
+// =========================================================================
+// CONFUSE ADD <device> [count]; a trailing number is the instance count
+static void cmdConfuseAdd(char** argv, uint8_t argc) {
+    uint32_t instanceCount = 1;
+    if (argc >= 2 && cmdParseUint(argv[argc - 1], &instanceCount)) {
+        if (instanceCount == 0 || instanceCount > 255) {
+            Serial.println("ERROR 101 Instance count must be 1-255");
+            return;
         }
-        Serial.printf("Total: %d entries\n", count);
-        Serial.println("OK");
+        argc--;
     }
-    else if (cmdStr == "CONFUSE START") {
-        // Stop any active scan before starting confusion TX
-        if (scanning) {
-            pBLEScan->stop();
-            delay(50);
+
+    const char* deviceName = cmdJoin(argv, argc);
+    if (deviceName[0] == '\0') {
+        Serial.println("ERROR 102 Missing device name");
+        return;
+    }
+
+    int result = txManager.confuseAdd(deviceName, (uint8_t)instanceCount);
+    if (result >= 0) {
+        Serial.printf("OK Added %s x%lu to confusion list\n", deviceName, instanceCount);
+    } else if (result == -1) {
+        Serial.printf("ERROR 103 Device not found: %s\n", deviceName);
+    } else {
+        Serial.println("ERROR 105 Confusion list full");
+    }
+}
+
+static void cmdConfuseRemove(char** argv, uint8_t argc) {
+    const char* deviceName = cmdJoin(argv, argc);
+    if (deviceName[0] == '\0') {
+        Serial.println("ERROR 102 Missing device name");
+        return;
+    }
+
+    int result = txManager.confuseRemove(deviceName);
+    if (result == 0) {
+        Serial.printf("OK Removed %s from confusion list\n", deviceName);
+    } else {
+        Serial.printf("ERROR 103 Device not in list: %s\n", deviceName);
+    }
+}
+
+static void cmdConfuseList(char** argv, uint8_t argc) {
+    Serial.println("Confusion Entries:");
+    int count = txManager.getConfusionEntryCount();
+    confusion_entry_t entry;
+    for (int i = 0; i < count; i++) {
+        if (txManager.getConfusionEntrySnapshot(i, &entry)) {
+            Serial.printf("  [%d] %s x%d\n", i, entry.deviceName, entry.instanceCount);
         }
+    }
+    if (count == 0) {
+        Serial.println("  (none)");
+    }
+    Serial.printf("Total: %d entries\n", count);
+    Serial.println("OK");
+}
+
+static void cmdConfuseStart(char** argv, uint8_t argc) {
+    int result = txManager.confuseStart();
+    if (result > 0) {
+        txActive = true;
+        Serial.printf("OK Confusion started with %d entries\n", result);
+    } else {
+        Serial.println("ERROR 104 No confusion entries configured");
+    }
+}
+
+static void cmdConfuseStop(char** argv, uint8_t argc) {
+    txManager.confuseStop();
+    txActive = txManager.getActiveCount() > 0;
+    Serial.println("OK Confusion stopped");
+}
+
+static void cmdConfuseClear(char** argv, uint8_t argc) {
+    txManager.confuseClear();
+    txActive = txManager.getActiveCount() > 0;
+    Serial.println("OK Confusion list cleared");
+}
+
+// =========================================================================
+// DISPLAY & OUTPUT COMMANDS
+// =========================================================================
+static void cmdJsonOn(char** argv, uint8_t argc) {
+    jsonOutput = true;
+    Serial.println("OK JSON output enabled");
+}
+
+static void cmdJsonOff(char** argv, uint8_t argc) {
+    jsonOutput = false;
+    Serial.println("OK JSON output disabled");
+}
+
+static void cmdBinaryOn(char** argv, uint8_t argc) {
+    Serial.println("OK Binary output enabled");
+    binaryOutput = true;
+}
+
+static void cmdBinaryOff(char** argv, uint8_t argc) {
+    binaryOutput = false;
+    Serial.println("OK Binary output disabled");
+}
+
+static void cmdStreamRaw(char** argv, uint8_t argc) {
+    Serial.println("OK Raw advertisement stream enabled");
+    rawStreamSetEnabled(true);
+}
+
+static void cmdStreamOff(char** argv, uint8_t argc) {
+    rawStreamSetEnabled(false);
+    Serial.println("OK Raw advertisement stream disabled");
+}
+
+static void cmdBaud(char** argv, uint8_t argc) {
+    uint32_t baud = 0;
+    if (argc >= 1 && cmdParseUint(argv[0], &baud) && baud >= 9600 && baud <= SERIAL_BAUD_MAX) {
+        // Acknowledge at the old rate, then switch
+        Serial.printf("OK Switching to %lu baud\n", baud);
+        Serial.flush();
+        Serial.updateBaudRate(baud);
+        serialBaudRate = baud;
+    } else {
+        Serial.printf("ERROR 101 Baud rate must be 9600-%d\n", SERIAL_BAUD_MAX);
+    }
+}
+
+static void cmdDisplayScreen(char** argv, uint8_t argc) {
+    uint32_t screen = 0;
+    if (argc >= 1 && cmdParseUint(argv[0], &screen) && screen <= 3) {
+        currentScreen = screen;
+        uiEvents.post(UI_EVENT_SCREEN);
+        Serial.printf("OK Switched to screen %lu\n", screen);
+    } else {
+        Serial.println("ERROR 101 Invalid screen number (0-3)");
+    }
+}
+
+static void cmdDisplayMessage(char** argv, uint8_t argc) {
+    // TODO: Display overlay message
+    Serial.println("OK");
+}
+
+// =========================================================================
+// POWER SAVE COMMANDS
+// =========================================================================
+static void cmdPowersaveStatus(char** argv, uint8_t argc) {
+    Serial.printf("Power Save: %s\n", powerSaveEnabled ? "ENABLED" : "DISABLED");
+    Serial.printf("Timeout: %lu seconds (%lu minutes)\n", powerSaveTimeoutSec, powerSaveTimeoutSec / 60);
+    Serial.printf("Screen: %s\n", screenAsleep ? "SLEEPING" : "AWAKE");
+    Serial.printf("CPU: %lu MHz (%s), light sleep %s (%s)\n", ESP.getCpuFreqMHz(),
+                  powerMgr.isDfsSupported() ? "DFS" : "fixed",
+                  powerMgr.isLightSleepActive() ? "ON" : "OFF", powerMgr.getLightSleepNote());
+    Serial.printf("Wakeups: %.1f/s, est. current %u mA\n", powerMgr.getWakeupRate(),
+                  powerMgr.estimateCurrentMa(scanning ? scanScheduler.getDutyPct() : 0, !screenAsleep));
+    uint32_t timeSinceNew = (millis() - lastNewDeviceTime) / 1000;
+    Serial.printf("Time since new device: %lu seconds\n", timeSinceNew);
+    Serial.println("OK");
+}
+
+static void cmdPowersaveOn(char** argv, uint8_t argc) {
+    powerSaveEnabled = true;
+    Serial.println("OK Power save enabled");
+}
+
+static void cmdPowersaveOff(char** argv, uint8_t argc) {
+    powerSaveEnabled = false;
+    if (screenAsleep) {
+        requestScreenWake();
+    }
+    Serial.println("OK Power save disabled");
+}
+
+static void cmdPowersaveTimeout(char** argv, uint8_t argc) {
+    uint32_t timeout = 0;
+    if (argc >= 1 && cmdParseUint(argv[0], &timeout) && timeout >= 10 && timeout <= 3600) {
+        powerSaveTimeoutSec = timeout;
+        Serial.printf("OK Power save timeout set to %lu seconds\n", powerSaveTimeoutSec);
+    } else {
+        Serial.println("ERROR 101 Timeout must be 10-3600 seconds");
+    }
+}
+
+static void cmdPowersaveWake(char** argv, uint8_t argc) {
+    requestScreenWake();
+    Serial.println("OK Screen awakened");
+}
+
+// =========================================================================
+// UPLINK COMMANDS
+// =========================================================================
+static void printUplinkResult(bool ok) {
+    if (ok) {
+        Serial.printf("OK Uplink %s\n", uplink.getModeString());
+    } else {
+        Serial.printf("ERROR 105 Uplink unavailable: %s\n",
+                      uplink.getError() != nullptr ? uplink.getError() : "not started");
+    }
+}
+
+static void cmdUplinkStatus(char** argv, uint8_t argc) {
+    uint8_t own[6];
+    uplink.getAddress(own);
+    const uint8_t* peer = uplink.getPeer();
+    Serial.printf("Mode: %s%s%s\n", uplink.getModeString(),
+                  uplink.getError() != nullptr ? ", last error: " : "",
+                  uplink.getError() != nullptr ? uplink.getError() : "");
+    Serial.printf("Address: %02X:%02X:%02X:%02X:%02X:%02X, channel %u\n",
+                  own[0], own[1], own[2], own[3], own[4], own[5], uplink.getChannel());
+    if (uplink.isBroadcast()) {
+        Serial.println("Peer: broadcast");
+    } else {
+        Serial.printf("Peer: %02X:%02X:%02X:%02X:%02X:%02X\n",
+                      peer[0], peer[1], peer[2], peer[3], peer[4], peer[5]);
+    }
+    Serial.printf("Interval: %lu ms, refresh every %d batches\n",
+                  uplink.getIntervalMs(), UPLINK_REFRESH_BATCHES);
+    Serial.printf("Sent: %lu batches, %lu packets, %lu failed, %lu deferred, %lu outside a slot\n",
+                  uplink.getBatchCount(), uplink.getSentCount(), uplink.getFailedCount(),
+                  uplink.getDeferredCount(), uplink.getUnscheduledCount());
+    Serial.printf("Scan slots: %lu granted\n", scanScheduler.getUplinkSlotCount());
+    Serial.printf("Received: %lu packets, %lu lost, %lu dropped\n",
+                  uplink.getReceivedCount(), uplink.getLostCount(), uplink.getRxDroppedCount());
+    uint32_t now = millis();
+    for (int i = 0; i < uplink.getNodeCount(); i++) {
+        const uplink_node_t* node = uplink.getNode(i);
+        Serial.printf("  Node %02X:%02X:%02X:%02X:%02X:%02X: %lu packets, %lu lost, heard %lus ago\n",
+                      node->mac[0], node->mac[1], node->mac[2],
+                      node->mac[3], node->mac[4], node->mac[5],
+                      node->packets, node->lost, (now - node->lastHeard) / 1000);
+    }
+    Serial.println("OK");
+}
 
-        int result = txManager.confuseStart();
-        if (result > 0) {
-            txActive = true;
-            Serial.printf("OK Confusion started with %d entries\n", result);
-        } else {
-            Serial.println("ERROR 104 No confusion entries configured");
+static void cmdUplinkNode(char** argv, uint8_t argc) {
+    uint8_t mac[6];
+    if (argc >= 1) {
+        if (!macParse(argv[0], mac)) {
+            Serial.println("ERROR 101 Invalid MAC address");
+            return;
         }
+        uplink.setPeer(mac);
     }
-    else if (cmdStr == "CONFUSE STOP") {
-        txManager.confuseStop();
-        txActive = txManager.getActiveCount() > 0;
-        Serial.println("OK Confusion stopped");
-    }
-    else if (cmdStr == "CONFUSE CLEAR") {
-        txManager.confuseClear();
-        txActive = txManager.getActiveCount() > 0;
-        Serial.println("OK Confusion list cleared");
-    }
+    printUplinkResult(uplink.setMode(UPLINK_NODE));
+}
+
+static void cmdUplinkCollector(char** argv, uint8_t argc) {
+    printUplinkResult(uplink.setMode(UPLINK_COLLECTOR));
+}
 
-    // =========================================================================
-    // DISPLAY & OUTPUT COMMANDS
-    // =========================================================================
-    else if (cmdStr == "JSON ON") {
-        jsonOutput = true;
-        Serial.println("OK JSON output enabled");
+static void cmdUplinkOff(char** argv, uint8_t argc) {
+    printUplinkResult(uplink.setMode(UPLINK_OFF));
+}
+
+static void cmdUplinkInterval(char** argv, uint8_t argc) {
+    uint32_t ms = 0;
+    if (argc >= 1 && cmdParseUint(argv[0], &ms) &&
+        ms >= UPLINK_INTERVAL_MIN_MS && ms <= UPLINK_INTERVAL_MAX_MS) {
+        uplink.setInterval(ms);
+        Serial.printf("OK Uplink interval %lu ms\n", ms);
+    } else {
+        Serial.printf("ERROR 101 Interval must be %d-%d ms\n",
+                      UPLINK_INTERVAL_MIN_MS, UPLINK_INTERVAL_MAX_MS);
     }
-    else if (cmdStr == "JSON OFF") {
-        jsonOutput = false;
-        Serial.println("OK JSON output disabled");
+}
+
+static void cmdUplinkChannel(char** argv, uint8_t argc) {
+    uint32_t channel = 0;
+    if (argc >= 1 && cmdParseUint(argv[0], &channel) && channel <= 13 &&
+        uplink.setChannel((uint8_t)channel)) {
+        Serial.printf("OK Uplink channel %lu\n", channel);
+    } else {
+        Serial.println("ERROR 101 Channel must be 1-13");
     }
-    else if (cmdStr.startsWith("DISPLAY SCREEN ")) {
-        int screen = cmdStr.substring(15).toInt();
-        if (screen >= 0 && screen <= 3) {
-            currentScreen = screen;
-            Serial.printf("OK Switched to screen %d\n", screen);
-        } else {
-            Serial.println("ERROR 101 Invalid screen number (0-3)");
-        }
-    }
-    else if (cmdStr.startsWith("DISPLAY MESSAGE ")) {
-        String msg = origCmd.substring(16);
-        msg.trim();
-        // TODO: Display overlay message
-        Serial.println("OK");
-    }
-
-    // =========================================================================
-    // POWER SAVE COMMANDS
-    // =========================================================================
-    else if (cmdStr == "POWERSAVE STATUS") {
-        Serial.printf("Power Save: %s\n", powerSaveEnabled ? "ENABLED" : "DISABLED");
-        Serial.printf("Timeout: %lu seconds (%lu minutes)\n", powerSaveTimeoutSec, powerSaveTimeoutSec / 60);
-        Serial.printf("Screen: %s\n", screenAsleep ? "SLEEPING" : "AWAKE");
-        uint32_t timeSinceNew = (millis() - lastNewDeviceTime) / 1000;
-        Serial.printf("Time since new device: %lu seconds\n", timeSinceNew);
-        Serial.println("OK");
-    }
-    else if (cmdStr == "POWERSAVE ON") {
-        powerSaveEnabled = true;
-        Serial.println("OK Power save enabled");
-    }
-    else if (cmdStr == "POWERSAVE OFF") {
-        powerSaveEnabled = false;
-        if (screenAsleep) {
-            wakeScreen();
-        }
-        Serial.println("OK Power save disabled");
-    }
-    else if (cmdStr.startsWith("POWERSAVE TIMEOUT ")) {
-        uint32_t timeout = cmdStr.substring(18).toInt();
-        if (timeout >= 10 && timeout <= 3600) {
-            powerSaveTimeoutSec = timeout;
-            Serial.printf("OK Power save timeout set to %lu seconds\n", powerSaveTimeoutSec);
+}
+
+// =========================================================================
+// COMMAND TABLE
+// =========================================================================
+// Names are one or two words; the index is sorted by hash at compile time
+static constexpr cmd_entry_t COMMANDS[] = {
+    { "HELP",              cmdHelp },
+    { "VERSION",           cmdVersion },
+    { "STATUS",            cmdStatus },
+    { "STATS",             cmdStats },
+    { "STATS RESET",       cmdStatsReset },
+    { "SCAN START",        cmdScanStart },
+    { "SCAN STOP",         cmdScanStop },
+    { "SCAN CLEAR",        cmdScanClear },
+    { "SCAN LIST",         cmdScanList },
+    { "SCAN DUPFILTER",    cmdScanDupFilter },
+    { "SCAN SAMPLE",       cmdScanSample },
+    { "IGNORE ADD",        cmdIgnoreAdd },
+    { "IGNORE REMOVE",     cmdIgnoreRemove },
+    { "IGNORE LIST",       cmdIgnoreList },
+    { "IGNORE CLEAR",      cmdIgnoreClear },
+    { "LOG STATUS",        cmdLogStatus },
+    { "LOG DUMP",          cmdLogDump },
+    { "LOG CLEAR",         cmdLogClear },
+    { "SIG LIST",          cmdSigList },
+    { "TX LIST",           cmdTxList },
+    { "TX START",          cmdTxStart },
+    { "TX STOP",           cmdTxStop },
+    { "TX PAYLOAD",        cmdTxPayload },
+    { "TX STATUS",         cmdTxStatus },
+    { "CONFUSE ADD",       cmdConfuseAdd },
+    { "CONFUSE REMOVE",    cmdConfuseRemove },
+    { "CONFUSE LIST",      cmdConfuseList },
+    { "CONFUSE START",     cmdConfuseStart },
+    { "CONFUSE STOP",      cmdConfuseStop },
+    { "CONFUSE CLEAR",     cmdConfuseClear },
+    { "JSON ON",           cmdJsonOn },
+    { "JSON OFF",          cmdJsonOff },
+    { "BINARY ON",         cmdBinaryOn },
+    { "BINARY OFF",        cmdBinaryOff },
+    { "STREAM RAW",        cmdStreamRaw },
+    { "STREAM OFF",        cmdStreamOff },
+    { "BAUD",              cmdBaud },
+    { "DISPLAY SCREEN",    cmdDisplayScreen },
+    { "DISPLAY MESSAGE",   cmdDisplayMessage },
+    { "UPLINK STATUS",     cmdUplinkStatus },
+    { "UPLINK NODE",       cmdUplinkNode },
+    { "UPLINK COLLECTOR",  cmdUplinkCollector },
+    { "UPLINK OFF",        cmdUplinkOff },
+    { "UPLINK INTERVAL",   cmdUplinkInterval },
+    { "UPLINK CHANNEL",    cmdUplinkChannel },
+    { "POWERSAVE STATUS",  cmdPowersaveStatus },
+    { "POWERSAVE ON",      cmdPowersaveOn },
+    { "POWERSAVE OFF",     cmdPowersaveOff },
+    { "POWERSAVE TIMEOUT", cmdPowersaveTimeout },
+    { "POWERSAVE WAKE",    cmdPowersaveWake },
+};
+
+static constexpr auto COMMAND_INDEX = cmdIndexBuild(COMMANDS);
+static_assert(!COMMAND_INDEX.collision, "Command names collide; change cmdHash or a name");
+
+// Runs every ';'-separated command of the line in order. The line is
+// tokenized in place.
+void processSerialCommand(char* line) {
+    PERF_SCOPE(PERF_SERIAL_CMD);
+
+    cmd_tokens_t cmd;
+    char* cursor = line;
+    while (cmdNextCommand(&cursor, &cmd)) {
+        uint8_t used = 0;
+        const cmd_entry_t* entry = cmdLookup(COMMANDS, COMMAND_INDEX, &cmd, &used);
+        if (entry != nullptr) {
+            entry->handler(cmd.argv + used, cmd.argc - used);
         } else {
-            Serial.println("ERROR 101 Timeout must be 10-3600 seconds");
+            Serial.printf("ERROR 100 Unknown command: %s\n", cmdJoin(cmd.argv, cmd.argc));
         }
     }
-    else if (cmdStr == "POWERSAVE WAKE") {
-        wakeScreen();
-        Serial.println("OK Screen awakened");
-    }
-
-    // =========================================================================
-    // UNKNOWN COMMAND
-    // =========================================================================
-    else {
-        Serial.printf("ERROR 100 Unknown command: %s\n", cmd);
-    }
 }
 
 // =============================================================================
@@ -804,6 +1479,8 @@ void initDisplay() {
     pinMode(TFT_BL_PIN, OUTPUT);
     digitalWrite(TFT_BL_PIN, HIGH);
 
+    contentFrame.init(&tft);
+
     drawStatusBar();
     drawNavBar();
 }
@@ -853,24 +1530,61 @@ void drawNavBar() {
     }
 }
 
-void drawScanScreen() {
-    int y = STATUS_BAR_HEIGHT + 4;
-    tft.fillRect(0, STATUS_BAR_HEIGHT, SCREEN_WIDTH, CONTENT_HEIGHT, TFT_BLACK);
+// What each visible scan list row currently shows, so updates can redraw
+// only the rows (or RSSI cells) that changed
+typedef struct {
+    bool valid;                         // Row shows a device
+    int16_t deviceIdx;
+    uint8_t mac[6];
+    uint8_t category;
+    bool active;
+    bool follower;
+    int8_t rssi;
+} scan_row_cache_t;
+
+static scan_row_cache_t scanRowCache[ITEMS_PER_PAGE];
+static int scanCacheFilteredCount = -1;     // -1 = screen not drawn yet
+static uint32_t lastScanRssiRefresh = 0;
 
-    // Count filtered devices
+static const int SCAN_LIST_Y = STATUS_BAR_HEIGHT + 24;
+
+// Copies of the visible rows' devices, taken under the table lock so the
+// drawing itself doesn't hold the matcher up
+static DetectedDevice scanRowDevices[ITEMS_PER_PAGE];
+
+// Device indices of the visible rows, with their devices copied to
+// scanRowDevices; returns the filtered device count
+static int collectScanRows(int16_t* rows, int* rowCount) {
+    DeviceTableLock lock;
     int filteredCount = 0;
-    for (int i = 0; i < detectedCount; i++) {
-        if (detectedDevices[i].category & categoryFilter) {
-            filteredCount++;
+    *rowCount = 0;
+    for (int i = 0; i < deviceTable.count(); i++) {
+        if (!(deviceTable.at(i)->category & categoryFilter)) {
+            continue;
         }
+        if (filteredCount >= scrollOffset && *rowCount < ITEMS_PER_PAGE) {
+            scanRowDevices[*rowCount] = *deviceTable.at(i);
+            rows[(*rowCount)++] = i;
+        }
+        filteredCount++;
     }
+    return filteredCount;
+}
 
-    tft.setTextDatum(TL_DATUM);
-    tft.setTextFont(2);
-    tft.setTextColor(TFT_WHITE, TFT_BLACK);
-    tft.drawString("DETECTED DEVICES", 4, y, 2);
+// Devices matching the category filter
+static int countFilteredDevices() {
+    DeviceTableLock lock;
+    int filteredCount = 0;
+    for (int i = 0; i < deviceTable.count(); i++) {
+        if (deviceTable.at(i)->category & categoryFilter) {
+            filteredCount++;
+        }
+    }
+    return filteredCount;
+}
 
-    // Show count and scroll indicator
+static void drawScanCount(TFT_eSPI& gfx, int filteredCount) {
+    int y = STATUS_BAR_HEIGHT + 4;
     char countStr[24];
     if (filteredCount > ITEMS_PER_PAGE) {
         snprintf(countStr, sizeof(countStr), "[%d-%d/%d]",
@@ -880,83 +1594,189 @@ void drawScanScreen() {
     } else {
         snprintf(countStr, sizeof(countStr), "[%d]", filteredCount);
     }
-    tft.setTextDatum(TR_DATUM);
-    tft.drawString(countStr, SCREEN_WIDTH - 4, y, 2);
+    gfx.fillRect(SCREEN_WIDTH - 100, y, 100, 16, TFT_BLACK);
+    gfx.setTextDatum(TR_DATUM);
+    gfx.setTextColor(TFT_WHITE, TFT_BLACK);
+    gfx.drawString(countStr, SCREEN_WIDTH - 4, y, 2);
+}
 
-    y += 20;
+static void drawScanArrows(TFT_eSPI& gfx, int filteredCount) {
+    if (filteredCount <= ITEMS_PER_PAGE) {
+        return;
+    }
+    if (scrollOffset > 0) {
+        // Up arrow
+        gfx.fillTriangle(SCREEN_WIDTH - 15, SCAN_LIST_Y, SCREEN_WIDTH - 10, SCAN_LIST_Y - 6,
+                         SCREEN_WIDTH - 5, SCAN_LIST_Y, TFT_YELLOW);
+    }
+    if (scrollOffset + ITEMS_PER_PAGE < filteredCount) {
+        // Down arrow if more items below
+        int arrowY = STATUS_BAR_HEIGHT + CONTENT_HEIGHT - 10;
+        gfx.fillTriangle(SCREEN_WIDTH - 15, arrowY, SCREEN_WIDTH - 10, arrowY + 6,
+                         SCREEN_WIDTH - 5, arrowY, TFT_YELLOW);
+    }
+}
 
-    // Draw scroll indicators if needed
-    if (filteredCount > ITEMS_PER_PAGE) {
-        if (scrollOffset > 0) {
-            // Up arrow
-            tft.fillTriangle(SCREEN_WIDTH - 15, y, SCREEN_WIDTH - 10, y - 6, SCREEN_WIDTH - 5, y, TFT_YELLOW);
-        }
+static void drawScanRssi(TFT_eSPI& gfx, int slot, const DetectedDevice* dev) {
+    int y = SCAN_LIST_Y + slot * ITEM_HEIGHT;
+    char rssiStr[16];
+    snprintf(rssiStr, sizeof(rssiStr), "%d", dev->rssi);
+    gfx.fillRect(260, y, 36, 8, TFT_BLACK);
+    gfx.setTextDatum(TL_DATUM);
+    gfx.setTextColor(TFT_YELLOW, TFT_BLACK);
+    gfx.drawString(rssiStr, 260, y, 1);
+    scanRowCache[slot].rssi = dev->rssi;
+}
+
+// Draw one row (dev == nullptr clears it) and record what it shows
+static void drawScanRow(TFT_eSPI& gfx, int slot, int deviceIdx, const DetectedDevice* dev) {
+    int y = SCAN_LIST_Y + slot * ITEM_HEIGHT;
+    int h = min(ITEM_HEIGHT, SCREEN_HEIGHT - NAV_BAR_HEIGHT - y);  // Keep off the nav bar
+    gfx.fillRect(0, y, SCREEN_WIDTH, h, TFT_BLACK);
+
+    scan_row_cache_t* row = &scanRowCache[slot];
+    row->valid = (dev != nullptr);
+    if (dev == nullptr) {
+        return;
     }
+    row->deviceIdx = deviceIdx;
+    memcpy(row->mac, dev->mac, 6);
+    row->category = dev->category;
+    row->active = dev->isActive();
+    row->follower = dev->isFollower();
 
-    // Draw device list with scrolling (only show devices matching filter)
-    tft.setTextFont(1);
-    int displayed = 0;
-    int skipped = 0;
+    // Category color indicator
+    uint16_t catColor = TFT_WHITE;
+    switch (dev->category) {
+        case CAT_TRACKER:  catColor = TFT_RED;     break;
+        case CAT_GLASSES:  catColor = TFT_ORANGE;  break;
+        case CAT_MEDICAL:  catColor = TFT_YELLOW;  break;
+        case CAT_WEARABLE: catColor = TFT_BLUE;    break;
+        case CAT_AUDIO:    catColor = TFT_MAGENTA; break;
+    }
 
-    for (int deviceIdx = 0; deviceIdx < detectedCount && displayed < ITEMS_PER_PAGE; deviceIdx++) {
-        DetectedDevice* dev = &detectedDevices[deviceIdx];
+    gfx.fillCircle(SCREEN_WIDTH - 10, y + 7, 4, catColor);
 
-        // Apply category filter
-        if (!(dev->category & categoryFilter)) {
-            continue;
-        }
+    // Device name with last 3 MAC octets for uniqueness (grey = inactive,
+    // red = follower alert)
+    gfx.setTextDatum(TL_DATUM);
+    gfx.setTextColor(dev->isFollower() ? TFT_RED : (dev->isActive() ? TFT_WHITE : TFT_DARKGREY),
+                     TFT_BLACK);
+    char nameWithMac[48];
+    snprintf(nameWithMac, sizeof(nameWithMac), "%s %02X:%02X:%02X",
+             deviceSignature(dev)->name, dev->mac[3], dev->mac[4], dev->mac[5]);
+    gfx.drawString(nameWithMac, 4, y, 1);
 
-        // Handle scroll offset
-        if (skipped < scrollOffset) {
-            skipped++;
-            continue;
-        }
+    drawScanRssi(gfx, slot, dev);
+}
 
-        // Category color indicator
-        uint16_t catColor = TFT_WHITE;
-        switch (dev->category) {
-            case CAT_TRACKER:  catColor = TFT_RED;     break;
-            case CAT_GLASSES:  catColor = TFT_ORANGE;  break;
-            case CAT_MEDICAL:  catColor = TFT_YELLOW;  break;
-            case CAT_WEARABLE: catColor = TFT_BLUE;    break;
-            case CAT_AUDIO:    catColor = TFT_MAGENTA; break;
-        }
+static bool scanRowChanged(const scan_row_cache_t* row, int deviceIdx, const DetectedDevice* dev) {
+    return !row->valid || row->deviceIdx != deviceIdx || memcmp(row->mac, dev->mac, 6) != 0 ||
+           row->category != dev->category || row->active != dev->isActive() ||
+           row->follower != dev->isFollower();
+}
 
-        tft.fillCircle(SCREEN_WIDTH - 10, y + 7, 4, catColor);
+void drawScanScreen() {
+    PERF_SCOPE(PERF_DRAW_SCAN);
+    TFT_eSPI& gfx = contentFrame.begin();
+    int y = STATUS_BAR_HEIGHT + 4;
+    gfx.fillRect(0, STATUS_BAR_HEIGHT, SCREEN_WIDTH, CONTENT_HEIGHT, TFT_BLACK);
 
-        // Device name with last 3 MAC octets for uniqueness
-        tft.setTextDatum(TL_DATUM);
-        tft.setTextColor(TFT_WHITE, TFT_BLACK);
-        char nameWithMac[48];
-        snprintf(nameWithMac, sizeof(nameWithMac), "%s %02X:%02X:%02X",
-                 dev->name, dev->mac[3], dev->mac[4], dev->mac[5]);
-        tft.drawString(nameWithMac, 4, y, 1);
+    int16_t rows[ITEMS_PER_PAGE];
+    int rowCount;
+    int filteredCount = collectScanRows(rows, &rowCount);
 
-        char rssiStr[16];
-        snprintf(rssiStr, sizeof(rssiStr), "%d", dev->rssi);
-        tft.setTextColor(TFT_YELLOW, TFT_BLACK);
-        tft.drawString(rssiStr, 260, y, 1);
+    gfx.setTextDatum(TL_DATUM);
+    gfx.setTextFont(2);
+    gfx.setTextColor(TFT_WHITE, TFT_BLACK);
+    gfx.drawString("DETECTED DEVICES", 4, y, 2);
 
-        y += ITEM_HEIGHT;
-        displayed++;
-    }
+    // Show count and scroll indicator
+    drawScanCount(gfx, filteredCount);
 
-    // Draw down scroll indicator if more items below
-    if (scrollOffset + ITEMS_PER_PAGE < filteredCount) {
-        int arrowY = STATUS_BAR_HEIGHT + CONTENT_HEIGHT - 10;
-        tft.fillTriangle(SCREEN_WIDTH - 15, arrowY, SCREEN_WIDTH - 10, arrowY + 6, SCREEN_WIDTH - 5, arrowY, TFT_YELLOW);
+    // Draw device list with scrolling (only show devices matching filter)
+    gfx.setTextFont(1);
+    for (int slot = 0; slot < ITEMS_PER_PAGE; slot++) {
+        if (slot < rowCount) {
+            drawScanRow(gfx, slot, rows[slot], &scanRowDevices[slot]);
+        } else {
+            scanRowCache[slot].valid = false;
+        }
     }
+    drawScanArrows(gfx, filteredCount);
 
     // Show message if no devices
     if (filteredCount == 0) {
-        tft.setTextDatum(MC_DATUM);
-        tft.setTextColor(TFT_DARKGREY, TFT_BLACK);
-        if (detectedCount > 0) {
-            tft.drawString("No devices match filter", SCREEN_WIDTH/2, SCREEN_HEIGHT/2, 2);
+        gfx.setTextDatum(MC_DATUM);
+        gfx.setTextColor(TFT_DARKGREY, TFT_BLACK);
+        if (deviceTable.count() > 0) {
+            gfx.drawString("No devices match filter", SCREEN_WIDTH/2, SCREEN_HEIGHT/2, 2);
         } else {
-            tft.drawString("Scanning for devices...", SCREEN_WIDTH/2, SCREEN_HEIGHT/2, 2);
+            gfx.drawString("Scanning for devices...", SCREEN_WIDTH/2, SCREEN_HEIGHT/2, 2);
+        }
+    }
+
+    contentFrame.push();
+
+    scanCacheFilteredCount = filteredCount;
+    lastScanRssiRefresh = millis();
+}
+
+// Incremental update: redraw only rows whose device, category or activity
+// changed; RSSI-only changes are applied at most every SCAN_RSSI_REFRESH_MS
+void updateScanScreen() {
+    PERF_SCOPE(PERF_UPDATE_SCAN);
+    // Small row updates go straight to the panel
+    contentFrame.waitIdle();
+    TFT_eSPI& gfx = tft;
+
+    int16_t rows[ITEMS_PER_PAGE];
+    int rowCount;
+    int filteredCount = collectScanRows(rows, &rowCount);
+
+    // Layout changes (empty message, scroll arrows) need a full redraw
+    bool wasScrollable = scanCacheFilteredCount > ITEMS_PER_PAGE;
+    bool isScrollable = filteredCount > ITEMS_PER_PAGE;
+    bool moreBelow = scrollOffset + ITEMS_PER_PAGE < filteredCount;
+    bool hadMoreBelow = scrollOffset + ITEMS_PER_PAGE < scanCacheFilteredCount;
+    if (scanCacheFilteredCount <= 0 || filteredCount == 0 ||
+        wasScrollable != isScrollable || moreBelow != hadMoreBelow) {
+        drawScanScreen();
+        return;
+    }
+
+    if (filteredCount != scanCacheFilteredCount) {
+        drawScanCount(gfx, filteredCount);
+        scanCacheFilteredCount = filteredCount;
+    }
+
+    bool refreshRssi = millis() - lastScanRssiRefresh >= SCAN_RSSI_REFRESH_MS;
+    bool redrewRow = false;
+    for (int slot = 0; slot < ITEMS_PER_PAGE; slot++) {
+        scan_row_cache_t* row = &scanRowCache[slot];
+        if (slot >= rowCount) {
+            if (row->valid) {
+                drawScanRow(gfx, slot, -1, nullptr);
+                redrewRow = true;
+            }
+            continue;
+        }
+
+        const DetectedDevice* dev = &scanRowDevices[slot];
+        if (scanRowChanged(row, rows[slot], dev)) {
+            drawScanRow(gfx, slot, rows[slot], dev);
+            redrewRow = true;
+        } else if (refreshRssi && row->rssi != dev->rssi) {
+            drawScanRssi(gfx, slot, dev);
         }
     }
+
+    if (redrewRow) {
+        drawScanArrows(gfx, filteredCount);  // Rows overlap the arrow tips
+    }
+    if (refreshRssi) {
+        lastScanRssiRefresh = millis();
+    }
 }
 
 // TX screen layout constants
@@ -972,130 +1792,133 @@ void drawScanScreen() {
 static int txScrollOffset = 0;
 
 void drawTXScreen() {
+    PERF_SCOPE(PERF_DRAW_TX);
+    TFT_eSPI& gfx = contentFrame.begin();
     int y = STATUS_BAR_HEIGHT + 4;
-    tft.fillRect(0, STATUS_BAR_HEIGHT, SCREEN_WIDTH, CONTENT_HEIGHT, TFT_BLACK);
+    gfx.fillRect(0, STATUS_BAR_HEIGHT, SCREEN_WIDTH, CONTENT_HEIGHT, TFT_BLACK);
 
-    tft.setTextDatum(TL_DATUM);
-    tft.setTextColor(TFT_WHITE);
+    gfx.setTextDatum(TL_DATUM);
+    gfx.setTextColor(TFT_WHITE);
 
     // Show active TX sessions
     int activeCount = txManager.getActiveCount();
     bool confusionActive = txManager.isConfusionActive();
 
     if (confusionActive) {
-        tft.setTextColor(TFT_RED);
-        tft.drawString("CONFUSION MODE", 4, y);
+        gfx.setTextColor(TFT_RED);
+        gfx.drawString("CONFUSION MODE", 4, y);
 
         // STOP button
-        tft.fillRoundRect(TX_STOP_BTN_X, TX_STOP_BTN_Y, TX_STOP_BTN_W, TX_STOP_BTN_H, 4, TFT_RED);
-        tft.setTextColor(TFT_WHITE);
-        tft.setTextDatum(MC_DATUM);
-        tft.drawString("STOP", TX_STOP_BTN_X + TX_STOP_BTN_W/2, TX_STOP_BTN_Y + TX_STOP_BTN_H/2, 2);
-        tft.setTextDatum(TL_DATUM);
+        gfx.fillRoundRect(TX_STOP_BTN_X, TX_STOP_BTN_Y, TX_STOP_BTN_W, TX_STOP_BTN_H, 4, TFT_RED);
+        gfx.setTextColor(TFT_WHITE);
+        gfx.setTextDatum(MC_DATUM);
+        gfx.drawString("STOP", TX_STOP_BTN_X + TX_STOP_BTN_W/2, TX_STOP_BTN_Y + TX_STOP_BTN_H/2, 2);
+        gfx.setTextDatum(TL_DATUM);
 
         y += 22;
 
         // Stats
-        tft.setTextColor(TFT_WHITE);
+        gfx.setTextColor(TFT_WHITE);
         char statsStr[40];
         snprintf(statsStr, sizeof(statsStr), "Devices: %d  Total Pkts: %lu",
                  txManager.getConfusionEntryCount(),
                  txManager.getTotalPacketsSent());
-        tft.drawString(statsStr, 4, y);
+        gfx.drawString(statsStr, 4, y);
         y += 16;
 
-        tft.setTextColor(TFT_CYAN);
-        tft.drawString("Broadcasting multiple device types", 4, y);
+        gfx.setTextColor(TFT_CYAN);
+        gfx.drawString("Broadcasting multiple device types", 4, y);
         y += 18;
 
         // List confusion entries with details
         int entryCount = txManager.getConfusionEntryCount();
         for (int i = 0; i < min(entryCount, 5) && y < SCREEN_HEIGHT - NAV_BAR_HEIGHT - 10; i++) {
-            confusion_entry_t* entry = txManager.getConfusionEntry(i);
-            if (entry && entry->sig) {
+            confusion_entry_t entry;
+            if (txManager.getConfusionEntrySnapshot(i, &entry) && entry.sig) {
                 // Category color
                 uint16_t catColor = TFT_WHITE;
-                switch (entry->sig->category) {
+                switch (entry.sig->category) {
                     case CAT_TRACKER:  catColor = TFT_RED;     break;
                     case CAT_GLASSES:  catColor = TFT_ORANGE;  break;
                     case CAT_MEDICAL:  catColor = TFT_YELLOW;  break;
                     case CAT_WEARABLE: catColor = TFT_BLUE;    break;
                     case CAT_AUDIO:    catColor = TFT_MAGENTA; break;
                 }
-                tft.fillCircle(10, y + 6, 4, catColor);
+                gfx.fillCircle(10, y + 6, 4, catColor);
 
                 char entryStr[48];
                 snprintf(entryStr, sizeof(entryStr), "%s (0x%04X)",
-                         entry->deviceName, entry->sig->company_id);
-                tft.setTextColor(TFT_WHITE);
-                tft.drawString(entryStr, 20, y);
+                         entry.deviceName, entry.sig->company_id);
+                gfx.setTextColor(TFT_WHITE);
+                gfx.drawString(entryStr, 20, y);
                 y += 16;
             }
         }
 
     } else if (activeCount > 0) {
-        tft.setTextColor(TFT_YELLOW);
-        tft.drawString("TRANSMITTING", 4, y);
+        gfx.setTextColor(TFT_YELLOW);
+        gfx.drawString("TRANSMITTING", 4, y);
 
         // STOP ALL button
-        tft.fillRoundRect(TX_STOP_BTN_X, TX_STOP_BTN_Y, TX_STOP_BTN_W, TX_STOP_BTN_H, 4, TFT_RED);
-        tft.setTextColor(TFT_WHITE);
-        tft.setTextDatum(MC_DATUM);
-        tft.drawString("STOP", TX_STOP_BTN_X + TX_STOP_BTN_W/2, TX_STOP_BTN_Y + TX_STOP_BTN_H/2, 2);
-        tft.setTextDatum(TL_DATUM);
+        gfx.fillRoundRect(TX_STOP_BTN_X, TX_STOP_BTN_Y, TX_STOP_BTN_W, TX_STOP_BTN_H, 4, TFT_RED);
+        gfx.setTextColor(TFT_WHITE);
+        gfx.setTextDatum(MC_DATUM);
+        gfx.drawString("STOP", TX_STOP_BTN_X + TX_STOP_BTN_W/2, TX_STOP_BTN_Y + TX_STOP_BTN_H/2, 2);
+        gfx.setTextDatum(TL_DATUM);
 
         y += 22;
 
         // Show detailed info for each active session
         for (int i = 0; i < TX_MAX_CONCURRENT && y < SCREEN_HEIGHT - NAV_BAR_HEIGHT - 10; i++) {
-            tx_session_t* session = txManager.getSession(i);
-            if (session && session->active && session->sig) {
+            tx_session_t session;
+            if (txManager.getSessionSnapshot(i, &session) && session.sig) {
                 // Device name with category color
                 uint16_t catColor = TFT_WHITE;
-                switch (session->sig->category) {
+                switch (session.sig->category) {
                     case CAT_TRACKER:  catColor = TFT_RED;     break;
                     case CAT_GLASSES:  catColor = TFT_ORANGE;  break;
                     case CAT_MEDICAL:  catColor = TFT_YELLOW;  break;
                     case CAT_WEARABLE: catColor = TFT_BLUE;    break;
                     case CAT_AUDIO:    catColor = TFT_MAGENTA; break;
                 }
-                tft.fillCircle(10, y + 6, 5, catColor);
-                tft.setTextColor(TFT_YELLOW);
-                tft.drawString(session->deviceName, 20, y);
+                gfx.fillCircle(10, y + 6, 5, catColor);
+                gfx.setTextColor(TFT_YELLOW);
+                gfx.drawString(session.deviceName, 20, y);
                 y += 16;
 
                 // MAC Address (BDADDR)
                 char macStr[24];
                 snprintf(macStr, sizeof(macStr), "MAC: %02X:%02X:%02X:%02X:%02X:%02X",
-                         session->currentMac[0], session->currentMac[1], session->currentMac[2],
-                         session->currentMac[3], session->currentMac[4], session->currentMac[5]);
-                tft.setTextColor(TFT_WHITE);
-                tft.drawString(macStr, 20, y);
+                         session.currentMac[0], session.currentMac[1], session.currentMac[2],
+                         session.currentMac[3], session.currentMac[4], session.currentMac[5]);
+                gfx.setTextColor(TFT_WHITE);
+                gfx.drawString(macStr, 20, y);
                 y += 14;
 
                 // Company ID and Category
                 char infoStr[40];
                 snprintf(infoStr, sizeof(infoStr), "Company: 0x%04X  Cat: %s",
-                         session->sig->company_id, getCategoryString(session->sig->category));
-                tft.setTextColor(TFT_DARKGREY);
-                tft.drawString(infoStr, 20, y);
+                         session.sig->company_id, getCategoryString(session.sig->category));
+                gfx.setTextColor(TFT_DARKGREY);
+                gfx.drawString(infoStr, 20, y);
                 y += 14;
 
                 // Packet stats
                 char statsStr[48];
-                snprintf(statsStr, sizeof(statsStr), "Packets: %lu  Interval: %lums",
-                         session->packetsSent, session->intervalMs);
-                tft.setTextColor(TFT_GREEN);
-                tft.drawString(statsStr, 20, y);
+                snprintf(statsStr, sizeof(statsStr), "Packets: %lu  Rate: %.1f/%.1f/s",
+                         session.packetsSent, txManager.getAchievedRate(&session),
+                         txManager.getRequestedRate(&session));
+                gfx.setTextColor(TFT_GREEN);
+                gfx.drawString(statsStr, 20, y);
                 y += 14;
 
                 // MAC mode indicator
-                if (session->randomMacPerPacket) {
-                    tft.setTextColor(TFT_CYAN);
-                    tft.drawString("Random MAC per packet", 20, y);
+                if (session.randomMacPerPacket) {
+                    gfx.setTextColor(TFT_CYAN);
+                    gfx.drawString("Random MAC per packet", 20, y);
                 } else {
-                    tft.setTextColor(TFT_GREEN);
-                    tft.drawString("Consistent MAC (session)", 20, y);
+                    gfx.setTextColor(TFT_GREEN);
+                    gfx.drawString("Consistent MAC (session)", 20, y);
                 }
                 y += 18;  // Spacing after MAC mode indicator
             }
@@ -1103,14 +1926,14 @@ void drawTXScreen() {
 
     } else {
         // No active TX - show tappable device list
-        tft.drawString("TAP TO TX", 4, y);
+        gfx.drawString("TAP TO TX", 4, y);
 
         // CONFUSE button (starts confusion mode with all trackers)
-        tft.fillRoundRect(TX_STOP_BTN_X, TX_STOP_BTN_Y, TX_STOP_BTN_W, TX_STOP_BTN_H, 4, TFT_MAGENTA);
-        tft.setTextColor(TFT_WHITE);
-        tft.setTextDatum(MC_DATUM);
-        tft.drawString("CONFUSE", TX_STOP_BTN_X + TX_STOP_BTN_W/2, TX_STOP_BTN_Y + TX_STOP_BTN_H/2, 2);
-        tft.setTextDatum(TL_DATUM);
+        gfx.fillRoundRect(TX_STOP_BTN_X, TX_STOP_BTN_Y, TX_STOP_BTN_W, TX_STOP_BTN_H, 4, TFT_MAGENTA);
+        gfx.setTextColor(TFT_WHITE);
+        gfx.setTextDatum(MC_DATUM);
+        gfx.drawString("CONFUSE", TX_STOP_BTN_X + TX_STOP_BTN_W/2, TX_STOP_BTN_Y + TX_STOP_BTN_H/2, 2);
+        gfx.setTextDatum(TL_DATUM);
 
         y += 16;
 
@@ -1123,16 +1946,16 @@ void drawTXScreen() {
                      txScrollOffset + 1,
                      min(txScrollOffset + TX_ITEMS_PER_PAGE, txCount),
                      txCount);
-            tft.setTextDatum(TR_DATUM);
-            tft.setTextColor(TFT_DARKGREY);
-            tft.drawString(scrollStr, SCREEN_WIDTH - 4, y - 16);
-            tft.setTextDatum(TL_DATUM);
+            gfx.setTextDatum(TR_DATUM);
+            gfx.setTextColor(TFT_DARKGREY);
+            gfx.drawString(scrollStr, SCREEN_WIDTH - 4, y - 16);
+            gfx.setTextDatum(TL_DATUM);
         }
 
         y = TX_LIST_START_Y;
 
         // Draw device list
-        tft.setTextColor(TFT_WHITE);
+        gfx.setTextColor(TFT_WHITE);
         int displayed = 0;
         for (int i = txScrollOffset; i < txCount && displayed < TX_ITEMS_PER_PAGE; i++) {
             const device_signature_t* sig = txManager.getTransmittableSignature(i);
@@ -1146,10 +1969,10 @@ void drawTXScreen() {
                     case CAT_WEARABLE: catColor = TFT_BLUE;    break;
                     case CAT_AUDIO:    catColor = TFT_MAGENTA; break;
                 }
-                tft.fillCircle(12, y + 7, 5, catColor);
+                gfx.fillCircle(12, y + 7, 5, catColor);
 
-                tft.setTextColor(TFT_WHITE);
-                tft.drawString(sig->name, 24, y);
+                gfx.setTextColor(TFT_WHITE);
+                gfx.drawString(sig->name, 24, y);
 
                 y += TX_ITEM_HEIGHT;
                 displayed++;
@@ -1159,21 +1982,24 @@ void drawTXScreen() {
         // Scroll indicators
         if (txCount > TX_ITEMS_PER_PAGE) {
             if (txScrollOffset > 0) {
-                tft.fillTriangle(SCREEN_WIDTH - 15, TX_LIST_START_Y,
+                gfx.fillTriangle(SCREEN_WIDTH - 15, TX_LIST_START_Y,
                                 SCREEN_WIDTH - 10, TX_LIST_START_Y - 6,
                                 SCREEN_WIDTH - 5, TX_LIST_START_Y, TFT_YELLOW);
             }
             if (txScrollOffset + TX_ITEMS_PER_PAGE < txCount) {
                 int arrowY = TX_LIST_START_Y + TX_ITEMS_PER_PAGE * TX_ITEM_HEIGHT - 5;
-                tft.fillTriangle(SCREEN_WIDTH - 15, arrowY,
+                gfx.fillTriangle(SCREEN_WIDTH - 15, arrowY,
                                 SCREEN_WIDTH - 10, arrowY + 6,
                                 SCREEN_WIDTH - 5, arrowY, TFT_YELLOW);
             }
         }
     }
+
+    contentFrame.push();
 }
 
 void drawFilterScreen() {
+    PERF_SCOPE(PERF_DRAW_FILTER);
     int y = STATUS_BAR_HEIGHT + 4;
     tft.fillRect(0, STATUS_BAR_HEIGHT, SCREEN_WIDTH, CONTENT_HEIGHT, TFT_BLACK);
 
@@ -1222,6 +2048,7 @@ void drawFilterScreen() {
 }
 
 void drawSettingsScreen() {
+    PERF_SCOPE(PERF_DRAW_SETTINGS);
     int y = STATUS_BAR_HEIGHT + 4;
     tft.fillRect(0, STATUS_BAR_HEIGHT, SCREEN_WIDTH, CONTENT_HEIGHT, TFT_BLACK);
 
@@ -1235,7 +2062,7 @@ void drawSettingsScreen() {
     tft.drawString("Scan Duration:", 4, y);
     tft.setTextColor(TFT_WHITE);
     char val[16];
-    snprintf(val, sizeof(val), "%d sec", BLE_SCAN_DURATION_SEC);
+    snprintf(val, sizeof(val), "Continuous");
     tft.drawString(val, 140, y);
     y += 18;
 
@@ -1247,15 +2074,15 @@ void drawSettingsScreen() {
     y += 18;
 
     tft.setTextColor(TFT_DARKGREY);
-    tft.drawString("JSON Output:", 4, y);
-    tft.setTextColor(jsonOutput ? TFT_GREEN : TFT_RED);
-    tft.drawString(jsonOutput ? "ON" : "OFF", 140, y);
+    tft.drawString("Output:", 4, y);
+    tft.setTextColor((jsonOutput || binaryOutput) ? TFT_GREEN : TFT_WHITE);
+    tft.drawString(binaryOutput ? "BINARY" : (jsonOutput ? "JSON" : "TEXT"), 140, y);
     y += 18;
 
     tft.setTextColor(TFT_DARKGREY);
     tft.drawString("Serial Baud:", 4, y);
     tft.setTextColor(TFT_WHITE);
-    snprintf(val, sizeof(val), "%d", SERIAL_BAUD_RATE);
+    snprintf(val, sizeof(val), "%lu", serialBaudRate);
     tft.drawString(val, 140, y);
     y += 28;
 
@@ -1267,7 +2094,7 @@ void drawSettingsScreen() {
     tft.setTextColor(TFT_DARKGREY);
     tft.drawString("Devices Detected:", 4, y);
     tft.setTextColor(TFT_WHITE);
-    snprintf(val, sizeof(val), "%d", detectedCount);
+    snprintf(val, sizeof(val), "%d", deviceTable.count());
     tft.drawString(val, 140, y);
     y += 18;
 
@@ -1288,13 +2115,26 @@ void drawSettingsScreen() {
 }
 
 void drawDetailScreen() {
-    if (selectedDeviceIdx < 0 || selectedDeviceIdx >= detectedCount) {
+    PERF_SCOPE(PERF_DRAW_DETAIL);
+    static device_snapshot_t snapshot;
+    bool valid;
+    {
+        DeviceTableLock lock;
+        int index = deviceSelected ? deviceTable.find(selectedMac) : -1;
+        valid = index >= 0;
+        if (valid) {
+            deviceTable.snapshot(index, &snapshot);
+        }
+    }
+    if (!valid) {
         currentScreen = 0;  // Return to scan screen if invalid
         drawScanScreen();
         return;
     }
 
-    DetectedDevice* dev = &detectedDevices[selectedDeviceIdx];
+    const DetectedDevice* dev = &snapshot.dev;
+    const DeviceDetail* detail = &snapshot.detail;
+    const device_signature_t* sig = deviceSignature(dev);
 
     tft.fillRect(0, STATUS_BAR_HEIGHT, SCREEN_WIDTH, CONTENT_HEIGHT, TFT_BLACK);
 
@@ -1315,7 +2155,7 @@ void drawDetailScreen() {
     // Device name
     tft.setTextDatum(TL_DATUM);
     tft.setTextColor(TFT_YELLOW, TFT_BLACK);
-    tft.drawString(dev->name, 4, y, 2);
+    tft.drawString(sig->name, 4, y, 2);
     y += 20;
 
     // Category with color
@@ -1339,13 +2179,17 @@ void drawDetailScreen() {
     tft.drawString("Threat:", 4, y, 1);
     tft.setTextColor(TFT_WHITE, TFT_BLACK);
     char threatStr[16];
-    snprintf(threatStr, sizeof(threatStr), "%d/5", dev->threatLevel);
+    snprintf(threatStr, sizeof(threatStr), "%d/5", sig->threat_level);
     tft.drawString(threatStr, 80, y, 1);
     // Draw threat dots
     for (int i = 0; i < 5; i++) {
-        uint16_t dotColor = (i < dev->threatLevel) ? TFT_RED : TFT_DARKGREY;
+        uint16_t dotColor = (i < sig->threat_level) ? TFT_RED : TFT_DARKGREY;
         tft.fillCircle(130 + i * 12, y + 4, 4, dotColor);
     }
+    if (dev->isFollower()) {
+        tft.setTextColor(TFT_RED, TFT_BLACK);
+        tft.drawString("FOLLOWING", 200, y, 1);
+    }
     y += 16;
 
     // MAC address
@@ -1357,11 +2201,16 @@ void drawDetailScreen() {
     tft.drawString("MAC:", 4, y, 1);
     tft.setTextColor(TFT_WHITE, TFT_BLACK);
     tft.drawString(macStr, 80, y, 1);
+    char clusterStr[24];
+    snprintf(clusterStr, sizeof(clusterStr), "C%u (%u MAC%s)", detail->clusterId,
+             detail->macCount, detail->macCount == 1 ? "" : "s");
+    tft.setTextColor(detail->macCount > 1 ? TFT_ORANGE : TFT_DARKGREY, TFT_BLACK);
+    tft.drawString(clusterStr, 200, y, 1);
     y += 14;
 
     // Company ID
     char companyStr[12];
-    snprintf(companyStr, sizeof(companyStr), "0x%04X", dev->companyId);
+    snprintf(companyStr, sizeof(companyStr), "0x%04X", sig->company_id);
     tft.setTextColor(TFT_DARKGREY, TFT_BLACK);
     tft.drawString("Company ID:", 4, y, 1);
     tft.setTextColor(TFT_WHITE, TFT_BLACK);
@@ -1371,8 +2220,11 @@ void drawDetailScreen() {
     // RSSI with signal strength indicator
     tft.setTextColor(TFT_DARKGREY, TFT_BLACK);
     tft.drawString("RSSI:", 4, y, 1);
-    char rssiStr[16];
-    snprintf(rssiStr, sizeof(rssiStr), "%d dBm", dev->rssi);
+    char rssiStr[40];
+    snprintf(rssiStr, sizeof(rssiStr), "%d dBm (last %d, %+d dB/%lus)", dev->rssi,
+             detail->track.raw, rssiTrackTrend(&detail->track),
+             (unsigned long)(detail->track.ringCount > 1 ?
+                             (detail->track.ringCount - 1) * RSSI_TRACK_SAMPLE_MS / 1000 : 0));
     uint16_t rssiColor = TFT_GREEN;
     if (dev->rssi < -70) rssiColor = TFT_YELLOW;
     if (dev->rssi < -85) rssiColor = TFT_RED;
@@ -1384,14 +2236,19 @@ void drawDetailScreen() {
     tft.setTextColor(TFT_DARKGREY, TFT_BLACK);
     tft.drawString("Detections:", 4, y, 1);
     char countStr[16];
-    snprintf(countStr, sizeof(countStr), "%d", dev->detectionCount);
+    snprintf(countStr, sizeof(countStr), "%d", detail->detectionCount);
     tft.setTextColor(TFT_WHITE, TFT_BLACK);
     tft.drawString(countStr, 80, y, 1);
+    char dwellStr[24];
+    snprintf(dwellStr, sizeof(dwellStr), "In range %lum",
+             (unsigned long)(rssiTrackDwellMs(&detail->track) / 60000));
+    tft.setTextColor(TFT_DARKGREY, TFT_BLACK);
+    tft.drawString(dwellStr, 200, y, 1);
     y += 14;
 
     // First/Last seen times
     uint32_t now = millis();
-    uint32_t firstAgo = (now - dev->firstSeen) / 1000;
+    uint32_t firstAgo = (now - detail->firstSeen) / 1000;
     uint32_t lastAgo = (now - dev->lastSeen) / 1000;
 
     tft.setTextColor(TFT_DARKGREY, TFT_BLACK);
@@ -1407,6 +2264,21 @@ void drawDetailScreen() {
     snprintf(timeStr, sizeof(timeStr), "%lus ago", lastAgo);
     tft.setTextColor(TFT_WHITE, TFT_BLACK);
     tft.drawString(timeStr, 80, y, 1);
+    y += 14;
+
+    // Advertised fields from the last payload
+    char advName[16];
+    if (advCopyName(&detail->view, detail->payload, advName, sizeof(advName)) == 0) {
+        snprintf(advName, sizeof(advName), "-");
+    }
+    char advStr[48];
+    snprintf(advStr, sizeof(advStr), "%s  U16:%u U128:%u MFG:%uB", advName,
+             detail->view.uuid16Count, detail->view.uuid128Count,
+             advHasMfgData(&detail->view) ? detail->view.mfgLen : 0);
+    tft.setTextColor(TFT_DARKGREY, TFT_BLACK);
+    tft.drawString("Advertised:", 4, y, 1);
+    tft.setTextColor(TFT_WHITE, TFT_BLACK);
+    tft.drawString(advStr, 80, y, 1);
 
     // No nav bar in detail view - just show back hint
     tft.fillRect(0, SCREEN_HEIGHT - NAV_BAR_HEIGHT, SCREEN_WIDTH, NAV_BAR_HEIGHT, TFT_DARKGREY);
@@ -1420,17 +2292,20 @@ void drawDetailScreen() {
 // =============================================================================
 void initBLE() {
     BLEDevice::init("BLEPTD");
-    pBLEScan = BLEDevice::getScan();
-    pBLEScan->setAdvertisedDeviceCallbacks(new ScanCallbacks(), true);
-    pBLEScan->setActiveScan(BLE_ACTIVE_SCAN);
-    pBLEScan->setInterval(BLE_SCAN_INTERVAL_MS);
-    pBLEScan->setWindow(BLE_SCAN_WINDOW_MS);
+    bleHalInit();
+
+    // Continuous scanning on its own task (core 0) keeps the match task free to drain the ring.
+    // BLEDevice::getScan() is never called, so the library's BLEScan (which
+    // allocates an object per report) stays out of the GAP event path.
+    bleScanner.init();
+    bleScanner.startTask();
 
     // Initialize TX manager
     txManager.init();
 }
 
 void initSerial() {
+    Serial.setTxBufferSize(SERIAL_TX_BUFFER_SIZE);  // Must precede begin()
     Serial.begin(SERIAL_BAUD_RATE);
     Serial.println();
     Serial.println("=================================");
@@ -1440,6 +2315,20 @@ void initSerial() {
     Serial.println("Type HELP for commands");
 }
 
+// The controller also pulls PENIRQ low while it converts, so edges caused
+// by our own reads are ignored
+static volatile bool touchReading = false;
+
+static void IRAM_ATTR touchIrq() {
+    if (!touchReading) {
+        uiEvents.postFromISR(UI_EVENT_TOUCH);
+    }
+}
+
+static bool touchPressed() {
+    return digitalRead(XPT2046_IRQ) == LOW;
+}
+
 void initTouch() {
     // Set up touch CS pin first
     pinMode(XPT2046_CS, OUTPUT);
@@ -1454,6 +2343,11 @@ void initTouch() {
     ts.begin(touchSpi);
     ts.setRotation(0);  // Handle rotation in software mapping
 
+    // PENIRQ goes low while the panel is pressed (GPIO 36 is input only,
+    // the CYD has the pull-up on board)
+    pinMode(XPT2046_IRQ, INPUT);
+    attachInterrupt(digitalPinToInterrupt(XPT2046_IRQ), touchIrq, FALLING);
+
     Serial.println("Touch screen initialized");
 }
 
@@ -1472,7 +2366,9 @@ void handleTouch() {
     const uint32_t TOUCH_DEBOUNCE_MS = 250;
 
     // Read the touch point
+    touchReading = true;
     TS_Point p = ts.getPoint();
+    touchReading = false;
 
     // Check for valid touch based on pressure (z) value
     if (p.z < 100) {
@@ -1483,6 +2379,9 @@ void handleTouch() {
         return;
     }
 
+    // Touch handling draws to the panel directly
+    contentFrame.waitIdle();
+
     // Wake screen on any touch (reset power save timer)
     if (screenAsleep) {
         wakeScreen();
@@ -1535,14 +2434,9 @@ void handleTouch() {
         }
     }
     // Handle scan screen - device selection and scrolling
-    else if (currentScreen == 0 && touchY > STATUS_BAR_HEIGHT && detectedCount > 0) {
+    else if (currentScreen == 0 && touchY > STATUS_BAR_HEIGHT && deviceTable.count() > 0) {
         // Count filtered devices for scroll bounds
-        int filteredCount = 0;
-        for (int i = 0; i < detectedCount; i++) {
-            if (detectedDevices[i].category & categoryFilter) {
-                filteredCount++;
-            }
-        }
+        int filteredCount = countFilteredDevices();
 
         int listStartY = STATUS_BAR_HEIGHT + 24;
         int listEndY = SCREEN_HEIGHT - NAV_BAR_HEIGHT;
@@ -1564,18 +2458,26 @@ void handleTouch() {
             int targetFilteredIdx = scrollOffset + itemIdx;
 
             // Find the actual device index that matches this filtered position
-            int filteredIdx = 0;
-            for (int i = 0; i < detectedCount; i++) {
-                if (detectedDevices[i].category & categoryFilter) {
-                    if (filteredIdx == targetFilteredIdx) {
-                        selectedDeviceIdx = i;
-                        currentScreen = 4;  // Switch to detail view
-                        drawDetailScreen();
-                        break;
+            bool selected = false;
+            {
+                DeviceTableLock lock;
+                int filteredIdx = 0;
+                for (int i = 0; i < deviceTable.count(); i++) {
+                    if (deviceTable.at(i)->category & categoryFilter) {
+                        if (filteredIdx == targetFilteredIdx) {
+                            memcpy(selectedMac, deviceTable.at(i)->mac, 6);
+                            selected = true;
+                            break;
+                        }
+                        filteredIdx++;
                     }
-                    filteredIdx++;
                 }
             }
+            if (selected) {
+                deviceSelected = true;
+                currentScreen = 4;  // Switch to detail view
+                drawDetailScreen();
+            }
         }
     }
     // Handle filter screen category toggles
@@ -1625,12 +2527,6 @@ void handleTouch() {
             tft.fillRoundRect(TX_STOP_BTN_X, TX_STOP_BTN_Y, TX_STOP_BTN_W, TX_STOP_BTN_H, 4, TFT_WHITE);
             delay(50);
 
-            // Stop any active scan
-            if (scanning) {
-                pBLEScan->stop();
-                delay(50);
-            }
-
             // Clear any existing confusion entries and add ALL transmittable devices
             txManager.confuseClear();
 
@@ -1683,12 +2579,6 @@ void handleTouch() {
                         tft.fillRect(0, highlightY, SCREEN_WIDTH, TX_ITEM_HEIGHT, TFT_DARKGREY);
                         delay(100);
 
-                        // Stop any active scan
-                        if (scanning) {
-                            pBLEScan->stop();
-                            delay(50);
-                        }
-
                         // Start TX for selected device (consistent MAC per session)
                         int result = txManager.startTx(sig->name, TX_DEFAULT_INTERVAL_MS, -1, false);
                         if (result >= 0) {
@@ -1724,9 +2614,16 @@ void loadPowerSaveConfig() {
             configFile.println("# BLEPTD Power Save Configuration");
             configFile.println("# powersave_enabled: true/false");
             configFile.println("# powersave_timeout_sec: seconds until screen sleep (default 300 = 5 min)");
+            configFile.println("# powersave_light_sleep: true/false, light sleep while the screen is off");
+            configFile.println("# uplink_mode: off/node/collector (ESP-NOW uplink)");
+            configFile.println("# uplink_peer: collector MAC for nodes (default broadcast)");
+            configFile.println("# uplink_channel: Wi-Fi channel 1-13, same on all units");
+            configFile.println("# uplink_interval_ms: node batch period");
             configFile.println("");
             configFile.println("powersave_enabled=true");
             configFile.println("powersave_timeout_sec=300");
+            configFile.println("powersave_light_sleep=true");
+            configFile.println("uplink_mode=off");
             configFile.close();
             Serial.println("Created default config file: " POWERSAVE_CONFIG_FILE);
         }
@@ -1770,6 +2667,35 @@ void loadPowerSaveConfig() {
             if (powerSaveTimeoutSec > 3600) powerSaveTimeoutSec = 3600;  // Maximum 1 hour
             Serial.printf("  powersave_timeout_sec = %lu\n", powerSaveTimeoutSec);
         }
+        else if (key == "powersave_light_sleep") {
+            bool allowed = (value == "true" || value == "1" || value == "yes");
+            powerMgr.setLightSleepAllowed(allowed);
+            Serial.printf("  powersave_light_sleep = %s\n", allowed ? "true" : "false");
+        }
+        else if (key == "uplink_mode") {
+            uplink.setMode(value == "node" ? UPLINK_NODE :
+                           value == "collector" ? UPLINK_COLLECTOR : UPLINK_OFF);
+            Serial.printf("  uplink_mode = %s\n", uplink.getModeString());
+        }
+        else if (key == "uplink_peer") {
+            uint8_t mac[6];
+            if (macParse(value.c_str(), mac)) {
+                uplink.setPeer(mac);
+                Serial.printf("  uplink_peer = %s\n", value.c_str());
+            }
+        }
+        else if (key == "uplink_channel") {
+            if (uplink.setChannel((uint8_t)value.toInt())) {
+                Serial.printf("  uplink_channel = %u\n", uplink.getChannel());
+            }
+        }
+        else if (key == "uplink_interval_ms") {
+            uint32_t ms = value.toInt();
+            if (ms >= UPLINK_INTERVAL_MIN_MS && ms <= UPLINK_INTERVAL_MAX_MS) {
+                uplink.setInterval(ms);
+                Serial.printf("  uplink_interval_ms = %lu\n", ms);
+            }
+        }
     }
 
     configFile.close();
@@ -1778,6 +2704,7 @@ void loadPowerSaveConfig() {
 
 void wakeScreen() {
     if (screenAsleep) {
+        powerMgr.setIdle(false);
         digitalWrite(TFT_BL_PIN, HIGH);
         screenAsleep = false;
         Serial.println("[PowerSave] Screen woke up - new device detected");
@@ -1798,10 +2725,16 @@ void wakeScreen() {
     lastNewDeviceTime = millis();  // Reset timer
 }
 
+// Callable from any task; the UI task wakes the screen on its next frame
+void requestScreenWake() {
+    uiEvents.post(UI_EVENT_WAKE);
+}
+
 void sleepScreen() {
     if (!screenAsleep) {
         digitalWrite(TFT_BL_PIN, LOW);
         screenAsleep = true;
+        powerMgr.setIdle(true);
         Serial.println("[PowerSave] Screen sleeping - no new devices");
     }
 }
@@ -1817,87 +2750,171 @@ void checkPowerSave() {
 }
 
 // =============================================================================
-// MAIN
+// PIPELINE TASKS
 // =============================================================================
-void setup() {
-    initSerial();
-    loadPowerSaveConfig();  // Load power save settings from SPIFFS
-    initDisplay();
-    initTouch();
-    initBLE();
+// Core 0: GAP callback -> scan ring -> match task -> device table, journal
+//         and detection events.
+// Core 1: serial task (commands, event encoding) and UI task (touch, power
+//         save, display). Neither can stall the matcher: the UI copies rows
+//         under the table lock and draws from the copies, and events wait in
+//         a queue that drops when the UART falls behind.
+
+// Scan side: woken by every queued report, with a timeout for the periodic
+// work (journal hand-off, expiry, scan scheduling)
+static void matchTask(void* param) {
+    uint32_t lastExpireCheck = 0;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MATCH_IDLE_MS));
+        powerMgr.countWakeup();
+
+        // Match queued advertisements and update the device table
+        processScanResults();
+
+        uint32_t now = millis();
+        detLog.poll(now);
+
+        // Age out devices that have not been seen recently
+        if (now - lastExpireCheck > 1000) {
+            DeviceTableLock lock;
+            uint32_t version = deviceTable.getVersion();
+            deviceTable.expire(now);
+            postTableEvents(version);
+            lastExpireCheck = now;
+        }
 
-    drawScanScreen();
+        // TX runs on its own task; just track whether it is active
+        txActive = txManager.getActiveCount() > 0 || txManager.isConfusionActive();
 
-    // Initialize power save timer
-    lastNewDeviceTime = millis();
+        // BLE scanning keeps running during TX; the scheduler narrows the scan
+        // window to leave air time and follows density and power save
+        bleScanner.setEnabled(scanning);
+        scanScheduler.update(now, txActive, powerSaveEnabled && screenAsleep);
+        powerMgr.update(now);
 
-    Serial.println("Initialization complete. Starting scan...");
-    scanning = true;
+        // Screen off: let reports collect in the ring and take them as one
+        // batch, instead of waking once per advertisement
+        if (powerMgr.isIdle()) {
+            vTaskDelay(pdMS_TO_TICKS(MATCH_BATCH_IDLE_MS));
+        }
+    }
 }
 
-void loop() {
-    // Check power save (screen sleep/wake)
-    checkPowerSave();
+// Command input and the event encoder; output may block on the UART here
+// without holding anything else up
+static void serialTask(void* param) {
+    static det_event_t ev;
+    static uplink_packet_t pkt;
+    for (;;) {
+        // Woken by UART RX and by posted events; the raw stream is
+        // written at least every RAW_STREAM_FLUSH_MS
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(rawStreamIsEnabled() ? RAW_STREAM_FLUSH_MS
+                                                                    : SERIAL_IDLE_MS));
+        powerMgr.countWakeup();
+
+        while (Serial.available()) {
+            char c = Serial.read();
+            if (c == '\n' || c == '\r') {
+                if (cmdIndex > 0) {
+                    cmdBuffer[cmdIndex] = '\0';
+                    processSerialCommand(cmdBuffer);
+                    cmdIndex = 0;
+                }
+            } else if (cmdIndex < SERIAL_CMD_BUFFER_SIZE - 1) {
+                cmdBuffer[cmdIndex++] = c;
+            }
+        }
 
-    // Process touch input
-    handleTouch();
-
-    // Process serial commands
-    while (Serial.available()) {
-        char c = Serial.read();
-        if (c == '\n' || c == '\r') {
-            if (cmdIndex > 0) {
-                cmdBuffer[cmdIndex] = '\0';
-                processSerialCommand(cmdBuffer);
-                cmdIndex = 0;
+        while (detEvents.receive(&ev, 0)) {
+            PERF_SCOPE(PERF_DET_EVENT);
+            if (ev.type == DET_EVENT_FOLLOWER) {
+                outputFollower(&ev.snapshot);
+            } else {
+                outputDetection(&ev.snapshot);
             }
-        } else if (cmdIndex < SERIAL_CMD_BUFFER_SIZE - 1) {
-            cmdBuffer[cmdIndex++] = c;
         }
+
+        // Collector: packets from uplink nodes
+        while (uplink.receive(&pkt)) {
+            outputRemote(&pkt);
+        }
+
+        rawStreamPoll();
     }
+}
 
-    // Process TX manager (handles timing and packet transmission)
-    txManager.process();
+// What the last frame left undone, and when it has to be picked up
+typedef struct {
+    bool touchHeld;                     // Panel still pressed after the last read
+    bool listDirty;                     // Scan rows may have changed
+    bool rssiDirty;                     // RSSI cells wait for SCAN_RSSI_REFRESH_MS
+    bool txDirty;                       // TX screen waits for UI_TX_REFRESH_MS
+    uint8_t lastScreen;
+    uint16_t lastMode;                  // Status bar mode shown
+    uint32_t lastTxUpdate;
+} ui_state_t;
+
+static ui_state_t uiState = { false, false, false, false, 255, 0xFFFF, 0 };
+
+// Everything drawStatusBar() shows that can change
+static uint16_t statusModeKey() {
+    if (txManager.isConfusionActive()) {
+        return 0xFFFE;
+    }
+    return (uint16_t)(txManager.getActiveCount() << 1) | (scanning ? 1 : 0);
+}
 
-    // Update txActive state
-    txActive = txManager.getActiveCount() > 0 || txManager.isConfusionActive();
+static void uiFrame(uint32_t events) {
+    PERF_SCOPE(PERF_UI_FRAME);
+    uiEvents.countFrame();
+    ui_state_t* st = &uiState;
 
-    // BLE scanning (skip if TX is active to avoid conflicts)
-    // Only scan every 5 seconds to allow touch polling between scans
-    static uint32_t lastScanTime = 0;
-    if (scanning && !txActive && (millis() - lastScanTime > 5000)) {
-        lastScanTime = millis();
-        BLEScanResults results = pBLEScan->start(BLE_SCAN_DURATION_SEC, false);
-        pBLEScan->clearResults();
+    // Other tasks only ask for a wake; the panel belongs to this task
+    if (events & UI_EVENT_WAKE) {
+        contentFrame.waitIdle();
+        wakeScreen();
     }
 
-    // Update display only when needed
-    static uint8_t lastScreen = 255;
-    static int lastDetectedCount = -1;
-    static uint32_t lastStatusUpdate = 0;
-    static uint32_t lastTxUpdate = 0;
+    // Touch is read on PENIRQ and then polled only until release. GPIO
+    // interrupts don't fire in light sleep, so the line is polled there.
+    bool sleepPoll = screenAsleep && powerMgr.isLightSleepActive() && touchPressed();
+    if ((events & UI_EVENT_TOUCH) || st->touchHeld || sleepPoll) {
+        handleTouch();
+        st->touchHeld = touchPressed();
+    }
 
-    bool screenChanged = (lastScreen != currentScreen);
-    bool contentChanged = (currentScreen == 0 && detectedCount != lastDetectedCount);
+    // Check power save (screen sleep/wake)
+    checkPowerSave();
+    if (screenAsleep) {
+        // wakeScreen() redraws everything; nothing to keep
+        st->listDirty = st->rssiDirty = st->txDirty = false;
+        st->lastScreen = currentScreen;
+        return;
+    }
 
-    // Update TX screen every 500ms when TX is active
-    bool txScreenNeedsUpdate = false;
-    if (currentScreen == 2 && txActive && (millis() - lastTxUpdate > 500)) {
-        txScreenNeedsUpdate = true;
-        lastTxUpdate = millis();
+    if (events & UI_EVENT_DEVICE_LIST) {
+        st->listDirty = true;
+    }
+    if (events & UI_EVENT_DEVICE_RSSI) {
+        st->rssiDirty = true;
     }
+    if (events & UI_EVENT_TX) {
+        st->txDirty = true;
+    }
+
+    uint32_t now = millis();
+    bool screenChanged = st->lastScreen != currentScreen || (events & UI_EVENT_SCREEN);
 
-    // Redraw status bar every 2 seconds (for mode indicator updates)
-    if (millis() - lastStatusUpdate > 2000) {
+    // Status bar only when the mode it shows changed
+    uint16_t mode = statusModeKey();
+    if (mode != st->lastMode && !screenChanged) {
+        contentFrame.waitIdle();
         drawStatusBar();
-        lastStatusUpdate = millis();
     }
+    st->lastMode = mode;
 
-    // Redraw content only when screen changes or content updates
-    if (screenChanged || contentChanged || txScreenNeedsUpdate) {
-        if (screenChanged) {
-            drawStatusBar();
-        }
+    if (screenChanged) {
+        contentFrame.waitIdle();
+        drawStatusBar();
         switch (currentScreen) {
             case 0: drawScanScreen(); break;
             case 1: drawFilterScreen(); break;
@@ -1908,10 +2925,149 @@ void loop() {
         if (currentScreen != 4) {
             drawNavBar();
         }
+        st->lastScreen = currentScreen;
+        st->listDirty = st->rssiDirty = st->txDirty = false;
+        st->lastTxUpdate = now;
+        return;
+    }
+
+    if (currentScreen == 0) {
+        // Rows right away; RSSI-only changes at the refresh rate
+        bool rssiDue = st->rssiDirty && now - lastScanRssiRefresh >= SCAN_RSSI_REFRESH_MS;
+        if (st->listDirty || rssiDue) {
+            updateScanScreen();
+            st->listDirty = false;
+            if (rssiDue) {
+                st->rssiDirty = false;
+            }
+        }
+    } else {
+        st->listDirty = st->rssiDirty = false;
+    }
+
+    if (currentScreen == 2) {
+        if (st->txDirty && now - st->lastTxUpdate >= UI_TX_REFRESH_MS) {
+            contentFrame.waitIdle();
+            drawTXScreen();
+            drawNavBar();
+            st->txDirty = false;
+            st->lastTxUpdate = now;
+        }
+    } else {
+        st->txDirty = false;
+    }
+}
+
+// How long the UI task may sleep when no event arrives
+static uint32_t uiIdleMs() {
+    const ui_state_t* st = &uiState;
+    uint32_t now = millis();
+    uint32_t wait = UI_IDLE_MS;
+
+    if (st->touchHeld) {
+        wait = min(wait, (uint32_t)TOUCH_POLL_MS);
+    }
+    if (screenAsleep && powerMgr.isLightSleepActive()) {
+        wait = min(wait, (uint32_t)TOUCH_SLEEP_POLL_MS);
+    }
+    if (st->rssiDirty) {
+        uint32_t since = now - lastScanRssiRefresh;
+        wait = min(wait, since < SCAN_RSSI_REFRESH_MS ? SCAN_RSSI_REFRESH_MS - since : 0);
+    }
+    if (st->txDirty) {
+        uint32_t since = now - st->lastTxUpdate;
+        wait = min(wait, since < UI_TX_REFRESH_MS ? UI_TX_REFRESH_MS - since : 0);
+    }
+    if (powerSaveEnabled && !screenAsleep && !txActive) {
+        uint32_t since = now - lastNewDeviceTime;
+        uint32_t timeout = powerSaveTimeoutSec * 1000UL;
+        wait = min(wait, since < timeout ? timeout - since : 0);
+    }
+    return wait;
+}
+
+// Sleeps until something changes, then draws at most one frame per
+// UI_FRAME_MIN_MS; events posted in between are merged into the next frame
+static void uiTask(void* param) {
+    for (;;) {
+        uint32_t events = uiEvents.wait(pdMS_TO_TICKS(uiIdleMs()));
+        powerMgr.countWakeup();
+        uint32_t start = millis();
+        uiFrame(events);
+        uint32_t took = millis() - start;
+        if (took < UI_FRAME_MIN_MS) {
+            vTaskDelay(pdMS_TO_TICKS(UI_FRAME_MIN_MS - took));
+        }
+    }
+}
+
+// Runs on the UART event task
+static void onSerialRx() {
+    TaskHandle_t task = serialTaskHandle;
+    if (task != nullptr) {
+        xTaskNotifyGive(task);
+    }
+}
+
+// The observer runs on the TX task or the command's task
+static void onTxChange() {
+    uiEvents.post(UI_EVENT_TX | UI_EVENT_MODE);
+}
 
-        lastScreen = currentScreen;
-        lastDetectedCount = detectedCount;
+static bool startTask(TaskFunction_t entry, const char* name, uint32_t stack,
+                      UBaseType_t priority, BaseType_t core, TaskHandle_t* handle) {
+    if (xTaskCreatePinnedToCore(entry, name, stack, nullptr, priority, handle, core) != pdPASS) {
+        *handle = nullptr;
+        Serial.printf("[MAIN] Failed to create %s task\n", name);
+        return false;
     }
+    return true;
+}
+
+// =============================================================================
+// MAIN
+// =============================================================================
+void setup() {
+    initSerial();
+    loadPowerSaveConfig();  // Load power save settings from SPIFFS
+    powerMgr.init();
+    sigDb.init();           // Merge SPIFFS signatures with the builtins
+    allowList.init();       // Known-good devices, before the scan starts
+    deviceTable.init();
+    detEvents.init();
+    rawStreamInit();
+    detLog.init();          // Resume the detection journal
+    initDisplay();
+    initTouch();
+    initBLE();
+
+    drawScanScreen();
+
+    // Initialize power save timer
+    lastNewDeviceTime = millis();
+
+    Serial.println("Initialization complete. Starting scan...");
+    scanning = true;
+
+    startTask(matchTask, "det_match", TASK_MATCH_STACK, TASK_MATCH_PRIORITY,
+              TASK_MATCH_CORE, &matchTaskHandle);
+    bleScanner.setConsumer(matchTaskHandle);
+    startTask(serialTask, "serial", TASK_SERIAL_STACK, TASK_SERIAL_PRIORITY,
+              TASK_SERIAL_CORE, &serialTaskHandle);
+    detEvents.setConsumer(serialTaskHandle);
+    rawStreamSetConsumer(serialTaskHandle);
+    Serial.onReceive(onSerialRx);
+    startTask(uiTask, "ui", TASK_UI_STACK, TASK_UI_PRIORITY,
+              TASK_UI_CORE, &uiTaskHandle);
+    uiEvents.setTask(uiTaskHandle);
+    txManager.setObserver(onTxChange);
+
+    // After the serial task exists; starts the mode set in /config.txt
+    uplink.setConsumer(serialTaskHandle);
+    uplink.init();
+}
 
-    delay(10);
+// Everything runs on the pipeline tasks; the Arduino loop task isn't needed
+void loop() {
+    vTaskDelete(nullptr);
 }
@@ -0,0 +1,536 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Uplink Implementation
+ */
+
+#include "uplink.h"
+#include "../detection/device_table.h"
+#include "../ble/scanner.h"
+#include "../ble/scan_sched.h"
+#include "../serial/bin_records.h"
+#include "../util/power_mgr.h"
+#include <WiFi.h>
+#include <esp_wifi.h>
+#include <esp_now.h>
+#include <esp_idf_version.h>
+#if ESP_IDF_VERSION_MAJOR >= 5
+#include <esp_mac.h>
+#else
+#include <esp_system.h>
+#endif
+
+// Global instance
+Uplink uplink;
+
+static const uint8_t BROADCAST_MAC[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+// Sighting ages are sent in 100 ms units
+#define UPLINK_AGE_UNIT_MS      100
+
+// =============================================================================
+// ENTRY DECODING
+// =============================================================================
+bool uplinkNextEntry(const uint8_t* data, size_t len, size_t* pos, uplink_entry_t* out) {
+    size_t p = *pos;
+    if (p + sizeof(uplink_entry_header_t) > len) {
+        return false;
+    }
+    out->fields = data[p];
+    memcpy(out->mac, &data[p + 1], 6);
+    p += sizeof(uplink_entry_header_t);
+
+    out->sigId = BIN_SIG_NONE;
+    out->category = 0;
+    out->threatLevel = 0;
+    out->rssi = 0;
+    out->ageMs = 0;
+
+    size_t need = ((out->fields & UPLINK_FIELD_SIG) ? 4 : 0) +
+                  ((out->fields & UPLINK_FIELD_RSSI) ? 1 : 0) +
+                  ((out->fields & UPLINK_FIELD_SEEN) ? 2 : 0);
+    if (p + need > len) {
+        return false;
+    }
+    if (out->fields & UPLINK_FIELD_SIG) {
+        out->sigId = data[p] | (data[p + 1] << 8);
+        out->category = data[p + 2];
+        out->threatLevel = data[p + 3];
+        p += 4;
+    }
+    if (out->fields & UPLINK_FIELD_RSSI) {
+        out->rssi = (int8_t)data[p++];
+    }
+    if (out->fields & UPLINK_FIELD_SEEN) {
+        out->ageMs = (uint32_t)(data[p] | (data[p + 1] << 8)) * UPLINK_AGE_UNIT_MS;
+        p += 2;
+    }
+    *pos = p;
+    return true;
+}
+
+// =============================================================================
+// CONSTRUCTOR
+// =============================================================================
+Uplink::Uplink() {
+    _mode = UPLINK_OFF;
+    _channel = UPLINK_CHANNEL_DEFAULT;
+    memcpy(_peer, BROADCAST_MAC, 6);
+    _intervalMs = UPLINK_INTERVAL_MS;
+    _wifiUp = false;
+    _error = nullptr;
+    _task = nullptr;
+    _consumer = nullptr;
+    _rxQueue = nullptr;
+    memset(_shadow, 0, sizeof(_shadow));
+    memset(_packetLen, 0, sizeof(_packetLen));
+    _seq = 0;
+    _batches = 0;
+    _sent = 0;
+    _failed = 0;
+    _deferred = 0;
+    _unscheduled = 0;
+    memset(_nodes, 0, sizeof(_nodes));
+    _nodeCount = 0;
+    _received = 0;
+    _rxDropped = 0;
+}
+
+// =============================================================================
+// INITIALIZATION
+// =============================================================================
+bool Uplink::init() {
+    if (_task != nullptr) {
+        return true;
+    }
+    _rxQueue = xQueueCreate(UPLINK_RX_QUEUE_SIZE, sizeof(uplink_packet_t));
+    if (_rxQueue == nullptr ||
+        xTaskCreatePinnedToCore(taskEntry, "uplink", TASK_UPLINK_STACK, this,
+                                TASK_UPLINK_PRIORITY, &_task, TASK_UPLINK_CORE) != pdPASS) {
+        _task = nullptr;
+        Serial.println("[UPLINK] Failed to start, uplink disabled");
+        return false;
+    }
+
+    // Apply what /config.txt asked for
+    uplink_mode_t mode = _mode;
+    _mode = UPLINK_OFF;
+    return setMode(mode);
+}
+
+// =============================================================================
+// WI-FI AND ESP-NOW
+// =============================================================================
+// The callback signatures changed with ESP-IDF 5
+#if ESP_IDF_VERSION_MAJOR >= 5
+static void espNowRecv(const esp_now_recv_info_t* info, const uint8_t* data, int len) {
+    uplink.handleReceive(info->src_addr, data, len);
+}
+#else
+static void espNowRecv(const uint8_t* mac, const uint8_t* data, int len) {
+    uplink.handleReceive(mac, data, len);
+}
+#endif
+
+static void espNowSent(const uint8_t* mac, esp_now_send_status_t status) {
+    uplink.handleSent(status == ESP_NOW_SEND_SUCCESS);
+}
+
+bool Uplink::startWifi() {
+    if (_wifiUp) {
+        return true;
+    }
+
+    // STA mode without joining a network; ESP-NOW only needs the channel
+    if (!WiFi.mode(WIFI_STA)) {
+        _error = "Wi-Fi start failed";
+        return false;
+    }
+    esp_wifi_set_channel(_channel, WIFI_SECOND_CHAN_NONE);
+    if (esp_now_init() != ESP_OK) {
+        WiFi.mode(WIFI_OFF);
+        _error = "ESP-NOW init failed";
+        return false;
+    }
+    esp_now_register_recv_cb(espNowRecv);
+    esp_now_register_send_cb(espNowSent);
+    _wifiUp = true;
+
+    // Light sleep would take the Wi-Fi radio down between packets
+    powerMgr.setWifiActive(true);
+    return true;
+}
+
+void Uplink::stopWifi() {
+    if (!_wifiUp) {
+        return;
+    }
+    esp_now_deinit();
+    WiFi.mode(WIFI_OFF);
+    _wifiUp = false;
+    powerMgr.setWifiActive(false);
+}
+
+bool Uplink::addPeer() {
+    if (esp_now_is_peer_exist(_peer)) {
+        return true;
+    }
+    esp_now_peer_info_t peer;
+    memset(&peer, 0, sizeof(peer));
+    memcpy(peer.peer_addr, _peer, 6);
+    peer.channel = 0;                   // Current channel
+    peer.ifidx = WIFI_IF_STA;
+    peer.encrypt = false;
+    return esp_now_add_peer(&peer) == ESP_OK;
+}
+
+// =============================================================================
+// SETTINGS
+// =============================================================================
+bool Uplink::setMode(uplink_mode_t mode) {
+    if (_task == nullptr) {
+        _mode = mode;                   // Before init(): just remember it
+        return true;
+    }
+    if (mode == _mode) {
+        return true;
+    }
+
+    stopWifi();
+    scanScheduler.setUplinkListen(false);
+    _mode = UPLINK_OFF;
+    _error = nullptr;
+    if (mode == UPLINK_OFF) {
+        return true;
+    }
+
+    if (!startWifi()) {
+        return false;
+    }
+    if (mode == UPLINK_NODE) {
+        if (!addPeer()) {
+            stopWifi();
+            _error = "peer rejected";
+            return false;
+        }
+        // Start with a refresh so the collector learns every device
+        memset(_shadow, 0, sizeof(_shadow));
+        _batches = 0;
+    } else {
+        scanScheduler.setUplinkListen(true);
+    }
+    _mode = mode;
+    xTaskNotifyGive(_task);
+    return true;
+}
+
+bool Uplink::setChannel(uint8_t channel) {
+    if (channel < 1 || channel > 13) {
+        return false;
+    }
+    _channel = channel;
+    if (_wifiUp) {
+        esp_wifi_set_channel(_channel, WIFI_SECOND_CHAN_NONE);
+    }
+    return true;
+}
+
+void Uplink::setPeer(const uint8_t* mac) {
+    if (_wifiUp && esp_now_is_peer_exist(_peer)) {
+        esp_now_del_peer(_peer);
+    }
+    memcpy(_peer, mac != nullptr ? mac : BROADCAST_MAC, 6);
+    if (_wifiUp && _mode == UPLINK_NODE) {
+        addPeer();
+    }
+}
+
+void Uplink::getAddress(uint8_t* mac) {
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+}
+
+bool Uplink::isBroadcast() {
+    return memcmp(_peer, BROADCAST_MAC, 6) == 0;
+}
+
+const char* Uplink::getModeString() {
+    switch (_mode) {
+        case UPLINK_NODE:      return "node";
+        case UPLINK_COLLECTOR: return "collector";
+        default:               return "off";
+    }
+}
+
+// =============================================================================
+// NODE: BATCHING
+// =============================================================================
+void Uplink::taskEntry(void* param) {
+    static_cast<Uplink*>(param)->run();
+}
+
+void Uplink::run() {
+    for (;;) {
+        // Woken early by mode changes
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(_mode == UPLINK_NODE ? _intervalMs : 1000));
+        if (_mode != UPLINK_NODE) {
+            continue;
+        }
+
+        bool refresh = (_batches % UPLINK_REFRESH_BATCHES) == 0;
+        int packets = buildBatch(millis(), refresh);
+        _batches++;
+        if (packets == 0) {
+            continue;
+        }
+
+        if (!waitForSlot()) {
+            _unscheduled++;
+        }
+        for (int i = 0; i < packets && _mode == UPLINK_NODE; i++) {
+            if (esp_now_send(_peer, _packets[i], _packetLen[i]) == ESP_OK) {
+                _sent++;
+            } else {
+                _failed++;
+            }
+        }
+    }
+}
+
+// Starts the next packet of the batch
+void Uplink::openPacket(batch_t* b) {
+    b->hdr = (uplink_header_t*)_packets[b->packets];
+    b->hdr->magic = UPLINK_MAGIC;
+    b->hdr->version = UPLINK_VERSION;
+    b->hdr->seq = _seq++;
+    b->hdr->timestamp = b->now;
+    b->hdr->flags = b->refresh ? UPLINK_FLAG_REFRESH : 0;
+    b->hdr->count = 0;
+    b->len = sizeof(uplink_header_t);
+}
+
+// Writes the fields byte and MAC of an entry, moving to the next packet when
+// it doesn't fit. The caller appends the field values at b->len. False when
+// the batch is full; whatever is left over stays unsent in the shadow and
+// goes out with the next batch.
+bool Uplink::beginEntry(batch_t* b, uint8_t fields, const uint8_t* mac) {
+    if (b->hdr == nullptr || b->len + UPLINK_ENTRY_MAX > UPLINK_PACKET_MAX) {
+        if (b->hdr != nullptr) {
+            _packetLen[b->packets++] = (uint8_t)b->len;
+            b->hdr = nullptr;
+        }
+        if (b->packets == UPLINK_BATCH_PACKETS) {
+            _deferred++;
+            return false;
+        }
+        openPacket(b);
+    }
+
+    uint8_t* p = _packets[b->packets];
+    p[b->len++] = fields;
+    memcpy(&p[b->len], mac, 6);
+    b->len += 6;
+    b->hdr->count++;
+    return true;
+}
+
+// Encodes the changes since the last batch into _packets under the table
+// lock. Returns the number of packets; a refresh always sends one, even
+// if empty, so the collector hears from the node.
+int Uplink::buildBatch(uint32_t now, bool refresh) {
+    batch_t b = { now, refresh, 0, 0, nullptr };
+    bool full = false;
+
+    DeviceTableLock lock;
+
+    // Addresses the collector still holds for a slot that was reused for
+    // another device (eviction) or rekeyed, or past the end of a cleared
+    // table. These all go first: a device can move to a lower slot, and
+    // its entry there must not be followed by a GONE from its old slot.
+    for (int i = 0; i < DETECTED_DEVICES_MAX; i++) {
+        shadow_t* sh = &_shadow[i];
+        if (!sh->valid) {
+            continue;
+        }
+        if (i < deviceTable.count() && memcmp(sh->mac, deviceTable.at(i)->mac, 6) == 0) {
+            continue;
+        }
+        if (!beginEntry(&b, UPLINK_FIELD_GONE, sh->mac)) {
+            full = true;
+            break;
+        }
+        sh->valid = false;
+    }
+
+    for (int i = 0; i < deviceTable.count() && !full; i++) {
+        const DetectedDevice* dev = deviceTable.at(i);
+        shadow_t* sh = &_shadow[i];
+        bool same = sh->valid;          // Stale shadows were reported gone above
+
+        uint8_t fields = 0;
+        if (!dev->isActive()) {
+            if (same) {
+                fields = UPLINK_FIELD_GONE;
+            }
+        } else if (!same || refresh) {
+            fields = UPLINK_FIELD_SIG | UPLINK_FIELD_RSSI | UPLINK_FIELD_SEEN;
+        } else {
+            if (dev->sigIndex != sh->sigIndex) {
+                fields |= UPLINK_FIELD_SIG;
+            }
+            if (abs(dev->rssi - sh->rssi) >= UPLINK_RSSI_DELTA) {
+                fields |= UPLINK_FIELD_RSSI;
+            }
+            if (dev->lastSeen != sh->lastSeen) {
+                fields |= UPLINK_FIELD_SEEN;
+            }
+        }
+        if (fields == 0) {
+            continue;
+        }
+        if (!beginEntry(&b, fields, dev->mac)) {
+            break;
+        }
+
+        uint8_t* p = _packets[b.packets];
+        if (fields & UPLINK_FIELD_SIG) {
+            uint16_t sigId = dev->sigIndex >= 0 ? dev->sigIndex : BIN_SIG_NONE;
+            p[b.len++] = sigId & 0xFF;
+            p[b.len++] = sigId >> 8;
+            p[b.len++] = dev->category;
+            p[b.len++] = deviceSignature(dev)->threat_level;
+        }
+        if (fields & UPLINK_FIELD_RSSI) {
+            p[b.len++] = (uint8_t)dev->rssi;
+        }
+        if (fields & UPLINK_FIELD_SEEN) {
+            uint32_t age = (now - dev->lastSeen) / UPLINK_AGE_UNIT_MS;
+            uint16_t units = age > 0xFFFF ? 0xFFFF : (uint16_t)age;
+            p[b.len++] = units & 0xFF;
+            p[b.len++] = units >> 8;
+        }
+
+        memcpy(sh->mac, dev->mac, 6);
+        sh->valid = dev->isActive();
+        if (fields & UPLINK_FIELD_SIG) sh->sigIndex = dev->sigIndex;
+        if (fields & UPLINK_FIELD_RSSI) sh->rssi = dev->rssi;
+        if (fields & UPLINK_FIELD_SEEN) sh->lastSeen = dev->lastSeen;
+    }
+
+    if (b.hdr == nullptr && refresh && b.packets == 0) {
+        openPacket(&b);
+    }
+    if (b.hdr != nullptr) {
+        _packetLen[b.packets++] = (uint8_t)b.len;
+    }
+    return b.packets;
+}
+
+// Asks the scan scheduler to narrow the scan window and waits until it has;
+// false if the slot didn't come in time (the batch is sent anyway)
+bool Uplink::waitForSlot() {
+    if (!bleScanner.isRunning()) {
+        return true;                    // Radio is free
+    }
+    uint32_t start = millis();
+    scanScheduler.requestUplinkSlot(start);
+    while (millis() - start < UPLINK_SLOT_MS) {
+        if (scanScheduler.isUplinkSlotReady(millis())) {
+            return true;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return false;
+}
+
+// =============================================================================
+// COLLECTOR: RECEPTION
+// =============================================================================
+// Runs on the Wi-Fi task: check the header and queue the packet
+void Uplink::handleReceive(const uint8_t* mac, const uint8_t* data, int len) {
+    if (_mode != UPLINK_COLLECTOR || _rxQueue == nullptr) {
+        return;
+    }
+    const uplink_header_t* hdr = (const uplink_header_t*)data;
+    if (len < (int)sizeof(uplink_header_t) || len > UPLINK_PACKET_MAX ||
+        hdr->magic != UPLINK_MAGIC || hdr->version != UPLINK_VERSION) {
+        return;
+    }
+
+    static uplink_packet_t pkt;         // Only the Wi-Fi task gets here
+    memcpy(pkt.node, mac, 6);
+    pkt.received = millis();
+    pkt.lost = 0;
+    pkt.len = (uint8_t)len;
+    memcpy(pkt.data, data, len);
+    if (xQueueSend(_rxQueue, &pkt, 0) != pdTRUE) {
+        _rxDropped++;
+        return;
+    }
+    TaskHandle_t consumer = _consumer;
+    if (consumer != nullptr) {
+        xTaskNotifyGive(consumer);
+    }
+}
+
+// Unicast only reports failure after the retries; broadcasts always succeed
+void Uplink::handleSent(bool ok) {
+    if (!ok) {
+        _failed++;
+    }
+}
+
+bool Uplink::receive(uplink_packet_t* out) {
+    if (_rxQueue == nullptr || xQueueReceive(_rxQueue, out, 0) != pdTRUE) {
+        return false;
+    }
+    const uplink_header_t* hdr = (const uplink_header_t*)out->data;
+    trackNode(out->node, hdr->seq, out->received, &out->lost);
+    _received++;
+    return true;
+}
+
+// Counts the sequence gap per node. A jump backwards is a node restart and
+// isn't counted as loss.
+uplink_node_t* Uplink::trackNode(const uint8_t* mac, uint16_t seq, uint32_t now, uint32_t* lost) {
+    *lost = 0;
+    uplink_node_t* node = nullptr;
+    for (int i = 0; i < _nodeCount; i++) {
+        if (memcmp(_nodes[i].mac, mac, 6) == 0) {
+            node = &_nodes[i];
+            break;
+        }
+    }
+    if (node == nullptr) {
+        if (_nodeCount == UPLINK_MAX_NODES) {
+            // Forget the node heard from least recently
+            int oldest = 0;
+            for (int i = 1; i < _nodeCount; i++) {
+                if (now - _nodes[i].lastHeard > now - _nodes[oldest].lastHeard) {
+                    oldest = i;
+                }
+            }
+            node = &_nodes[oldest];
+        } else {
+            node = &_nodes[_nodeCount++];
+        }
+        memset(node, 0, sizeof(*node));
+        memcpy(node->mac, mac, 6);
+    } else {
+        uint16_t gap = (uint16_t)(seq - node->lastSeq - 1);
+        if (gap < 0x8000) {
+            *lost = gap;
+            node->lost += gap;
+        }
+    }
+    node->lastSeq = seq;
+    node->lastHeard = now;
+    node->packets++;
+    return node;
+}
+
+uint32_t Uplink::getLostCount() {
+    uint32_t lost = 0;
+    for (int i = 0; i < _nodeCount; i++) {
+        lost += _nodes[i].lost;
+    }
+    return lost;
+}
@@ -0,0 +1,207 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Uplink - ESP-NOW aggregation of several sensors on one collector
+ *
+ * A node sends what changed in its device table every UPLINK_INTERVAL_MS
+ * as a batch of ESP-NOW packets: per device only the fields that changed
+ * since the last batch (new signature, RSSI moved by UPLINK_RSSI_DELTA,
+ * newer sighting, gone). Every UPLINK_REFRESH_BATCHES batches a refresh
+ * resends everything, so a lost packet only leaves a value stale until
+ * then. Packets carry a per-node sequence number; the collector counts the
+ * gaps and hands each packet to the serial task, which prints one record
+ * per device.
+ *
+ * The radio is shared with BLE scanning. A node asks the scan scheduler for
+ * an uplink slot before each batch and sends once the narrowed scan window
+ * is in place; a collector keeps the narrowed window while it listens.
+ */
+
+#ifndef UPLINK_H
+#define UPLINK_H
+
+#include <Arduino.h>
+#include "../config.h"
+
+// =============================================================================
+// WIRE FORMAT
+// =============================================================================
+#define UPLINK_MAGIC            0xB7
+#define UPLINK_VERSION          1
+#define UPLINK_PACKET_MAX       250     // ESP_NOW_MAX_DATA_LEN
+
+#define UPLINK_FLAG_REFRESH     0x01    // Batch resends every active device
+
+// Entry fields; an entry is its header followed by the fields it has, in
+// this order
+#define UPLINK_FIELD_SIG        0x01    // sigId:u16 category:u8 threatLevel:u8
+#define UPLINK_FIELD_RSSI       0x02    // rssi:i8 (filtered)
+#define UPLINK_FIELD_SEEN       0x04    // age:u16, 100 ms units before the batch time
+#define UPLINK_FIELD_GONE       0x08    // Became inactive; no other fields
+
+typedef struct __attribute__((packed)) {
+    uint8_t magic;
+    uint8_t version;
+    uint16_t seq;                       // Per node, +1 per packet
+    uint32_t timestamp;                 // Node millis() when the batch was taken
+    uint8_t flags;                      // UPLINK_FLAG_*
+    uint8_t count;                      // Entries that follow
+} uplink_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t fields;                     // UPLINK_FIELD_*
+    uint8_t mac[6];
+} uplink_entry_header_t;
+
+#define UPLINK_ENTRY_MAX        (sizeof(uplink_entry_header_t) + 4 + 1 + 2)
+
+static_assert(sizeof(uplink_header_t) + UPLINK_ENTRY_MAX <= UPLINK_PACKET_MAX,
+              "Uplink packet too small");
+
+// One decoded entry
+typedef struct {
+    uint8_t fields;
+    uint8_t mac[6];
+    uint16_t sigId;                     // BIN_SIG_NONE without UPLINK_FIELD_SIG
+    uint8_t category;
+    uint8_t threatLevel;
+    int8_t rssi;
+    uint32_t ageMs;
+} uplink_entry_t;
+
+// Decodes the entry at *pos and advances it; false at the end or on a
+// truncated entry
+bool uplinkNextEntry(const uint8_t* data, size_t len, size_t* pos, uplink_entry_t* out);
+
+// =============================================================================
+// RECEIVED PACKETS (collector)
+// =============================================================================
+typedef struct {
+    uint8_t node[6];                    // Sender MAC
+    uint32_t received;                  // Collector millis()
+    uint32_t lost;                      // Packets missing before this one
+    uint8_t len;
+    uint8_t data[UPLINK_PACKET_MAX];    // Header, then entries
+} uplink_packet_t;
+
+typedef struct {
+    uint8_t mac[6];
+    uint16_t lastSeq;
+    uint32_t packets;
+    uint32_t lost;
+    uint32_t lastHeard;                 // millis()
+} uplink_node_t;
+
+// =============================================================================
+// UPLINK CLASS
+// =============================================================================
+typedef enum {
+    UPLINK_OFF = 0,
+    UPLINK_NODE,
+    UPLINK_COLLECTOR
+} uplink_mode_t;
+
+class Uplink {
+public:
+    Uplink();
+
+    // Starts the node task and applies the configured mode. Settings made
+    // before init() (from /config.txt) only take effect here.
+    bool init();
+
+    // Task notified for each received packet (the serial task)
+    void setConsumer(TaskHandle_t task) { _consumer = task; }
+
+    // Settings; a mode change restarts Wi-Fi
+    bool setMode(uplink_mode_t mode);
+    bool setChannel(uint8_t channel);
+    void setPeer(const uint8_t* mac);   // nullptr = broadcast
+    void setInterval(uint32_t ms) { _intervalMs = ms; }
+
+    // Consumer (serial task); never blocks
+    bool receive(uplink_packet_t* out);
+
+    // ESP-NOW callbacks (Wi-Fi task)
+    void handleReceive(const uint8_t* mac, const uint8_t* data, int len);
+    void handleSent(bool ok);
+
+    // Status
+    uplink_mode_t getMode() { return _mode; }
+    void getAddress(uint8_t* mac);      // What nodes put in UPLINK NODE <mac>
+    const char* getModeString();
+    const char* getError() { return _error; }
+    uint8_t getChannel() { return _channel; }
+    const uint8_t* getPeer() { return _peer; }
+    bool isBroadcast();
+    uint32_t getIntervalMs() { return _intervalMs; }
+    uint32_t getBatchCount() { return _batches; }
+    uint32_t getSentCount() { return _sent; }
+    uint32_t getFailedCount() { return _failed; }
+    uint32_t getDeferredCount() { return _deferred; }
+    uint32_t getUnscheduledCount() { return _unscheduled; }
+    uint32_t getReceivedCount() { return _received; }
+    uint32_t getRxDroppedCount() { return _rxDropped; }
+    uint32_t getLostCount();
+    int getNodeCount() { return _nodeCount; }
+    const uplink_node_t* getNode(int i) { return &_nodes[i]; }
+
+private:
+    // Last values sent per device table slot
+    typedef struct {
+        uint8_t mac[6];
+        bool valid;                     // Slot was sent and not reported gone
+        int8_t rssi;
+        int16_t sigIndex;
+        uint32_t lastSeen;
+    } shadow_t;
+
+    // Batch being encoded into _packets
+    typedef struct {
+        uint32_t now;
+        bool refresh;
+        int packets;                    // Packets completed
+        size_t len;                     // Bytes used in the open packet
+        uplink_header_t* hdr;           // Open packet, nullptr if none
+    } batch_t;
+
+    uplink_mode_t _mode;
+    uint8_t _channel;
+    uint8_t _peer[6];
+    uint32_t _intervalMs;
+    bool _wifiUp;
+    const char* _error;                 // Why the last mode change failed
+
+    TaskHandle_t _task;
+    volatile TaskHandle_t _consumer;
+    QueueHandle_t _rxQueue;
+
+    shadow_t _shadow[DETECTED_DEVICES_MAX];
+    uint8_t _packets[UPLINK_BATCH_PACKETS][UPLINK_PACKET_MAX];
+    uint8_t _packetLen[UPLINK_BATCH_PACKETS];
+    uint16_t _seq;
+    uint32_t _batches;
+    uint32_t _sent;
+    volatile uint32_t _failed;          // Counted by the send callback
+    uint32_t _deferred;                 // Changes left for the next batch
+    uint32_t _unscheduled;              // Sent without an uplink slot
+
+    uplink_node_t _nodes[UPLINK_MAX_NODES];
+    int _nodeCount;
+    uint32_t _received;
+    uint32_t _rxDropped;
+
+    static void taskEntry(void* param);
+    void run();
+    int buildBatch(uint32_t now, bool refresh);
+    void openPacket(batch_t* b);
+    bool beginEntry(batch_t* b, uint8_t fields, const uint8_t* mac);
+    bool waitForSlot();
+    bool startWifi();
+    void stopWifi();
+    bool addPeer();
+    uplink_node_t* trackNode(const uint8_t* mac, uint16_t seq, uint32_t now, uint32_t* lost);
+};
+
+// Global uplink instance
+extern Uplink uplink;
+
+#endif // UPLINK_H
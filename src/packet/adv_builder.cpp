@@ -0,0 +1,74 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Advertising Payload Builder Implementation
+ */
+
+#include "adv_builder.h"
+#include <string.h>
+
+bool advBuildPayload(const device_signature_t* sig, tx_payload_t* payload) {
+    memset(payload, 0, sizeof(*payload));
+    uint8_t* advData = payload->data;
+    uint8_t pos = 0;
+
+    // Flags (required for discoverable devices)
+    advData[pos++] = 0x02;  // Length
+    advData[pos++] = 0x01;  // Type: Flags
+    advData[pos++] = 0x06;  // LE General Discoverable, BR/EDR Not Supported
+
+    // Manufacturer Specific Data
+    if (sig->company_id != 0) {
+        uint8_t mfgDataLen = 2;  // Company ID
+
+        // Add payload pattern if present
+        if (sig->pattern_length > 0 && sig->pattern_offset == 0) {
+            // Pattern includes company ID at start, use as-is
+            mfgDataLen = sig->pattern_length;
+            advData[pos++] = mfgDataLen + 1;  // Length (data + type)
+            advData[pos++] = 0xFF;  // Type: Manufacturer Specific Data
+            memcpy(&advData[pos], sig->payload_pattern, sig->pattern_length);
+            pos += sig->pattern_length;
+        } else {
+            // Build manufacturer data with company ID + optional extra bytes
+            uint8_t extraBytes = 4;  // Add some random payload data
+            mfgDataLen = 2 + extraBytes;
+
+            advData[pos++] = mfgDataLen + 1;  // Length
+            advData[pos++] = 0xFF;  // Type: Manufacturer Specific Data
+            // Company ID (little-endian)
+            advData[pos++] = sig->company_id & 0xFF;
+            advData[pos++] = (sig->company_id >> 8) & 0xFF;
+
+            // Add pattern if exists and not at offset 0
+            uint8_t fixedBytes = 0;
+            if (sig->pattern_length > 0 && sig->pattern_length <= extraBytes) {
+                memcpy(&advData[pos], sig->payload_pattern, sig->pattern_length);
+                fixedBytes = sig->pattern_length;
+            }
+            // Remaining bytes are random (advRandomizePayload)
+            payload->randOffset = pos + fixedBytes;
+            payload->randLen = extraBytes - fixedBytes;
+            pos += extraBytes;
+        }
+    }
+
+    // Service UUID if specified
+    if (sig->service_uuid != 0) {
+        advData[pos++] = 0x03;  // Length
+        advData[pos++] = 0x03;  // Type: Complete List of 16-bit Service UUIDs
+        advData[pos++] = sig->service_uuid & 0xFF;
+        advData[pos++] = (sig->service_uuid >> 8) & 0xFF;
+    }
+
+    payload->len = pos;
+    return pos > 0;
+}
+
+void advRandomizePayload(tx_payload_t* payload, uint32_t* state) {
+    uint8_t* p = &payload->data[payload->randOffset];
+    for (uint8_t i = 0; i < payload->randLen; i += 4) {
+        uint32_t r = advXorshift32(state);
+        uint8_t n = payload->randLen - i < 4 ? payload->randLen - i : 4;
+        memcpy(p + i, &r, n);
+    }
+}
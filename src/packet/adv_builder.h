@@ -0,0 +1,46 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Advertising Payload Builder
+ *
+ * Builds the raw advertising data that imitates a signature. The template
+ * is built once; only its filler bytes change per packet. Plain bytes only,
+ * so it also builds on the host (see the native env and bench/).
+ */
+
+#ifndef ADV_BUILDER_H
+#define ADV_BUILDER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../detection/signatures.h"
+
+// =============================================================================
+// CACHED ADVERTISING PAYLOAD
+// =============================================================================
+// Per packet only the filler bytes in [randOffset, randOffset + randLen)
+// are re-randomized
+typedef struct {
+    uint8_t data[31];                   // Raw advertising data
+    uint8_t len;
+    uint8_t randOffset;                 // First mutable byte
+    uint8_t randLen;                    // Mutable bytes (0 = fully static)
+} tx_payload_t;
+
+// Build the payload template for sig; filler bytes are left zeroed.
+// Returns false if the signature yields no data.
+bool advBuildPayload(const device_signature_t* sig, tx_payload_t* payload);
+
+// xorshift32; state must be non-zero
+inline uint32_t advXorshift32(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Refill the filler bytes from the generator
+void advRandomizePayload(tx_payload_t* payload, uint32_t* state);
+
+#endif // ADV_BUILDER_H
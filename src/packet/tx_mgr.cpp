@@ -4,10 +4,12 @@
  */
 
 #include "tx_mgr.h"
-#include <BLEDevice.h>
-#include <BLEAdvertising.h>
+#include "../detection/sig_db.h"
+#include "../ble/ble_hal.h"
+#include "../ble/scanner.h"
+#include "../util/perf_stats.h"
 #include <esp_bt.h>
-#include <esp_gap_ble_api.h>
+#include <esp_timer.h>
 
 // Global instance
 TXManager txManager;
@@ -20,16 +22,179 @@ TXManager::TXManager() {
     memset(_confusionEntries, 0, sizeof(_confusionEntries));
     _confusionActive = false;
     _totalPacketsSent = 0;
+    _sessionGeneration = 0;
     _confusionIndex = 0;
+    _confusionStartTime = 0;
+    _confusionNextDue = 0;
+    memset(&_confusionTiming, 0, sizeof(_confusionTiming));
+    _confusionPacketsSent = 0;
+    _failedCount = 0;
+    _confusionGeneration = 0;
+    _confusionSetGeneration = 0;
+    _confusionSetsActive = false;
+    _confusionSetCount = 0;
+    _confusionInstances = 0;
+    _sessionSetReady = false;
+    _staticPayload = false;
+    _uploadedSource = TX_SOURCE_NONE;
+    _payloadGeneration = 0;
+    _uploadsSkipped = 0;
+    memset(_addr, 0, sizeof(_addr));
+    _addrValid = false;
+    _addrChanges = 0;
+    _addrSkipped = 0;
+    _prngState = 0;
+    _task = nullptr;
+    _lock = nullptr;
+    _gapEvents = nullptr;
+    _deadlineTimer = nullptr;
+    _observer = nullptr;
 }
 
 // =============================================================================
 // INITIALIZATION
 // =============================================================================
 void TXManager::init() {
-    // BLE is already initialized by the Arduino BLE library
-    // Don't register our own GAP callback as it would override the library's
-    Serial.println("[TX] TX Manager initialized");
+    // BLE is already initialized by the Arduino BLE library; GAP events
+    // reach us through the BLE HAL so the library's handler stays in place
+    // Seed once; esp_random() is slow and only needed for entropy
+    do {
+        _prngState = esp_random();
+    } while (_prngState == 0);
+
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = onDeadline;
+    timerArgs.arg = this;
+    timerArgs.dispatch_method = ESP_TIMER_TASK;
+    timerArgs.name = "ble_tx_due";
+
+    _lock = xSemaphoreCreateMutex();
+    _gapEvents = xQueueCreate(8, sizeof(tx_gap_event_t));
+    if (_lock == nullptr || _gapEvents == nullptr ||
+        esp_timer_create(&timerArgs, &_deadlineTimer) != ESP_OK ||
+        !bleHalAddGapListener(onGapEvent)) {
+        Serial.println("[TX] Failed to initialize TX Manager");
+        return;
+    }
+
+    BaseType_t rc = xTaskCreatePinnedToCore(taskEntry, "ble_tx",
+                                            TASK_BLE_TX_STACK, this,
+                                            TASK_BLE_TX_PRIORITY, &_task,
+                                            TASK_BLE_TX_CORE);
+    if (rc != pdPASS) {
+        _task = nullptr;
+        Serial.println("[TX] Failed to create TX task");
+        return;
+    }
+    Serial.printf("[TX] TX Manager initialized (task on core %d, %s advertising)\n",
+                  TASK_BLE_TX_CORE, TX_EXT_ADV ? "extended" : "legacy");
+}
+
+void TXManager::lock() {
+    if (_lock != nullptr) {
+        xSemaphoreTake(_lock, portMAX_DELAY);
+    }
+}
+
+void TXManager::unlock() {
+    if (_lock != nullptr) {
+        xSemaphoreGive(_lock);
+    }
+}
+
+// Every state change wakes the TX task, so observers are told from here too
+void TXManager::wakeTask() {
+    if (_task != nullptr) {
+        xTaskNotifyGive(_task);
+    }
+    notifyObserver();
+}
+
+// One-shot armed for the next deadline; runs in the esp_timer task
+void TXManager::onDeadline(void* arg) {
+    TXManager* self = (TXManager*)arg;
+    if (self->_task != nullptr) {
+        xTaskNotifyGive(self->_task);
+    }
+}
+
+void TXManager::notifyObserver() {
+    tx_observer_t observer = _observer;
+    if (observer != nullptr) {
+        observer();
+    }
+}
+
+// =============================================================================
+// TIMING STATISTICS
+// =============================================================================
+static void timingReset(tx_timing_t* timing, uint32_t intervalMs) {
+    memset(timing, 0, sizeof(*timing));
+    timing->intervalMs = intervalMs;
+}
+
+// A packet for deadline due went on air at onAir. The interval to the
+// previous packet is only measured if that one was for the previous
+// deadline (contiguous), otherwise it spans several intervals.
+static void timingRecord(tx_timing_t* timing, int64_t due, int64_t onAir, bool contiguous) {
+    int64_t late = onAir - due;
+    if (late > 0) {
+        uint32_t lateUs = late < UINT32_MAX ? (uint32_t)late : UINT32_MAX;
+        timing->latenessSumUs += lateUs;
+        if (lateUs > timing->latenessMaxUs) {
+            timing->latenessMaxUs = lateUs;
+        }
+    }
+    timing->packets++;
+
+    if (contiguous && timing->lastOnAir != 0) {
+        int64_t err64 = onAir - timing->lastOnAir - (int64_t)timing->intervalMs * 1000;
+        int32_t err = err64 > INT32_MAX ? INT32_MAX : (err64 < INT32_MIN ? INT32_MIN : (int32_t)err64);
+        if (timing->samples == 0 || err < timing->minErrUs) timing->minErrUs = err;
+        if (timing->samples == 0 || err > timing->maxErrUs) timing->maxErrUs = err;
+
+        timing->samples++;
+        float delta = err - timing->meanErrUs;
+        timing->meanErrUs += delta / timing->samples;
+        timing->m2 += delta * (err - timing->meanErrUs);
+
+        int bin = 0;
+        while (bin < TX_TIMING_BINS - 1 && err >= txTimingEdgesUs[bin]) {
+            bin++;
+        }
+        timing->hist[bin]++;
+    }
+    timing->lastOnAir = onAir;
+}
+
+float txTimingJitterUs(const tx_timing_t* timing) {
+    return timing->samples > 1 ? sqrtf(timing->m2 / (timing->samples - 1)) : 0.0f;
+}
+
+bool TXManager::getSessionSnapshot(int index, tx_session_t* out) {
+    if (index < 0 || index >= TX_MAX_CONCURRENT) {
+        return false;
+    }
+    lock();
+    *out = _sessions[index];
+    unlock();
+    return out->active;
+}
+
+bool TXManager::getConfusionEntrySnapshot(int index, confusion_entry_t* out) {
+    lock();
+    confusion_entry_t* entry = getConfusionEntry(index);
+    if (entry != nullptr) {
+        *out = *entry;
+    }
+    unlock();
+    return entry != nullptr;
+}
+
+void TXManager::getConfusionTiming(tx_timing_t* out) {
+    lock();
+    *out = _confusionTiming;
+    unlock();
 }
 
 // =============================================================================
@@ -37,8 +202,8 @@ void TXManager::init() {
 // =============================================================================
 int TXManager::getTransmittableCount() {
     int count = 0;
-    for (size_t i = 0; i < BUILTIN_SIGNATURE_COUNT; i++) {
-        if (BUILTIN_SIGNATURES[i].flags & SIG_FLAG_TRANSMITTABLE) {
+    for (int i = 0; i < sigDb.count(); i++) {
+        if (sigDb.get(i)->flags & SIG_FLAG_TRANSMITTABLE) {
             count++;
         }
     }
@@ -47,10 +212,11 @@ int TXManager::getTransmittableCount() {
 
 const device_signature_t* TXManager::getTransmittableSignature(int index) {
     int count = 0;
-    for (size_t i = 0; i < BUILTIN_SIGNATURE_COUNT; i++) {
-        if (BUILTIN_SIGNATURES[i].flags & SIG_FLAG_TRANSMITTABLE) {
+    for (int i = 0; i < sigDb.count(); i++) {
+        const device_signature_t* sig = sigDb.get(i);
+        if (sig->flags & SIG_FLAG_TRANSMITTABLE) {
             if (count == index) {
-                return &BUILTIN_SIGNATURES[i];
+                return sig;
             }
             count++;
         }
@@ -59,18 +225,20 @@ const device_signature_t* TXManager::getTransmittableSignature(int index) {
 }
 
 const device_signature_t* TXManager::findSignatureByName(const char* name) {
-    for (size_t i = 0; i < BUILTIN_SIGNATURE_COUNT; i++) {
-        if (strcasecmp(BUILTIN_SIGNATURES[i].name, name) == 0) {
-            if (BUILTIN_SIGNATURES[i].flags & SIG_FLAG_TRANSMITTABLE) {
-                return &BUILTIN_SIGNATURES[i];
+    for (int i = 0; i < sigDb.count(); i++) {
+        const device_signature_t* sig = sigDb.get(i);
+        if (strcasecmp(sig->name, name) == 0) {
+            if (sig->flags & SIG_FLAG_TRANSMITTABLE) {
+                return sig;
             }
         }
     }
     // Also try partial match
-    for (size_t i = 0; i < BUILTIN_SIGNATURE_COUNT; i++) {
-        if (strcasestr(BUILTIN_SIGNATURES[i].name, name) != nullptr) {
-            if (BUILTIN_SIGNATURES[i].flags & SIG_FLAG_TRANSMITTABLE) {
-                return &BUILTIN_SIGNATURES[i];
+    for (int i = 0; i < sigDb.count(); i++) {
+        const device_signature_t* sig = sigDb.get(i);
+        if (strcasestr(sig->name, name) != nullptr) {
+            if (sig->flags & SIG_FLAG_TRANSMITTABLE) {
+                return sig;
             }
         }
     }
@@ -132,9 +300,12 @@ int TXManager::startTx(const char* deviceName, uint32_t intervalMs, int32_t coun
         return -2;  // Already active
     }
 
+    lock();
+
     // Find free session slot
     int slot = findFreeSession();
     if (slot < 0) {
+        unlock();
         return -3;  // No free slots
     }
 
@@ -145,12 +316,19 @@ int TXManager::startTx(const char* deviceName, uint32_t intervalMs, int32_t coun
     session->intervalMs = intervalMs;
     session->remainingCount = count;
     session->packetsSent = 0;
-    session->lastTxTime = 0;
+    session->nextDue = esp_timer_get_time();   // First packet right away
+    timingReset(&session->timing, intervalMs);
+    session->startTime = millis();
+    session->generation = ++_sessionGeneration;
     session->randomMacPerPacket = randomMac;
-    session->active = true;
 
-    // Generate initial MAC
+    // Generate initial MAC and payload
     generateRandomMac(session->currentMac);
+    buildAdvertisingData(sig, &session->payload);
+    session->active = true;
+
+    unlock();
+    wakeTask();
 
     Serial.printf("[TX] Started TX for %s (slot %d, interval %lums, count %ld)\n",
                   sig->name, slot, intervalMs, count);
@@ -165,15 +343,22 @@ int TXManager::stopTx(const char* deviceName) {
     if (session == nullptr) {
         return -1;
     }
+    lock();
     session->active = false;
+    unlock();
+    notifyObserver();
     return 0;
 }
 
 void TXManager::stopAll() {
+    lock();
     for (int i = 0; i < TX_MAX_CONCURRENT; i++) {
         _sessions[i].active = false;
     }
     _confusionActive = false;
+    _confusionGeneration++;
+    unlock();
+    wakeTask();
 }
 
 // =============================================================================
@@ -208,12 +393,18 @@ int TXManager::confuseAdd(const char* deviceName, uint8_t instanceCount) {
         return -1;  // Device not found
     }
 
+    lock();
+
     // Check if already in confusion list
     for (int i = 0; i < TX_CONFUSION_MAX_DEVICES; i++) {
         if (_confusionEntries[i].enabled &&
             strcasecmp(_confusionEntries[i].deviceName, sig->name) == 0) {
             // Update instance count
             _confusionEntries[i].instanceCount = instanceCount;
+            buildAdvertisingData(sig, &_confusionEntries[i].payload);
+            _confusionGeneration++;
+            unlock();
+            wakeTask();
             return i;
         }
     }
@@ -225,30 +416,45 @@ int TXManager::confuseAdd(const char* deviceName, uint8_t instanceCount) {
                     sizeof(_confusionEntries[i].deviceName) - 1);
             _confusionEntries[i].sig = sig;
             _confusionEntries[i].instanceCount = instanceCount;
+            buildAdvertisingData(sig, &_confusionEntries[i].payload);
             _confusionEntries[i].enabled = true;
+            _confusionGeneration++;
+            unlock();
+            wakeTask();
             return i;
         }
     }
 
+    unlock();
     return -2;  // No free slots
 }
 
 int TXManager::confuseRemove(const char* deviceName) {
+    int rc = -1;
+    lock();
     for (int i = 0; i < TX_CONFUSION_MAX_DEVICES; i++) {
         if (_confusionEntries[i].enabled &&
             strcasecmp(_confusionEntries[i].deviceName, deviceName) == 0) {
             _confusionEntries[i].enabled = false;
-            return 0;
+            _confusionGeneration++;
+            rc = 0;
+            break;
         }
     }
-    return -1;
+    unlock();
+    wakeTask();
+    return rc;
 }
 
 void TXManager::confuseClear() {
+    lock();
     for (int i = 0; i < TX_CONFUSION_MAX_DEVICES; i++) {
         _confusionEntries[i].enabled = false;
     }
     _confusionActive = false;
+    _confusionGeneration++;
+    unlock();
+    wakeTask();
 }
 
 int TXManager::confuseStart() {
@@ -256,23 +462,46 @@ int TXManager::confuseStart() {
     if (entryCount == 0) {
         return -1;  // No entries configured
     }
-    _confusionActive = true;
+    lock();
     _confusionIndex = 0;
+    _confusionStartTime = millis();
+    _confusionNextDue = esp_timer_get_time();
+    timingReset(&_confusionTiming, TX_CONFUSION_INTERVAL_MS);
+    _confusionPacketsSent = 0;
+    _confusionActive = true;
+    _confusionGeneration++;
+    unlock();
+    wakeTask();
     return entryCount;
 }
 
 void TXManager::confuseStop() {
+    lock();
     _confusionActive = false;
+    _confusionGeneration++;
+    unlock();
+    wakeTask();
+}
+
+void TXManager::setStaticPayload(bool enabled) {
+    lock();
+    _staticPayload = enabled;
+    unlock();
 }
 
 // =============================================================================
 // MAC ADDRESS GENERATION
 // =============================================================================
+uint32_t TXManager::nextRandom() {
+    return advXorshift32(&_prngState);
+}
+
 void TXManager::generateRandomMac(uint8_t* mac) {
     // Generate random MAC with locally administered bit set
-    for (int i = 0; i < 6; i++) {
-        mac[i] = esp_random() & 0xFF;
-    }
+    uint32_t r0 = nextRandom();
+    uint32_t r1 = nextRandom();
+    memcpy(mac, &r0, 4);
+    memcpy(mac + 4, &r1, 2);
     // Set locally administered bit (bit 1 of first byte)
     mac[0] |= 0x02;
     // Clear multicast bit (bit 0 of first byte)
@@ -282,94 +511,323 @@ void TXManager::generateRandomMac(uint8_t* mac) {
 // =============================================================================
 // ADVERTISING DATA CONSTRUCTION
 // =============================================================================
-bool TXManager::buildAdvertisingData(const device_signature_t* sig, uint8_t* advData, uint8_t* advLen) {
-    uint8_t pos = 0;
-
-    // Flags (required for discoverable devices)
-    advData[pos++] = 0x02;  // Length
-    advData[pos++] = 0x01;  // Type: Flags
-    advData[pos++] = 0x06;  // LE General Discoverable, BR/EDR Not Supported
-
-    // Manufacturer Specific Data
-    if (sig->company_id != 0) {
-        uint8_t mfgDataLen = 2;  // Company ID
-
-        // Add payload pattern if present
-        if (sig->pattern_length > 0 && sig->pattern_offset == 0) {
-            // Pattern includes company ID at start, use as-is
-            mfgDataLen = sig->pattern_length;
-            advData[pos++] = mfgDataLen + 1;  // Length (data + type)
-            advData[pos++] = 0xFF;  // Type: Manufacturer Specific Data
-            memcpy(&advData[pos], sig->payload_pattern, sig->pattern_length);
-            pos += sig->pattern_length;
+// Call with the lock held. A rebuilt slot holds a new payload under the
+// same source index, so the controller's copy no longer counts as current.
+bool TXManager::buildAdvertisingData(const device_signature_t* sig, tx_payload_t* payload) {
+    _uploadedSource = TX_SOURCE_NONE;
+    _payloadGeneration++;
+    bool ok = advBuildPayload(sig, payload);
+    advRandomizePayload(payload, &_prngState);
+    return ok;
+}
+
+// Copy the cached payload into the job, re-randomizing the filler bytes
+// unless the payload is static. Skips the upload if the controller
+// already holds exactly this payload.
+bool TXManager::preparePayload(tx_payload_t* payload, int16_t source, tx_job_t* job) {
+    bool changes = payload->randLen > 0 && !_staticPayload;
+    if (changes) {
+        advRandomizePayload(payload, &_prngState);
+    }
+    job->source = source;
+    job->payloadGeneration = _payloadGeneration;
+    job->uploadData = changes || source != _uploadedSource;
+    memcpy(job->advData, payload->data, payload->len);
+    job->advLen = payload->len;
+    return payload->len > 0;
+}
+
+// =============================================================================
+// RATE STATISTICS
+// =============================================================================
+float TXManager::getRequestedRate(const tx_session_t* session) {
+    return session->intervalMs > 0 ? 1000.0f / session->intervalMs : 0.0f;
+}
+
+float TXManager::getAchievedRate(const tx_session_t* session) {
+    uint32_t elapsed = millis() - session->startTime;
+    return elapsed > 0 ? session->packetsSent * 1000.0f / elapsed : 0.0f;
+}
+
+float TXManager::getConfusionRequestedRate() {
+#if TX_EXT_ADV
+    return _confusionSetCount * 1000.0f / TX_EXT_CONFUSION_INTERVAL_MS;
+#else
+    return 1000.0f / TX_CONFUSION_INTERVAL_MS;
+#endif
+}
+
+float TXManager::getConfusionAchievedRate() {
+    lock();
+#if TX_EXT_ADV
+    // The controller schedules the sets itself; packets are not observable
+    float rate = _confusionSetsActive ? getConfusionRequestedRate() : 0.0f;
+#else
+    uint32_t elapsed = millis() - _confusionStartTime;
+    float rate = (_confusionActive && elapsed > 0) ?
+                 _confusionPacketsSent * 1000.0f / elapsed : 0.0f;
+#endif
+    unlock();
+    return rate;
+}
+
+// =============================================================================
+// TX TASK
+// =============================================================================
+void TXManager::taskEntry(void* param) {
+    static_cast<TXManager*>(param)->run();
+}
+
+// Runs in the Bluedroid host task: forward advertising completion events
+void TXManager::onGapEvent(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param) {
+    tx_gap_event_t evt;
+    evt.event = event;
+    switch (event) {
+        case ESP_GAP_BLE_SET_STATIC_RAND_ADDR_EVT:
+            evt.status = param->set_rand_addr_cmpl.status;
+            break;
+        case ESP_GAP_BLE_ADV_DATA_RAW_SET_COMPLETE_EVT:
+            evt.status = param->adv_data_raw_cmpl.status;
+            break;
+        case ESP_GAP_BLE_ADV_START_COMPLETE_EVT:
+            evt.status = param->adv_start_cmpl.status;
+            break;
+        case ESP_GAP_BLE_ADV_STOP_COMPLETE_EVT:
+            evt.status = param->adv_stop_cmpl.status;
+            break;
+#if TX_EXT_ADV
+        case ESP_GAP_BLE_EXT_ADV_SET_PARAMS_COMPLETE_EVT:
+            evt.status = param->ext_adv_set_params.status;
+            break;
+        case ESP_GAP_BLE_EXT_ADV_SET_RAND_ADDR_COMPLETE_EVT:
+            evt.status = param->ext_adv_set_rand_addr.status;
+            break;
+        case ESP_GAP_BLE_EXT_ADV_DATA_SET_COMPLETE_EVT:
+            evt.status = param->ext_adv_data_set.status;
+            break;
+        case ESP_GAP_BLE_EXT_ADV_START_COMPLETE_EVT:
+            evt.status = param->ext_adv_start.status;
+            break;
+        case ESP_GAP_BLE_EXT_ADV_STOP_COMPLETE_EVT:
+            evt.status = param->ext_adv_stop.status;
+            break;
+        case ESP_GAP_BLE_ADV_TERMINATED_EVT:
+            // Only the session set ends on its own ("limit reached" once
+            // max_events went out); either way it is idle again
+            if (param->adv_terminate.adv_instance != TX_EXT_SESSION_SET) {
+                return;
+            }
+            evt.status = ESP_BT_STATUS_SUCCESS;
+            break;
+#endif
+        default:
+            return;
+    }
+    if (txManager._gapEvents != nullptr) {
+        xQueueSend(txManager._gapEvents, &evt, 0);
+    }
+}
+
+void TXManager::run() {
+    for (;;) {
+        tx_job_t job;
+        int64_t waitUs = TX_IDLE_POLL_MS * 1000LL;
+
+#if TX_EXT_ADV
+        syncConfusionSets();
+#endif
+
+        lock();
+        bool haveJob = selectJob(esp_timer_get_time(), &job, &waitUs);
+        unlock();
+
+        if (!haveJob) {
+            // Sleep until the deadline timer fires or a session is started.
+            // Tick timeouts would round the deadline to a whole tick, and
+            // spinning here would starve the match task on this core.
+            esp_timer_stop(_deadlineTimer);
+            esp_timer_start_once(_deadlineTimer, (uint64_t)waitUs);
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        bool ok;
+        int64_t onAir = 0;
+        {
+            PERF_SCOPE(PERF_TX_PACKET);
+            ok = sendPacket(&job, &onAir);
+        }
+
+        lock();
+        if (ok) {
+            if (!job.uploadData) {
+                _uploadsSkipped++;
+            }
+            // A payload rebuilt while this one was on air leaves the
+            // controller's data stale for its source
+            _uploadedSource = job.payloadGeneration == _payloadGeneration ?
+                              job.source : TX_SOURCE_NONE;
+            completeJob(&job, onAir);
         } else {
-            // Build manufacturer data with company ID + optional extra bytes
-            uint8_t extraBytes = 4;  // Add some random payload data
-            mfgDataLen = 2 + extraBytes;
-
-            advData[pos++] = mfgDataLen + 1;  // Length
-            advData[pos++] = 0xFF;  // Type: Manufacturer Specific Data
-            // Company ID (little-endian)
-            advData[pos++] = sig->company_id & 0xFF;
-            advData[pos++] = (sig->company_id >> 8) & 0xFF;
-
-            // Add pattern if exists and not at offset 0
-            if (sig->pattern_length > 0 && sig->pattern_length <= extraBytes) {
-                memcpy(&advData[pos], sig->payload_pattern, sig->pattern_length);
-                pos += sig->pattern_length;
-                // Fill remaining with random
-                for (int i = sig->pattern_length; i < extraBytes; i++) {
-                    advData[pos++] = esp_random() & 0xFF;
-                }
-            } else {
-                // Random payload
-                for (int i = 0; i < extraBytes; i++) {
-                    advData[pos++] = esp_random() & 0xFF;
-                }
+            // The controller's data is unknown after a failed step
+            _uploadedSource = TX_SOURCE_NONE;
+            _failedCount++;
+            // The next packet's interval would span two deadlines
+            if (job.session == TX_JOB_CONFUSION) {
+                _confusionTiming.lastOnAir = 0;
+            } else if (_sessions[job.session].generation == job.sessionGeneration) {
+                _sessions[job.session].timing.lastOnAir = 0;
             }
         }
+        unlock();
     }
+}
+
+// Earliest deadline first over the active sessions and the confusion
+// stream. The job is built once its deadline has come; until then *waitUs
+// is how long the task may sleep.
+bool TXManager::selectJob(int64_t now, tx_job_t* job, int64_t* waitUs) {
+    int best = -2;              // -2 = nothing active
+    int64_t bestDue = 0;
 
-    // Service UUID if specified
-    if (sig->service_uuid != 0) {
-        advData[pos++] = 0x03;  // Length
-        advData[pos++] = 0x03;  // Type: Complete List of 16-bit Service UUIDs
-        advData[pos++] = sig->service_uuid & 0xFF;
-        advData[pos++] = (sig->service_uuid >> 8) & 0xFF;
+    for (int i = 0; i < TX_MAX_CONCURRENT; i++) {
+        tx_session_t* session = &_sessions[i];
+        if (!session->active || session->sig == nullptr) {
+            continue;
+        }
+        if (best == -2 || session->nextDue < bestDue) {
+            best = i;
+            bestDue = session->nextDue;
+        }
     }
 
-    *advLen = pos;
-    return pos > 0;
-}
+    // The extended backend keeps confusion instances on their own sets
+    if (_confusionActive && !TX_EXT_ADV) {
+        if (best == -2 || _confusionNextDue < bestDue) {
+            best = TX_JOB_CONFUSION;
+            bestDue = _confusionNextDue;
+        }
+    }
 
-// =============================================================================
-// PACKET TRANSMISSION
-// =============================================================================
-void TXManager::transmitPacket(tx_session_t* session) {
-    if (!session->active || session->sig == nullptr) {
-        return;
+    if (best == -2) {
+        return false;
+    }
+    if (bestDue > now) {
+        *waitUs = min(bestDue - now, (int64_t)TX_IDLE_POLL_MS * 1000);
+        return false;
     }
 
-    // Build advertising data
-    uint8_t advData[31];
-    uint8_t advLen = 0;
+    // The next deadline is one interval after this one, however late this
+    // packet goes out. Falling more than a whole interval behind gives up
+    // the missed deadlines and restarts the schedule from now.
+    int64_t* nextDue;
+    tx_timing_t* timing;
+    if (best == TX_JOB_CONFUSION) {
+        nextDue = &_confusionNextDue;
+        timing = &_confusionTiming;
+    } else {
+        nextDue = &_sessions[best].nextDue;
+        timing = &_sessions[best].timing;
+    }
+    int64_t intervalUs = (int64_t)timing->intervalMs * 1000;
+    job->due = bestDue;
+    job->resync = false;
+    *nextDue = bestDue + intervalUs;
+    if (*nextDue <= now) {
+        if (intervalUs > 0) {
+            timing->missed += (uint32_t)((now - bestDue) / intervalUs);
+        }
+        job->due = now;
+        job->resync = true;
+        *nextDue = now + intervalUs;
+    }
 
-    if (!buildAdvertisingData(session->sig, advData, &advLen)) {
-        return;
+    if (best == TX_JOB_CONFUSION) {
+        return prepareConfusionJob(job);
     }
 
+    tx_session_t* session = &_sessions[best];
+
     // Generate new MAC if needed
     if (session->randomMacPerPacket) {
         generateRandomMac(session->currentMac);
     }
 
-    // Set the random address
-    esp_err_t err = esp_ble_gap_set_rand_addr(session->currentMac);
-    if (err != ESP_OK) {
-        Serial.printf("[TX] Failed to set random addr: %d\n", err);
+    job->session = best;
+    job->sessionGeneration = session->generation;
+    memcpy(job->mac, session->currentMac, 6);
+    return preparePayload(&session->payload, best, job);
+}
+
+bool TXManager::prepareConfusionJob(tx_job_t* job) {
+    // Find next enabled entry (round-robin)
+    for (int n = 0; n < TX_CONFUSION_MAX_DEVICES; n++) {
+        uint8_t index = _confusionIndex;
+        confusion_entry_t* entry = &_confusionEntries[index];
+        _confusionIndex = (_confusionIndex + 1) % TX_CONFUSION_MAX_DEVICES;
+        if (entry->enabled && entry->sig != nullptr) {
+            job->session = TX_JOB_CONFUSION;
+            generateRandomMac(job->mac);
+            return preparePayload(&entry->payload, TX_MAX_CONCURRENT + index, job);
+        }
+    }
+    return false;
+}
+
+void TXManager::completeJob(const tx_job_t* job, int64_t onAir) {
+    _totalPacketsSent++;
+    notifyObserver();
+
+    if (job->session == TX_JOB_CONFUSION) {
+        _confusionPacketsSent++;
+        timingRecord(&_confusionTiming, job->due, onAir, !job->resync);
+        return;
+    }
+
+    // The session may have been stopped, and its slot even reused by a new
+    // one, while the packet was on air
+    tx_session_t* session = &_sessions[job->session];
+    if (!session->active || session->generation != job->sessionGeneration) {
         return;
     }
+    session->packetsSent++;
+    timingRecord(&session->timing, job->due, onAir, !job->resync);
+
+    // Check if we've reached the count limit
+    if (session->remainingCount > 0) {
+        session->remainingCount--;
+        if (session->remainingCount == 0) {
+            session->active = false;
+        }
+    }
+}
+
+// =============================================================================
+// PACKET TRANSMISSION
+// =============================================================================
+bool TXManager::waitGapEvent(esp_gap_ble_cb_event_t event) {
+    uint32_t start = millis();
+    tx_gap_event_t evt;
+    for (;;) {
+        uint32_t elapsed = millis() - start;
+        if (elapsed >= TX_GAP_TIMEOUT_MS) {
+            Serial.printf("[TX] Timeout waiting for GAP event %d\n", event);
+            return false;
+        }
+        if (xQueueReceive(_gapEvents, &evt, pdMS_TO_TICKS(TX_GAP_TIMEOUT_MS - elapsed)) != pdTRUE) {
+            continue;
+        }
+        if (evt.event == event) {
+            return evt.status == ESP_BT_STATUS_SUCCESS;
+        }
+    }
+}
 
+#if !TX_EXT_ADV
+// Address -> data -> start -> dwell -> stop, each step gated on its
+// completion event. Only this task waits. *onAir is when advertising
+// started.
+bool TXManager::sendPacket(const tx_job_t* job, int64_t* onAir) {
     // Configure advertising parameters - use faster interval for single burst
     esp_ble_adv_params_t advParams = {
         .adv_int_min = 0x20,   // 20ms (minimum allowed)
@@ -382,122 +840,248 @@ void TXManager::transmitPacket(tx_session_t* session) {
         .adv_filter_policy = ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY,
     };
 
-    // Configure raw advertising data
-    err = esp_ble_gap_config_adv_data_raw(advData, advLen);
-    if (err != ESP_OK) {
-        Serial.printf("[TX] Failed to config adv data: %d\n", err);
-        return;
+    xQueueReset(_gapEvents);  // Drop completions of an earlier, timed out step
+
+    // Set the random address; the scan pauses only for this step and keeps
+    // running alongside the advertising dwell. Each change costs a scan
+    // stop and restart (PERF_TX_ADDR), so an unchanged address is kept.
+    esp_err_t err;
+    if (!_addrValid || memcmp(_addr, job->mac, 6) != 0) {
+        PERF_SCOPE(PERF_TX_ADDR);
+        bleScanner.holdForTx(true);
+        err = esp_ble_gap_set_rand_addr((uint8_t*)job->mac);
+        bool addrSet = (err == ESP_OK && waitGapEvent(ESP_GAP_BLE_SET_STATIC_RAND_ADDR_EVT));
+        bleScanner.holdForTx(false);
+        if (!addrSet) {
+            _addrValid = false;
+            Serial.printf("[TX] Failed to set random addr: %d\n", err);
+            return false;
+        }
+        memcpy(_addr, job->mac, 6);
+        _addrValid = true;
+        _addrChanges++;
+    } else {
+        _addrSkipped++;
     }
 
-    // Small delay for config to apply
-    delay(10);
+    // Configure raw advertising data (only the address changes otherwise)
+    if (job->uploadData) {
+        err = esp_ble_gap_config_adv_data_raw((uint8_t*)job->advData, job->advLen);
+        if (err != ESP_OK || !waitGapEvent(ESP_GAP_BLE_ADV_DATA_RAW_SET_COMPLETE_EVT)) {
+            Serial.printf("[TX] Failed to config adv data: %d\n", err);
+            return false;
+        }
+    }
 
     // Start advertising
     err = esp_ble_gap_start_advertising(&advParams);
-    if (err != ESP_OK) {
+    if (err != ESP_OK || !waitGapEvent(ESP_GAP_BLE_ADV_START_COMPLETE_EVT)) {
         Serial.printf("[TX] Failed to start advertising: %d\n", err);
-        return;
+        esp_ble_gap_stop_advertising();
+        return false;
     }
+    *onAir = esp_timer_get_time();
 
-    // Wait for advertising to start and transmit on all 3 channels
-    // BLE advertising interval is 20ms, need at least one full interval
-    // plus time to transmit on all 3 advertising channels
-    delay(30);
+    // BLE advertising interval is 20ms; stay on air for at least one full
+    // interval so the packet goes out on all 3 advertising channels
+    vTaskDelay(pdMS_TO_TICKS(TX_ADV_DWELL_MS));
 
     // Stop advertising
     esp_ble_gap_stop_advertising();
+    return waitGapEvent(ESP_GAP_BLE_ADV_STOP_COMPLETE_EVT);
+}
+#endif
+
+#if TX_EXT_ADV
+// =============================================================================
+// EXTENDED ADVERTISING BACKEND
+// =============================================================================
+static_assert(TX_EXT_ADV_SETS >= 2, "Need a session set and at least one confusion set");
+
+// Legacy non-connectable PDUs on an extended set, so scanners that only
+// understand BLE 4.x see the same packets as from the legacy backend
+bool TXManager::configureSet(uint8_t set, uint32_t intervalMs) {
+    esp_ble_gap_ext_adv_params_t params = {};
+    uint32_t interval = intervalMs * 8 / 5;     // 0.625 ms units
+    params.type = ESP_BLE_GAP_SET_EXT_ADV_PROP_LEGACY_NONCONN;
+    params.interval_min = interval < 0x20 ? 0x20 : interval;
+    params.interval_max = params.interval_min;
+    params.channel_map = ADV_CHNL_ALL;
+    params.own_addr_type = BLE_ADDR_TYPE_RANDOM;
+    params.peer_addr_type = BLE_ADDR_TYPE_PUBLIC;
+    params.filter_policy = ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY;
+    params.tx_power = EXT_ADV_TX_PWR_NO_PREFERENCE;
+    params.primary_phy = ESP_BLE_GAP_PRI_PHY_1M;
+    params.secondary_phy = ESP_BLE_GAP_PHY_1M;
+
+    esp_err_t err = esp_ble_gap_ext_adv_set_params(set, &params);
+    return err == ESP_OK && waitGapEvent(ESP_GAP_BLE_EXT_ADV_SET_PARAMS_COMPLETE_EVT);
+}
 
-    // Small delay for stop to complete
-    delay(5);
+// Sets have their own addresses, so unlike the legacy path the scan keeps
+// running
+bool TXManager::setSetAddress(uint8_t set, const uint8_t* mac) {
+    esp_err_t err = esp_ble_gap_ext_adv_set_rand_addr(set, (uint8_t*)mac);
+    if (err != ESP_OK || !waitGapEvent(ESP_GAP_BLE_EXT_ADV_SET_RAND_ADDR_COMPLETE_EVT)) {
+        Serial.printf("[TX] Failed to set random addr for set %d: %d\n", set, err);
+        return false;
+    }
+    return true;
+}
 
-    // Update counters
-    session->packetsSent++;
-    session->lastTxTime = millis();
-    _totalPacketsSent++;
+bool TXManager::setSetData(uint8_t set, const uint8_t* data, uint8_t len) {
+    esp_err_t err = esp_ble_gap_config_ext_adv_data_raw(set, len, data);
+    if (err != ESP_OK || !waitGapEvent(ESP_GAP_BLE_EXT_ADV_DATA_SET_COMPLETE_EVT)) {
+        Serial.printf("[TX] Failed to config adv data for set %d: %d\n", set, err);
+        return false;
+    }
+    return true;
+}
 
-    // Check if we've reached the count limit
-    if (session->remainingCount > 0) {
-        session->remainingCount--;
-        if (session->remainingCount == 0) {
-            session->active = false;
+// One advertising event on the session set. The controller ends it by
+// itself after max_events, so there is no dwell and no stop command.
+bool TXManager::sendPacket(const tx_job_t* job, int64_t* onAir) {
+    xQueueReset(_gapEvents);  // Drop completions of an earlier, timed out step
+
+    // Parameters are set once; only address and data change per packet.
+    // The interval does not matter for a single event.
+    if (!_sessionSetReady) {
+        if (!configureSet(TX_EXT_SESSION_SET, TX_DEFAULT_INTERVAL_MS)) {
+            Serial.println("[TX] Failed to set session set params");
+            return false;
         }
+        _sessionSetReady = true;
     }
+
+    if (!_addrValid || memcmp(_addr, job->mac, 6) != 0) {
+        if (!setSetAddress(TX_EXT_SESSION_SET, job->mac)) {
+            _addrValid = false;
+            return false;
+        }
+        memcpy(_addr, job->mac, 6);
+        _addrValid = true;
+        _addrChanges++;
+    } else {
+        _addrSkipped++;
+    }
+
+    if (job->uploadData && !setSetData(TX_EXT_SESSION_SET, job->advData, job->advLen)) {
+        return false;
+    }
+
+    esp_ble_gap_ext_adv_t adv = { TX_EXT_SESSION_SET, 0, 1 };
+    esp_err_t err = esp_ble_gap_ext_adv_start(1, &adv);
+    if (err != ESP_OK || !waitGapEvent(ESP_GAP_BLE_EXT_ADV_START_COMPLETE_EVT)) {
+        Serial.printf("[TX] Failed to start advertising: %d\n", err);
+        return false;
+    }
+    *onAir = esp_timer_get_time();
+    return waitGapEvent(ESP_GAP_BLE_ADV_TERMINATED_EVT);
 }
 
-void TXManager::transmitConfusionPacket() {
-    if (!_confusionActive) {
+// Rebuild the confusion sets when confusion was started, stopped or its
+// entries changed. All GAP calls stay on this task.
+void TXManager::syncConfusionSets() {
+    lock();
+    bool active = _confusionActive;
+    uint32_t generation = _confusionGeneration;
+    unlock();
+
+    if (active == _confusionSetsActive && (!active || generation == _confusionSetGeneration)) {
         return;
     }
 
-    // Find next enabled entry (round-robin)
-    int startIndex = _confusionIndex;
-    do {
-        if (_confusionEntries[_confusionIndex].enabled) {
-            confusion_entry_t* entry = &_confusionEntries[_confusionIndex];
-
-            // Build and transmit for each instance
-            uint8_t advData[31];
-            uint8_t advLen = 0;
-
-            if (buildAdvertisingData(entry->sig, advData, &advLen)) {
-                // Generate random MAC
-                uint8_t mac[6];
-                generateRandomMac(mac);
-                esp_ble_gap_set_rand_addr(mac);
-
-                // Configure advertising with fast interval
-                esp_ble_adv_params_t advParams = {
-                    .adv_int_min = 0x20,
-                    .adv_int_max = 0x20,
-                    .adv_type = ADV_TYPE_NONCONN_IND,
-                    .own_addr_type = BLE_ADDR_TYPE_RANDOM,
-                    .peer_addr = {0},
-                    .peer_addr_type = BLE_ADDR_TYPE_PUBLIC,
-                    .channel_map = ADV_CHNL_ALL,
-                    .adv_filter_policy = ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY,
-                };
-
-                esp_ble_gap_config_adv_data_raw(advData, advLen);
-                delay(5);
-                esp_ble_gap_start_advertising(&advParams);
-                delay(25);  // Allow advertising on all 3 channels
-                esp_ble_gap_stop_advertising();
-                delay(5);
-
-                _totalPacketsSent++;
+    stopConfusionSets();
+    if (active) {
+        startConfusionSets();
+    }
+    _confusionSetGeneration = generation;
+    _confusionSetsActive = active;
+    notifyObserver();
+}
+
+void TXManager::startConfusionSets() {
+    typedef struct {
+        uint8_t mac[6];
+        uint8_t data[31];
+        uint8_t len;
+    } set_content_t;
+    static set_content_t sets[TX_EXT_CONFUSION_SETS];   // TX task only
+    uint8_t count = 0;
+    uint16_t requested = 0;
+
+    // Each instance is a distinct device: own set, own address, own filler
+    lock();
+    for (int i = 0; i < TX_CONFUSION_MAX_DEVICES; i++) {
+        confusion_entry_t* entry = &_confusionEntries[i];
+        if (!entry->enabled || entry->sig == nullptr || entry->payload.len == 0) {
+            continue;
+        }
+        for (uint8_t n = 0; n < entry->instanceCount; n++) {
+            requested++;
+            if (count >= TX_EXT_CONFUSION_SETS) {
+                continue;
+            }
+            if (!_staticPayload) {
+                advRandomizePayload(&entry->payload, &_prngState);
             }
+            generateRandomMac(sets[count].mac);
+            memcpy(sets[count].data, entry->payload.data, entry->payload.len);
+            sets[count].len = entry->payload.len;
+            count++;
+        }
+    }
+    _confusionInstances = requested;
+    unlock();
+
+    // Stop at the first set the controller has no room for; the ones after
+    // it would fail the same way
+    esp_ble_gap_ext_adv_t adv[TX_EXT_CONFUSION_SETS];
+    uint8_t ready = 0;
+    xQueueReset(_gapEvents);
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t set = TX_EXT_SESSION_SET + 1 + i;
+        if (!configureSet(set, TX_EXT_CONFUSION_INTERVAL_MS)) {
+            break;
+        }
+        if (!setSetAddress(set, sets[i].mac) || !setSetData(set, sets[i].data, sets[i].len)) {
+            _failedCount++;
+            break;
+        }
+        adv[ready].instance = set;
+        adv[ready].duration = 0;        // Until stopped
+        adv[ready].max_events = 0;
+        ready++;
+    }
 
-            // Move to next
-            _confusionIndex = (_confusionIndex + 1) % TX_CONFUSION_MAX_DEVICES;
-            return;
+    if (ready > 0) {
+        esp_err_t err = esp_ble_gap_ext_adv_start(ready, adv);
+        if (err != ESP_OK || !waitGapEvent(ESP_GAP_BLE_EXT_ADV_START_COMPLETE_EVT)) {
+            Serial.printf("[TX] Failed to start confusion sets: %d\n", err);
+            _failedCount++;
+            ready = 0;
         }
-        _confusionIndex = (_confusionIndex + 1) % TX_CONFUSION_MAX_DEVICES;
-    } while (_confusionIndex != startIndex);
+    }
+    _confusionSetCount = ready;
+
+    Serial.printf("[TX] Confusion: %d of %d instances on air\n", ready, requested);
 }
 
-// =============================================================================
-// MAIN PROCESSING LOOP
-// =============================================================================
-void TXManager::process() {
-    uint32_t now = millis();
+void TXManager::stopConfusionSets() {
+    if (_confusionSetCount == 0) {
+        return;
+    }
 
-    // Process individual TX sessions
-    for (int i = 0; i < TX_MAX_CONCURRENT; i++) {
-        tx_session_t* session = &_sessions[i];
-        if (session->active) {
-            if (now - session->lastTxTime >= session->intervalMs) {
-                transmitPacket(session);
-            }
-        }
+    uint8_t instances[TX_EXT_CONFUSION_SETS];
+    for (uint8_t i = 0; i < _confusionSetCount; i++) {
+        instances[i] = TX_EXT_SESSION_SET + 1 + i;
     }
 
-    // Process confusion mode
-    if (_confusionActive) {
-        // Transmit at high rate for confusion effect
-        static uint32_t lastConfuseTime = 0;
-        if (now - lastConfuseTime >= 20) {  // 50 packets/sec max
-            transmitConfusionPacket();
-            lastConfuseTime = now;
-        }
+    xQueueReset(_gapEvents);
+    esp_err_t err = esp_ble_gap_ext_adv_stop(_confusionSetCount, instances);
+    if (err != ESP_OK || !waitGapEvent(ESP_GAP_BLE_EXT_ADV_STOP_COMPLETE_EVT)) {
+        Serial.printf("[TX] Failed to stop confusion sets: %d\n", err);
     }
+    _confusionSetCount = 0;
 }
+#endif
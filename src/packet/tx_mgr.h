@@ -3,6 +3,23 @@
  * TX Manager - BLE Advertisement Transmission
  *
  * Handles simulating BLE advertising packets for testing and countermeasures.
+ * Packets are sent from a dedicated task (TASK_BLE_TX_*) which steps through
+ * address set -> data set -> adv start -> dwell -> adv stop on the GAP
+ * completion events, so no other task waits on the controller.
+ *
+ * Sessions and the confusion stream are scheduled earliest deadline first
+ * on absolute esp_timer deadlines: each packet is due one interval after
+ * the previous deadline, not after the previous packet, so late packets
+ * don't shift the ones after them. The task sleeps until an esp_timer
+ * one-shot wakes it at the deadline. Each stream keeps statistics of the
+ * interval it actually achieved on air.
+ *
+ * On classic ESP32 there is one legacy advertising instance; sessions and
+ * the confusion stream are time-sliced through it. With the extended GAP
+ * API (BLE_HAL_EXT_API, ESP32-S3) every confusion instance gets its own
+ * advertising set with its own address, and the controller keeps them all
+ * on air at once. Session packets go out on another set as single
+ * advertising events, without the dwell.
  */
 
 #ifndef TX_MGR_H
@@ -11,6 +28,44 @@
 #include <Arduino.h>
 #include "../config.h"
 #include "../detection/signatures.h"
+#include "adv_builder.h"
+#include "../ble/ble_hal.h"
+#include <esp_gap_ble_api.h>
+#include <esp_timer.h>
+
+#define TX_EXT_ADV              BLE_HAL_EXT_API
+
+// Advertising set used for session packets; confusion sets follow it
+#define TX_EXT_SESSION_SET      0
+#define TX_EXT_CONFUSION_SETS   (TX_EXT_ADV_SETS - 1)
+
+// =============================================================================
+// TIMING STATISTICS
+// =============================================================================
+// Histogram of the interval error (achieved - requested, µs): below the
+// first edge, between consecutive edges, at or above the last edge
+#define TX_TIMING_BINS          8
+constexpr int32_t txTimingEdgesUs[TX_TIMING_BINS - 1] = {
+    -1000, -250, 250, 1000, 2000, 5000, 20000
+};
+
+typedef struct {
+    uint32_t intervalMs;                // Requested
+    int64_t lastOnAir;                  // esp_timer µs of the previous packet, 0 = none
+    uint32_t samples;                   // Intervals measured
+    float meanErrUs;                    // Mean interval error
+    float m2;                           // Sum of squared deviations (Welford)
+    int32_t minErrUs;
+    int32_t maxErrUs;
+    uint32_t hist[TX_TIMING_BINS];
+    uint32_t packets;                   // Packets timed against their deadline
+    uint64_t latenessSumUs;             // Deadline to on air
+    uint32_t latenessMaxUs;
+    uint32_t missed;                    // Deadlines given up after falling behind
+} tx_timing_t;
+
+// Standard deviation of the interval error, µs
+float txTimingJitterUs(const tx_timing_t* timing);
 
 // =============================================================================
 // TX SESSION STRUCTURE
@@ -21,8 +76,12 @@ typedef struct {
     uint32_t intervalMs;                // Interval between packets
     int32_t remainingCount;             // Packets remaining (-1 = infinite)
     uint32_t packetsSent;               // Total packets sent
-    uint32_t lastTxTime;                // Last transmission timestamp
+    int64_t nextDue;                    // esp_timer µs deadline of the next packet
+    tx_timing_t timing;
+    uint32_t startTime;                 // Session start (for achieved rate)
+    uint32_t generation;                // _sessionGeneration when started
     uint8_t currentMac[6];              // Current MAC address
+    tx_payload_t payload;               // Cached advertising data
     bool randomMacPerPacket;            // Randomize MAC each packet
     bool active;                        // Session is active
 } tx_session_t;
@@ -34,9 +93,39 @@ typedef struct {
     char deviceName[32];                // Device name
     const device_signature_t* sig;      // Signature pointer
     uint8_t instanceCount;              // Number of instances to simulate
+    tx_payload_t payload;               // Cached advertising data
     bool enabled;                       // Entry is enabled
 } confusion_entry_t;
 
+// =============================================================================
+// TX JOB (one packet, prepared under the lock and sent without it)
+// =============================================================================
+#define TX_JOB_CONFUSION    (-1)
+#define TX_SOURCE_NONE      (-1)        // Payload sources: sessions, then
+                                        // TX_MAX_CONCURRENT + confusion entry
+
+typedef struct {
+    int8_t session;                     // Session index or TX_JOB_CONFUSION
+    uint32_t sessionGeneration;         // Session's generation when prepared
+    int16_t source;                     // Which cached payload advData is from
+    uint32_t payloadGeneration;         // _payloadGeneration when prepared
+    uint8_t mac[6];                     // Random address for this packet
+    uint8_t advData[31];                // Raw advertising data
+    uint8_t advLen;
+    bool uploadData;                    // False if the controller already has it
+    int64_t due;                        // esp_timer µs deadline
+    bool resync;                        // Schedule restarted; no interval to measure
+} tx_job_t;
+
+typedef struct {
+    esp_gap_ble_cb_event_t event;
+    esp_bt_status_t status;
+} tx_gap_event_t;
+
+// Called after sessions, confusion state or packet counters change; runs on
+// the caller's or the TX task, so it must be short and must not block
+typedef void (*tx_observer_t)();
+
 // =============================================================================
 // TX MANAGER CLASS
 // =============================================================================
@@ -46,6 +135,7 @@ public:
 
     // Initialization
     void init();
+    void setObserver(tx_observer_t observer) { _observer = observer; }
 
     // Single device transmission
     int startTx(const char* deviceName, uint32_t intervalMs = TX_DEFAULT_INTERVAL_MS,
@@ -73,25 +163,106 @@ public:
     const device_signature_t* getTransmittableSignature(int index);
     const device_signature_t* findSignatureByName(const char* name);
 
-    // Processing (call from loop)
-    void process();
-
     // Statistics
     uint32_t getTotalPacketsSent() { return _totalPacketsSent; }
+    float getRequestedRate(const tx_session_t* session);    // Packets/sec
+    float getAchievedRate(const tx_session_t* session);
+    float getConfusionRequestedRate();
+    float getConfusionAchievedRate();
+    uint32_t getFailedCount() { return _failedCount; }
+
+    // Copies taken under the lock, for display and status output; the TX
+    // task updates the originals while a packet completes. Sessions return
+    // false if inactive, entries (indexed like getConfusionEntry) if absent.
+    bool getSessionSnapshot(int index, tx_session_t* out);
+    bool getConfusionEntrySnapshot(int index, confusion_entry_t* out);
+    void getConfusionTiming(tx_timing_t* out);
+
+    // Backend; with extended advertising the confusion instances are
+    // counted as requested and as actually on air
+    bool isExtendedAdv() { return TX_EXT_ADV != 0; }
+    int getConfusionSetCount() { return _confusionSetCount; }
+    int getConfusionInstanceCount() { return _confusionInstances; }
+
+    // Static payload mode: filler bytes are fixed at session start and the
+    // advertising data is only uploaded when the source changes
+    void setStaticPayload(bool enabled);
+    bool isStaticPayload() { return _staticPayload; }
+    uint32_t getUploadsSkipped() { return _uploadsSkipped; }
+
+    // Random address changes, each with a scan pause, and packets that
+    // reused the address already set
+    uint32_t getAddrChanges() { return _addrChanges; }
+    uint32_t getAddrSkipped() { return _addrSkipped; }
 
 private:
     tx_session_t _sessions[TX_MAX_CONCURRENT];
     confusion_entry_t _confusionEntries[TX_CONFUSION_MAX_DEVICES];
     bool _confusionActive;
     uint32_t _totalPacketsSent;
+    uint32_t _sessionGeneration;        // Bumped by every startTx
     uint8_t _confusionIndex;  // Round-robin index for confusion mode
+    uint32_t _confusionStartTime;
+    int64_t _confusionNextDue;          // esp_timer µs
+    tx_timing_t _confusionTiming;
+    uint32_t _confusionPacketsSent;
+    uint32_t _failedCount;
+
+    // Extended backend: confusion sets are rebuilt whenever the list changes
+    uint32_t _confusionGeneration;      // Bumped by every confusion change
+    uint32_t _confusionSetGeneration;   // Generation the sets were built from
+    bool _confusionSetsActive;
+    uint8_t _confusionSetCount;         // Sets on air
+    uint16_t _confusionInstances;       // Instances requested
+    bool _sessionSetReady;              // Session set parameters configured
+
+    // Payload cache
+    bool _staticPayload;
+    int16_t _uploadedSource;            // Payload the controller holds now
+    uint32_t _payloadGeneration;        // Bumped whenever a payload is rebuilt
+    uint32_t _uploadsSkipped;
+
+    // Random address cache (TX task only)
+    uint8_t _addr[6];                   // Address the controller holds now
+    bool _addrValid;
+    uint32_t _addrChanges;
+    uint32_t _addrSkipped;
+    uint32_t _prngState;                // xorshift32, seeded from esp_random()
+
+    // TX task
+    TaskHandle_t _task;
+    SemaphoreHandle_t _lock;            // Guards sessions and confusion entries
+    QueueHandle_t _gapEvents;           // Completion events from the GAP callback
+    esp_timer_handle_t _deadlineTimer;  // Wakes the task at the next deadline
+    tx_observer_t _observer;
 
     // Internal methods
+    uint32_t nextRandom();
     void generateRandomMac(uint8_t* mac);
-    bool buildAdvertisingData(const device_signature_t* sig, uint8_t* advData, uint8_t* advLen);
-    void transmitPacket(tx_session_t* session);
-    void transmitConfusionPacket();
+    bool buildAdvertisingData(const device_signature_t* sig, tx_payload_t* payload);
+    bool preparePayload(tx_payload_t* payload, int16_t source, tx_job_t* job);
     int findFreeSession();
+    void lock();
+    void unlock();
+    void wakeTask();
+    void notifyObserver();
+    static void taskEntry(void* param);
+    static void onDeadline(void* arg);
+    static void onGapEvent(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param);
+    void run();
+    bool selectJob(int64_t now, tx_job_t* job, int64_t* waitUs);
+    bool prepareConfusionJob(tx_job_t* job);
+    bool sendPacket(const tx_job_t* job, int64_t* onAir);
+    bool waitGapEvent(esp_gap_ble_cb_event_t event);
+#if TX_EXT_ADV
+    bool configureSet(uint8_t set, uint32_t intervalMs);
+    bool setSetAddress(uint8_t set, const uint8_t* mac);
+    bool setSetData(uint8_t set, const uint8_t* data, uint8_t len);
+    void syncConfusionSets();
+    void startConfusionSets();
+    void stopConfusionSets();
+#endif
+    void completeJob(const tx_job_t* job, int64_t onAir);
 };
 
 // Global TX manager instance
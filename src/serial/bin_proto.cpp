@@ -0,0 +1,105 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Binary Serial Protocol Implementation
+ */
+
+#include "bin_proto.h"
+#include <atomic>
+
+// Raw frames are built on the match task and buffered, event frames on the
+// serial task and written at once, so each stream has its own sequence
+static std::atomic<uint8_t> rawSeq(0);
+static std::atomic<uint8_t> eventSeq(0);
+static std::atomic<uint32_t> framesSent(0);
+static std::atomic<uint32_t> framesDropped(0);
+
+// =============================================================================
+// CRC AND COBS
+// =============================================================================
+uint16_t binCrc16(const uint8_t* data, size_t len) {
+    // Nibble-wise lookup: a 32-byte table instead of 512
+    static const uint16_t table[16] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    };
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc = (crc << 4) ^ table[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (crc << 4) ^ table[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+    return crc;
+}
+
+// out must hold len + len / 254 + 1 bytes; returns the encoded length
+size_t binCobsEncode(const uint8_t* in, size_t len, uint8_t* out) {
+    size_t codePos = 0;
+    size_t pos = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[codePos] = code;
+            codePos = pos++;
+            code = 1;
+            continue;
+        }
+        out[pos++] = in[i];
+        if (++code == 0xFF) {
+            out[codePos] = code;
+            codePos = pos++;
+            code = 1;
+        }
+    }
+    out[codePos] = code;
+    return pos;
+}
+
+// =============================================================================
+// FRAME OUTPUT
+// =============================================================================
+size_t binEncodeFrame(uint8_t type, const void* payload, size_t len, uint8_t* out) {
+    if (len > BIN_PAYLOAD_MAX) {
+        return 0;
+    }
+
+    uint8_t raw[2 + BIN_PAYLOAD_MAX + 2];
+    raw[0] = type;
+    // Lets the collector count lost frames
+    std::atomic<uint8_t>& seq = (type == BIN_FRAME_RAW_ADV) ? rawSeq : eventSeq;
+    raw[1] = seq.fetch_add(1, std::memory_order_relaxed);
+    memcpy(&raw[2], payload, len);
+    uint16_t crc = binCrc16(raw, 2 + len);
+    raw[2 + len] = crc & 0xFF;
+    raw[3 + len] = crc >> 8;
+
+    // Leading delimiter ends any text the host received before this frame
+    out[0] = 0x00;
+    size_t n = 1 + binCobsEncode(raw, 4 + len, &out[1]);
+    out[n++] = 0x00;
+    return n;
+}
+
+bool binSendFrame(uint8_t type, const void* payload, size_t len) {
+    uint8_t frame[BIN_FRAME_MAX];
+    size_t n = binEncodeFrame(type, payload, len, frame);
+    if (n == 0) {
+        return false;
+    }
+
+    // Dropped frames still used up a sequence number so the gap shows
+    if (Serial.availableForWrite() < (int)n) {
+        framesDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    Serial.write(frame, n);
+    framesSent.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+uint32_t binGetFramesSent() {
+    return framesSent.load(std::memory_order_relaxed);
+}
+
+uint32_t binGetFramesDropped() {
+    return framesDropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,34 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Binary Serial Protocol - COBS framed event records
+ *
+ * Compact alternative to the text/JSON event lines for host-side collectors.
+ * Each record is [type][seq][payload][crc16], COBS encoded and wrapped in
+ * 0x00 delimiters, so a decoder can resynchronise on any zero byte and drop
+ * whatever fails the CRC (such as interleaved text command responses).
+ * Multi-byte fields are little-endian. Frames are dropped rather than
+ * blocking the serial task when the UART TX buffer is full.
+ */
+
+#ifndef BIN_PROTO_H
+#define BIN_PROTO_H
+
+#include <Arduino.h>
+#include "../config.h"
+#include "bin_records.h"
+
+// =============================================================================
+// API
+// =============================================================================
+uint16_t binCrc16(const uint8_t* data, size_t len);     // CRC-16/CCITT-FALSE
+size_t binCobsEncode(const uint8_t* in, size_t len, uint8_t* out);
+
+// Frame one record into out (BIN_FRAME_MAX bytes); returns the frame length
+size_t binEncodeFrame(uint8_t type, const void* payload, size_t len, uint8_t* out);
+
+// Frame and queue one record; returns false if it was dropped
+bool binSendFrame(uint8_t type, const void* payload, size_t len);
+uint32_t binGetFramesSent();
+uint32_t binGetFramesDropped();
+
+#endif // BIN_PROTO_H
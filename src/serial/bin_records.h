@@ -0,0 +1,106 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Binary Serial Protocol - record layouts
+ *
+ * Frame types and packed record structures shared by the firmware
+ * (bin_proto, raw_stream) and host tools. Multi-byte fields are
+ * little-endian.
+ */
+
+#ifndef BIN_RECORDS_H
+#define BIN_RECORDS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../config.h"
+
+// =============================================================================
+// FRAME TYPES
+// =============================================================================
+#define BIN_FRAME_DETECT        0x01
+#define BIN_FRAME_TX_EVENT      0x02
+#define BIN_FRAME_RAW_ADV       0x03
+#define BIN_FRAME_FOLLOWER      0x04
+#define BIN_FRAME_REMOTE        0x05
+
+#define BIN_TX_START            0x01
+#define BIN_TX_STOP             0x02
+#define BIN_TX_STOP_ALL         0x03
+
+#define BIN_SIG_NONE            0xFFFF  // Signature ID when not applicable
+
+// Largest payload a frame carries, and the worst-case encoded frame
+// (header, CRC, COBS overhead and both delimiters)
+#define BIN_PAYLOAD_MAX         96
+#define BIN_FRAME_MAX           (1 + 2 + BIN_PAYLOAD_MAX + 2 + 1 + 1)
+
+// =============================================================================
+// RECORDS
+// =============================================================================
+// sigId is the index printed by SIG LIST
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp;                 // millis()
+    uint8_t mac[6];
+    int8_t rssi;
+    uint16_t sigId;
+    uint8_t category;
+    uint8_t threatLevel;
+    uint16_t companyId;
+} bin_detect_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp;                 // millis()
+    uint8_t event;                      // BIN_TX_*
+    uint16_t sigId;
+    uint32_t intervalMs;
+    int32_t count;                      // -1 = infinite
+    uint32_t packetsSent;
+} bin_tx_event_t;
+
+// A tracker stayed in range for FOLLOWER_DWELL_MIN minutes
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp;                 // millis()
+    uint8_t mac[6];                     // Current address
+    int8_t rssi;                        // Filtered
+    uint16_t sigId;
+    uint16_t clusterId;
+    uint32_t dwellSec;
+} bin_follower_t;
+
+// One device from an uplink node (collector only). Fields without the
+// matching UPLINK_FIELD_* bit are zero; sigId is the node's SIG LIST index.
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp;                 // Collector millis() when received
+    uint8_t node[6];                    // Node MAC
+    uint16_t seq;                       // Node packet sequence number
+    uint16_t lost;                      // Packets missing before this one (saturating)
+    uint8_t fields;                     // UPLINK_FIELD_*
+    uint8_t mac[6];
+    int8_t rssi;
+    uint16_t sigId;
+    uint8_t category;
+    uint8_t threatLevel;
+    uint32_t ageMs;                     // Last sighting before the node's batch
+} bin_remote_t;
+
+// Every advertising report as received (STREAM RAW). payload holds advLen
+// bytes of advertising data followed by the scan response, if any.
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp;                 // millis() when received
+    uint8_t mac[6];                     // As printed (most significant first)
+    uint8_t addrType;                   // esp_ble_addr_type_t
+    uint8_t evtType;                    // esp_ble_evt_type_t
+    int8_t rssi;
+    uint8_t advLen;
+    uint8_t payloadLen;
+    uint8_t payload[ADV_RECORD_PAYLOAD_MAX];
+} bin_raw_adv_t;
+
+static_assert(sizeof(bin_detect_t) <= BIN_PAYLOAD_MAX, "Detect record too large");
+static_assert(sizeof(bin_tx_event_t) <= BIN_PAYLOAD_MAX, "TX record too large");
+static_assert(sizeof(bin_raw_adv_t) <= BIN_PAYLOAD_MAX, "Raw record too large");
+static_assert(sizeof(bin_follower_t) <= BIN_PAYLOAD_MAX, "Follower record too large");
+static_assert(sizeof(bin_remote_t) <= BIN_PAYLOAD_MAX, "Remote record too large");
+static_assert(BIN_PAYLOAD_MAX + 4 < 254, "Frames must fit one COBS block");
+
+#endif // BIN_RECORDS_H
@@ -0,0 +1,149 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Serial Command Parser Implementation
+ */
+
+#include "cmd_parser.h"
+#include <string.h>
+#include <strings.h>
+
+// =============================================================================
+// TOKENIZER
+// =============================================================================
+static bool isBlank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+bool cmdNextCommand(char** cursor, cmd_tokens_t* out) {
+    char* p = *cursor;
+    out->argc = 0;
+
+    while (*p != '\0') {
+        while (isBlank(*p)) {
+            p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
+        if (*p == ';') {
+            *p++ = '\0';
+            if (out->argc > 0) {
+                break;
+            }
+            continue;   // Empty command
+        }
+
+        char* tok;
+        if (*p == '"') {
+            tok = ++p;
+            while (*p != '\0' && *p != '"') {
+                p++;
+            }
+            if (*p == '"') {
+                *p++ = '\0';
+            }
+        } else {
+            tok = p;
+            while (*p != '\0' && !isBlank(*p) && *p != ';') {
+                p++;
+            }
+        }
+        if (out->argc < SERIAL_CMD_MAX_TOKENS) {
+            out->argv[out->argc++] = tok;
+        }
+
+        if (isBlank(*p)) {
+            *p++ = '\0';
+        } else if (*p == ';') {
+            *p++ = '\0';
+            break;
+        }
+    }
+
+    *cursor = p;
+    return out->argc > 0;
+}
+
+char* cmdJoin(char** argv, uint8_t argc) {
+    static char empty[] = "";
+    if (argc == 0) {
+        return empty;
+    }
+    // Tokens only ever move left, over their own separators
+    char* end = argv[0] + strlen(argv[0]);
+    for (uint8_t i = 1; i < argc; i++) {
+        size_t len = strlen(argv[i]);
+        *end++ = ' ';
+        memmove(end, argv[i], len + 1);
+        end += len;
+    }
+    return argv[0];
+}
+
+bool cmdParseUint(const char* s, uint32_t* out) {
+    if (*s == '\0') {
+        return false;
+    }
+    uint64_t value = 0;
+    for (; *s != '\0'; s++) {
+        if (*s < '0' || *s > '9') {
+            return false;
+        }
+        value = value * 10 + (*s - '0');
+        if (value > UINT32_MAX) {
+            return false;
+        }
+    }
+    *out = (uint32_t)value;
+    return true;
+}
+
+bool cmdParseInt(const char* s, int32_t* out) {
+    bool negative = (*s == '-');
+    uint32_t magnitude;
+    if (!cmdParseUint(negative ? s + 1 : s, &magnitude) ||
+        magnitude > (negative ? 2147483648u : 2147483647u)) {
+        return false;
+    }
+    *out = negative ? (int32_t)(0 - magnitude) : (int32_t)magnitude;
+    return true;
+}
+
+// =============================================================================
+// LOOKUP
+// =============================================================================
+// Does name equal the words separated by single spaces (ignoring case)?
+static bool nameMatches(const char* name, char** words, uint8_t wordCount) {
+    for (uint8_t w = 0; w < wordCount; w++) {
+        size_t len = strlen(words[w]);
+        if (strncasecmp(name, words[w], len) != 0) {
+            return false;
+        }
+        name += len;
+        if (w + 1 < wordCount) {
+            if (*name != ' ') {
+                return false;
+            }
+            name++;
+        }
+    }
+    return *name == '\0';
+}
+
+int cmdFind(const cmd_entry_t* table, const uint32_t* hashes, const uint8_t* entries,
+            size_t count, uint32_t hash, char** words, uint8_t wordCount) {
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (hashes[mid] < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < count && hashes[lo] == hash && nameMatches(table[entries[lo]].name, words, wordCount)) {
+        return entries[lo];
+    }
+    return -1;
+}
@@ -0,0 +1,123 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Serial Command Parser
+ *
+ * Splits a command line in place (no copies, no heap) into commands
+ * separated by ';' and each command into whitespace-separated tokens;
+ * double quotes group a token that contains spaces. Commands are looked up
+ * by a case-insensitive hash of their one- or two-word name in an index
+ * that is sorted at compile time.
+ */
+
+#ifndef CMD_PARSER_H
+#define CMD_PARSER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../config.h"
+
+// =============================================================================
+// TOKENIZER
+// =============================================================================
+typedef struct {
+    char* argv[SERIAL_CMD_MAX_TOKENS];
+    uint8_t argc;
+} cmd_tokens_t;
+
+// Tokenize the next command of the line at *cursor and advance the cursor
+// past it. Empty commands are skipped. Returns false once the line is used up.
+// Tokens beyond SERIAL_CMD_MAX_TOKENS are ignored.
+bool cmdNextCommand(char** cursor, cmd_tokens_t* out);
+
+// Rejoin argv[0..argc-1] in place with single spaces. Returns argv[0], or
+// "" if argc is 0; argv[1..] are no longer valid afterwards. For arguments
+// that may contain unquoted spaces (device names).
+char* cmdJoin(char** argv, uint8_t argc);
+
+// Strict number parsing: the whole token must be a decimal number
+bool cmdParseUint(const char* s, uint32_t* out);
+bool cmdParseInt(const char* s, int32_t* out);
+
+// =============================================================================
+// COMMAND TABLE
+// =============================================================================
+// Handlers get the arguments after the command name
+typedef void (*cmd_handler_t)(char** argv, uint8_t argc);
+
+typedef struct {
+    const char* name;                   // "VERB" or "VERB SUB", upper case
+    cmd_handler_t handler;
+} cmd_entry_t;
+
+// FNV-1a over the upper-cased name
+constexpr uint32_t cmdHashStep(uint32_t h, char c) {
+    return (h ^ (uint8_t)((c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c)) * 16777619u;
+}
+
+constexpr uint32_t cmdHash(const char* s, uint32_t h = 2166136261u) {
+    while (*s != '\0') {
+        h = cmdHashStep(h, *s++);
+    }
+    return h;
+}
+
+template <size_t N>
+struct cmd_index_t {
+    uint32_t hash[N];                   // Ascending
+    uint8_t entry[N];                   // Table position of each hash
+    bool collision;                     // Two names share a hash
+};
+
+template <size_t N>
+constexpr cmd_index_t<N> cmdIndexBuild(const cmd_entry_t (&table)[N]) {
+    static_assert(N <= 255, "Command table too large");
+    cmd_index_t<N> idx = {};
+    for (size_t i = 0; i < N; i++) {
+        uint32_t h = cmdHash(table[i].name);
+        size_t pos = i;
+        while (pos > 0 && idx.hash[pos - 1] > h) {
+            idx.hash[pos] = idx.hash[pos - 1];
+            idx.entry[pos] = idx.entry[pos - 1];
+            pos--;
+        }
+        if (pos > 0 && idx.hash[pos - 1] == h) {
+            idx.collision = true;
+        }
+        idx.hash[pos] = h;
+        idx.entry[pos] = (uint8_t)i;
+    }
+    return idx;
+}
+
+// Returns the table entry (or -1) for a hash and the words it was built
+// from; the name is compared as well, so a hash match alone is not enough
+int cmdFind(const cmd_entry_t* table, const uint32_t* hashes, const uint8_t* entries,
+            size_t count, uint32_t hash, char** words, uint8_t wordCount);
+
+// Longest match first: "VERB SUB", then "VERB". Sets *used to the number
+// of tokens that form the name.
+template <size_t N>
+const cmd_entry_t* cmdLookup(const cmd_entry_t (&table)[N], const cmd_index_t<N>& idx,
+                             cmd_tokens_t* cmd, uint8_t* used) {
+    if (cmd->argc == 0) {
+        return nullptr;
+    }
+    char** words = cmd->argv;
+    uint32_t verb = cmdHash(words[0]);
+    if (cmd->argc >= 2) {
+        int i = cmdFind(table, idx.hash, idx.entry, N,
+                        cmdHash(words[1], cmdHashStep(verb, ' ')), words, 2);
+        if (i >= 0) {
+            *used = 2;
+            return &table[i];
+        }
+    }
+    int i = cmdFind(table, idx.hash, idx.entry, N, verb, words, 1);
+    if (i >= 0) {
+        *used = 1;
+        return &table[i];
+    }
+    return nullptr;
+}
+
+#endif // CMD_PARSER_H
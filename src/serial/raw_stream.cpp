@@ -0,0 +1,148 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Raw Advertisement Stream Implementation
+ */
+
+#include "raw_stream.h"
+#include "bin_proto.h"
+#include <stddef.h>
+
+static_assert(RAW_STREAM_BUFFER_SIZE >= 2 * BIN_FRAME_MAX, "Raw stream buffer too small");
+
+// Shared between the match task (producer) and the serial task
+static volatile bool streamEnabled = false;
+static QueueHandle_t streamQueue = nullptr;
+static volatile TaskHandle_t streamConsumer = nullptr;
+static volatile uint32_t streamQueueDropped = 0;    // Written by the match task only
+
+// Serial task only
+static uint8_t streamBuf[RAW_STREAM_BUFFER_SIZE];
+static size_t streamUsed = 0;
+static uint16_t streamPending = 0;      // Records in streamBuf
+static uint32_t streamOldest = 0;       // millis() of the first buffered record
+static uint32_t streamSent = 0;
+static uint32_t streamUartDropped = 0;
+
+bool rawStreamInit() {
+    if (streamQueue == nullptr) {
+        streamQueue = xQueueCreate(RAW_STREAM_QUEUE_SIZE, sizeof(adv_record_t));
+    }
+    return streamQueue != nullptr;
+}
+
+void rawStreamSetConsumer(TaskHandle_t task) {
+    streamConsumer = task;
+}
+
+// Write the whole buffer if the UART has room for it; never blocks
+static bool flushBuffer() {
+    if (streamUsed == 0) {
+        return true;
+    }
+    if (Serial.availableForWrite() < (int)streamUsed) {
+        return false;
+    }
+    Serial.write(streamBuf, streamUsed);
+    streamSent += streamPending;
+    streamUsed = 0;
+    streamPending = 0;
+    return true;
+}
+
+static void encodeRecord(const adv_record_t* rec) {
+    bin_raw_adv_t raw;
+    raw.timestamp = rec->timestamp;
+    memcpy(raw.mac, rec->mac, 6);
+    raw.addrType = rec->addrType;
+    raw.evtType = rec->evtType;
+    raw.rssi = rec->rssi;
+    raw.advLen = rec->advLen;
+    raw.payloadLen = rec->payloadLen;
+    memcpy(raw.payload, rec->payload, rec->payloadLen);
+
+    // Only the valid part of the payload goes on the wire
+    size_t len = offsetof(bin_raw_adv_t, payload) + rec->payloadLen;
+    if (streamPending == 0) {
+        streamOldest = millis();
+    }
+    streamUsed += binEncodeFrame(BIN_FRAME_RAW_ADV, &raw, len, &streamBuf[streamUsed]);
+    streamPending++;
+}
+
+static void discardQueued() {
+    if (streamQueue != nullptr) {
+        streamUartDropped += uxQueueMessagesWaiting(streamQueue);
+        xQueueReset(streamQueue);
+    }
+}
+
+void rawStreamSetEnabled(bool enabled) {
+    if (!enabled) {
+        streamEnabled = false;
+        // Whatever can't go out now is lost with the mode
+        if (!flushBuffer()) {
+            streamUartDropped += streamPending;
+        }
+        streamUsed = 0;
+        streamPending = 0;
+        discardQueued();
+        return;
+    }
+    streamEnabled = streamQueue != nullptr;
+}
+
+bool rawStreamIsEnabled() {
+    return streamEnabled;
+}
+
+void rawStreamPush(const adv_record_t* rec) {
+    if (!streamEnabled) {
+        return;
+    }
+    if (xQueueSend(streamQueue, rec, 0) != pdTRUE) {
+        streamQueueDropped++;   // Backpressure: keep what is queued, lose the newest
+        return;
+    }
+    // Wake the serial task once a batch is worth writing; otherwise it
+    // picks the records up within RAW_STREAM_FLUSH_MS
+    TaskHandle_t consumer = streamConsumer;
+    if (consumer != nullptr && uxQueueMessagesWaiting(streamQueue) == RAW_STREAM_QUEUE_SIZE / 2) {
+        xTaskNotifyGive(consumer);
+    }
+}
+
+void rawStreamPoll() {
+    if (!streamEnabled) {
+        // A push that checked the flag just before the stream was disabled
+        discardQueued();
+        return;
+    }
+
+    // Move queued records into the write buffer while it has room; the rest
+    // wait in the queue until the UART drains
+    adv_record_t rec;
+    for (;;) {
+        if (streamUsed + BIN_FRAME_MAX > sizeof(streamBuf) && !flushBuffer()) {
+            break;
+        }
+        if (xQueueReceive(streamQueue, &rec, 0) != pdTRUE) {
+            break;
+        }
+        encodeRecord(&rec);
+    }
+
+    if (streamPending == 0) {
+        return;
+    }
+    if (streamUsed >= sizeof(streamBuf) / 2 || millis() - streamOldest >= RAW_STREAM_FLUSH_MS) {
+        flushBuffer();
+    }
+}
+
+uint32_t rawStreamGetSent() {
+    return streamSent;
+}
+
+uint32_t rawStreamGetDropped() {
+    return streamQueueDropped + streamUartDropped;
+}
@@ -0,0 +1,41 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Raw Advertisement Stream - every scan report, for offline analysis
+ *
+ * STREAM RAW forwards each advertising report (matched or not) as a
+ * BIN_FRAME_RAW_ADV frame. The match task only copies reports into a queue;
+ * the serial task encodes them, collects the frames in a buffer and writes
+ * them in large chunks, so the match task never touches the UART. If the
+ * UART cannot keep up, the queue fills and new reports are dropped and
+ * counted instead of stalling the match task and, behind it, the scan queue.
+ * tools/raw2pcap.py turns a capture into a LINKTYPE_BLUETOOTH_LE_LL pcap.
+ */
+
+#ifndef RAW_STREAM_H
+#define RAW_STREAM_H
+
+#include <Arduino.h>
+#include "../config.h"
+#include "../ble/scanner.h"
+
+// Creates the queue (call from setup, before the tasks start)
+bool rawStreamInit();
+
+// Task notified when the queue is half full (the serial task)
+void rawStreamSetConsumer(TaskHandle_t task);
+
+// Serial task
+void rawStreamSetEnabled(bool enabled);
+bool rawStreamIsEnabled();
+
+// Producer (match task); copies the report, never blocks
+void rawStreamPush(const adv_record_t* rec);
+
+// Consumer (serial task): encode queued reports and write the buffer once
+// it is half full or RAW_STREAM_FLUSH_MS old
+void rawStreamPoll();
+
+uint32_t rawStreamGetSent();
+uint32_t rawStreamGetDropped();
+
+#endif // RAW_STREAM_H
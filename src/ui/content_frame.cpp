@@ -0,0 +1,125 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Content Frame Implementation
+ */
+
+#include "content_frame.h"
+
+// Global instance
+ContentFrame contentFrame;
+
+#define FRAME_W     SCREEN_WIDTH
+#define FRAME_H     CONTENT_HEIGHT
+
+// =============================================================================
+// CONSTRUCTOR
+// =============================================================================
+ContentFrame::ContentFrame() {
+    _tft = nullptr;
+    _sprite = nullptr;
+    _depth = 0;
+    _busy = false;
+    _strip[0] = nullptr;
+    _strip[1] = nullptr;
+}
+
+// =============================================================================
+// INITIALIZATION
+// =============================================================================
+void ContentFrame::init(TFT_eSPI* tft) {
+    _tft = tft;
+    if (!DISPLAY_USE_SPRITE) {
+        return;
+    }
+
+    _sprite = new TFT_eSprite(tft);
+
+    // Prefer 16-bit: the buffer is already in panel format and goes out in one transfer
+    _sprite->setColorDepth(16);
+    if (_sprite->createSprite(FRAME_W, FRAME_H) != nullptr) {
+        _depth = 16;
+    } else {
+        _sprite->setColorDepth(8);
+        _strip[0] = (uint16_t*)malloc(FRAME_W * DISPLAY_STRIP_LINES * sizeof(uint16_t));
+        _strip[1] = (uint16_t*)malloc(FRAME_W * DISPLAY_STRIP_LINES * sizeof(uint16_t));
+        if (_strip[0] != nullptr && _strip[1] != nullptr &&
+            _sprite->createSprite(FRAME_W, FRAME_H) != nullptr) {
+            _depth = 8;
+            // Sprite pixels are RGB332; DMA sends 16-bit words byte-swapped
+            for (int c = 0; c < 256; c++) {
+                uint16_t color = tft->color8to16(c);
+                _lut[c] = (color >> 8) | (color << 8);
+            }
+        } else {
+            free(_strip[0]);
+            free(_strip[1]);
+            _strip[0] = nullptr;
+            _strip[1] = nullptr;
+        }
+    }
+
+    if (_depth == 0) {
+        delete _sprite;
+        _sprite = nullptr;
+        Serial.println("[UI] No memory for content sprite, drawing directly");
+        return;
+    }
+
+    // Offset the origin so drawing code keeps using screen coordinates
+    _sprite->setViewport(0, -CONTENT_FRAME_Y, FRAME_W, FRAME_H + CONTENT_FRAME_Y);
+    tft->initDMA();
+    Serial.printf("[UI] Content sprite %dx%d, %d-bit\n", FRAME_W, FRAME_H, _depth);
+}
+
+// =============================================================================
+// DRAWING
+// =============================================================================
+TFT_eSPI& ContentFrame::begin() {
+    if (_sprite == nullptr) {
+        return *_tft;
+    }
+    waitIdle();  // The 16-bit buffer may still be going out
+    return *_sprite;
+}
+
+void ContentFrame::push() {
+    if (_sprite == nullptr) {
+        return;
+    }
+    waitIdle();
+
+    _tft->startWrite();
+    if (_depth == 16) {
+        _tft->pushImageDMA(0, CONTENT_FRAME_Y, FRAME_W, FRAME_H, (uint16_t*)_sprite->getPointer());
+    } else {
+        pushStrips();
+    }
+    _busy = true;  // endWrite() happens in waitIdle()
+}
+
+// Expand one strip while the previous one is being sent
+void ContentFrame::pushStrips() {
+    const uint8_t* src = (const uint8_t*)_sprite->getPointer();
+    int buf = 0;
+    for (int y = 0; y < FRAME_H; y += DISPLAY_STRIP_LINES) {
+        int lines = min(DISPLAY_STRIP_LINES, FRAME_H - y);
+        uint16_t* dst = _strip[buf];
+        size_t pixels = (size_t)lines * FRAME_W;
+        for (size_t i = 0; i < pixels; i++) {
+            dst[i] = _lut[src[i]];
+        }
+        src += pixels;
+
+        _tft->pushImageDMA(0, CONTENT_FRAME_Y + y, FRAME_W, lines, dst);  // Waits for the previous strip
+        buf ^= 1;
+    }
+}
+
+void ContentFrame::waitIdle() {
+    if (!_busy) {
+        return;
+    }
+    _tft->dmaWait();
+    _tft->endWrite();
+    _busy = false;
+}
@@ -0,0 +1,59 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Content Frame - Off-screen composition of the content area
+ *
+ * Screens draw into a sprite covering the area between the status bar and
+ * the nav bar, then push it to the panel with DMA in one go, so redraws do
+ * not flicker and the CPU is free while the SPI transfer runs. The sprite
+ * uses a viewport offset, so drawing code keeps using screen coordinates.
+ */
+
+#ifndef CONTENT_FRAME_H
+#define CONTENT_FRAME_H
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include "../config.h"
+
+#define CONTENT_FRAME_Y     STATUS_BAR_HEIGHT
+
+// =============================================================================
+// CONTENT FRAME CLASS
+// =============================================================================
+class ContentFrame {
+public:
+    ContentFrame();
+
+    // Allocate the sprite (call after tft.init)
+    void init(TFT_eSPI* tft);
+
+    // Target for drawing the content area: the sprite, or the panel itself
+    // if no sprite could be allocated
+    TFT_eSPI& begin();
+
+    // Send the composed content area to the panel (no-op without a sprite)
+    void push();
+
+    // Wait for a running transfer; call before drawing to the panel directly
+    void waitIdle();
+
+    // Status
+    bool isEnabled() { return _depth != 0; }
+    uint8_t getColorDepth() { return _depth; }
+
+private:
+    TFT_eSPI* _tft;
+    TFT_eSprite* _sprite;
+    uint8_t _depth;                     // 16, 8, or 0 = disabled
+    bool _busy;                         // DMA transfer in flight
+    uint16_t* _strip[2];                // 8-bit mode: expanded line buffers
+    uint16_t _lut[256];                 // 8-bit mode: RGB332 -> panel RGB565
+
+    // Internal methods
+    void pushStrips();
+};
+
+// Global content frame instance
+extern ContentFrame contentFrame;
+
+#endif // CONTENT_FRAME_H
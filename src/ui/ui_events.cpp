@@ -0,0 +1,42 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * UI Events Implementation
+ */
+
+#include "ui_events.h"
+
+// Global instance
+UIEvents uiEvents;
+
+UIEvents::UIEvents() {
+    _task = nullptr;
+    _posted = 0;
+    _frames = 0;
+}
+
+void UIEvents::post(uint32_t events) {
+    TaskHandle_t task = _task;
+    if (task == nullptr || events == 0) {
+        return;
+    }
+    _posted++;
+    xTaskNotify(task, events, eSetBits);
+}
+
+void IRAM_ATTR UIEvents::postFromISR(uint32_t events) {
+    TaskHandle_t task = _task;
+    if (task == nullptr) {
+        return;
+    }
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(task, events, eSetBits, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+uint32_t UIEvents::wait(TickType_t timeout) {
+    uint32_t events = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &events, timeout);
+    return events;
+}
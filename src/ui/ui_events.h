@@ -0,0 +1,56 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * UI Events - What changed since the last frame
+ *
+ * Producers (match task, TX task, serial commands, the touch interrupt)
+ * post event bits here instead of the UI polling for changes. The bits
+ * accumulate in the UI task's notification value, so any number of posts
+ * between two frames costs one wake-up and one redraw.
+ */
+
+#ifndef UI_EVENTS_H
+#define UI_EVENTS_H
+
+#include <Arduino.h>
+#include "../config.h"
+
+typedef enum {
+    UI_EVENT_TOUCH        = 1 << 0,     // Touch controller raised PENIRQ
+    UI_EVENT_WAKE         = 1 << 1,     // Turn the backlight back on
+    UI_EVENT_DEVICE_LIST  = 1 << 2,     // Device added, rekeyed, expired or flagged
+    UI_EVENT_DEVICE_RSSI  = 1 << 3,     // A device's filtered RSSI changed
+    UI_EVENT_TX           = 1 << 4,     // TX sessions or packet counters changed
+    UI_EVENT_MODE         = 1 << 5,     // Status bar mode (scan on/off)
+    UI_EVENT_SCREEN       = 1 << 6      // Redraw the current screen completely
+} ui_event_t;
+
+class UIEvents {
+public:
+    UIEvents();
+
+    // Events posted before the task is set are dropped; setup() draws the
+    // first frame itself
+    void setTask(TaskHandle_t task) { _task = task; }
+
+    // Any task; never blocks
+    void post(uint32_t events);
+    void postFromISR(uint32_t events);
+
+    // UI task: wait up to timeout, returns and clears the pending bits
+    uint32_t wait(TickType_t timeout);
+
+    // Status
+    uint32_t getPostedCount() { return _posted; }
+    uint32_t getFrameCount() { return _frames; }
+    void countFrame() { _frames++; }
+
+private:
+    volatile TaskHandle_t _task;
+    uint32_t _posted;                   // Approximate: producers don't lock
+    uint32_t _frames;
+};
+
+// Global UI event instance
+extern UIEvents uiEvents;
+
+#endif // UI_EVENTS_H
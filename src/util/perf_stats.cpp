@@ -0,0 +1,139 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Performance Statistics Implementation
+ */
+
+#include "perf_stats.h"
+
+#if PERF_STATS_ENABLED
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t hist[PERF_HIST_BUCKETS];
+} perf_hist_t;
+
+static perf_hist_t perfHist[PERF_STAGE_COUNT];
+static uint32_t perfResetTime = 0;
+
+static const char* const PERF_STAGE_NAMES[PERF_STAGE_COUNT] = {
+    "scan_callback",
+    "adv_process",
+    "match",
+    "tx_packet",
+    "tx_addr",
+    "draw_scan",
+    "update_scan",
+    "draw_filter",
+    "draw_tx",
+    "draw_settings",
+    "draw_detail",
+    "serial_cmd",
+    "det_event",
+    "ui_frame",
+};
+
+// =============================================================================
+// BUCKETS
+// =============================================================================
+// Two buckets per power of two: the leading bit selects the octave, the bit
+// below it the half. Values 0 and 1 get their own buckets.
+static inline uint8_t bucketOf(uint32_t v) {
+    if (v < 2) {
+        return v;
+    }
+    uint8_t msb = 31 - __builtin_clz(v);
+    return msb * 2 + ((v >> (msb - 1)) & 1);
+}
+
+// Largest value that falls into bucket b
+static uint32_t bucketUpper(uint8_t b) {
+    if (b < 2) {
+        return b;
+    }
+    uint8_t msb = b / 2;
+    uint64_t lower = (uint64_t)(2 | (b & 1)) << (msb - 1);
+    uint64_t upper = lower + ((uint64_t)1 << (msb - 1)) - 1;
+    return upper > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)upper;
+}
+
+// =============================================================================
+// RECORDING
+// =============================================================================
+void perfRecord(perf_stage_t stage, uint32_t cycles) {
+    perf_hist_t* h = &perfHist[stage];
+    if (h->count == 0 || cycles < h->min) {
+        h->min = cycles;
+    }
+    if (cycles > h->max) {
+        h->max = cycles;
+    }
+    h->count++;
+    h->total += cycles;
+    h->hist[bucketOf(cycles)]++;
+}
+
+// Other tasks may record while this runs; at worst one sample is lost
+void perfReset() {
+    memset(perfHist, 0, sizeof(perfHist));
+    perfResetTime = millis();
+}
+
+// =============================================================================
+// REPORTING
+// =============================================================================
+static uint32_t percentile(const perf_hist_t* h, uint32_t permille) {
+    uint64_t target = ((uint64_t)h->count * permille + 999) / 1000;
+    uint64_t seen = 0;
+    for (uint8_t b = 0; b < PERF_HIST_BUCKETS; b++) {
+        seen += h->hist[b];
+        if (seen >= target) {
+            uint32_t upper = bucketUpper(b);
+            return upper < h->max ? upper : h->max;
+        }
+    }
+    return h->max;
+}
+
+void perfPrint(bool json) {
+    const float mhz = ESP.getCpuFreqMHz();
+    uint32_t elapsed = millis() - perfResetTime;
+
+    if (json) {
+        Serial.printf("{\"event\":\"stats\",\"ts\":%lu,\"window_ms\":%lu,\"stages\":[",
+                      millis(), elapsed);
+    } else {
+        Serial.printf("Window: %lu ms, CPU %d MHz (times in us)\n", elapsed, (int)mhz);
+        Serial.println("Stage              Count    Rate/s      Min      Avg      Max      P99   CPU%");
+    }
+
+    bool first = true;
+    for (int i = 0; i < PERF_STAGE_COUNT; i++) {
+        const perf_hist_t* h = &perfHist[i];
+        float rate = elapsed > 0 ? h->count * 1000.0f / elapsed : 0.0f;
+        float minUs = h->count ? h->min / mhz : 0.0f;
+        float avgUs = h->count ? (float)(h->total / h->count) / mhz : 0.0f;
+        float maxUs = h->max / mhz;
+        float p99Us = h->count ? percentile(h, 990) / mhz : 0.0f;
+        float cpuPct = elapsed > 0 ? (float)h->total / (elapsed * mhz * 1000.0f) * 100.0f : 0.0f;
+
+        if (json) {
+            Serial.printf("%s{\"name\":\"%s\",\"count\":%lu,\"rate\":%.1f,\"min_us\":%.1f,"
+                          "\"avg_us\":%.1f,\"max_us\":%.1f,\"p99_us\":%.1f,\"cpu_pct\":%.2f}",
+                          first ? "" : ",", PERF_STAGE_NAMES[i], h->count, rate,
+                          minUs, avgUs, maxUs, p99Us, cpuPct);
+            first = false;
+        } else {
+            Serial.printf("%-16s %7lu %9.1f %8.1f %8.1f %8.1f %8.1f %6.2f\n",
+                          PERF_STAGE_NAMES[i], h->count, rate, minUs, avgUs, maxUs, p99Us, cpuPct);
+        }
+    }
+
+    if (json) {
+        Serial.println("]}");
+    }
+}
+
+#endif // PERF_STATS_ENABLED
@@ -0,0 +1,71 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Performance Statistics - per-stage cycle histograms
+ *
+ * PERF_SCOPE(stage) times the rest of the enclosing block with the CPU cycle
+ * counter and adds it to that stage's histogram. Histograms are fixed-size
+ * (two buckets per power of two), so recording is a handful of instructions
+ * and never allocates. Each stage must only be recorded from one task; the
+ * tasks involved are pinned, so start and end read the same core's counter.
+ * The CPU column is a stage's total time over the window on one core;
+ * nested stages (match inside adv_process, draws inside ui_frame) count in
+ * both.
+ * With PERF_STATS_ENABLED 0 the scopes compile to nothing.
+ */
+
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+#include <Arduino.h>
+#include "../config.h"
+
+// =============================================================================
+// STAGES
+// =============================================================================
+typedef enum {
+    PERF_SCAN_CALLBACK = 0,     // GAP scan result -> queue (BLE host task)
+    PERF_ADV_PROCESS,           // One queued report through the device table
+    PERF_MATCH,                 // matchSignature
+    PERF_TX_PACKET,             // One TX packet (TX task)
+    PERF_TX_ADDR,               // Random address change with the scan paused
+    PERF_DRAW_SCAN,
+    PERF_UPDATE_SCAN,           // Incremental scan list redraw
+    PERF_DRAW_FILTER,
+    PERF_DRAW_TX,
+    PERF_DRAW_SETTINGS,
+    PERF_DRAW_DETAIL,
+    PERF_SERIAL_CMD,            // processSerialCommand
+    PERF_DET_EVENT,             // One queued detection encoded (serial task)
+    PERF_UI_FRAME,              // One UI task iteration
+    PERF_STAGE_COUNT
+} perf_stage_t;
+
+#define PERF_HIST_BUCKETS       64
+
+#if PERF_STATS_ENABLED
+
+void perfRecord(perf_stage_t stage, uint32_t cycles);
+void perfReset();
+void perfPrint(bool json);
+
+class PerfScope {
+public:
+    explicit PerfScope(perf_stage_t stage) : _stage(stage), _start(ESP.getCycleCount()) {}
+    ~PerfScope() { perfRecord(_stage, ESP.getCycleCount() - _start); }
+
+private:
+    perf_stage_t _stage;
+    uint32_t _start;
+};
+
+#define PERF_CONCAT_(a, b)      a##b
+#define PERF_CONCAT(a, b)       PERF_CONCAT_(a, b)
+#define PERF_SCOPE(stage)       PerfScope PERF_CONCAT(_perfScope, __LINE__)(stage)
+
+#else
+
+#define PERF_SCOPE(stage)
+
+#endif // PERF_STATS_ENABLED
+
+#endif // PERF_STATS_H
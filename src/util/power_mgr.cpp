@@ -0,0 +1,138 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Power Manager Implementation
+ */
+
+#include "power_mgr.h"
+#include <esp_idf_version.h>
+#include <esp_sleep.h>
+#include <driver/uart.h>
+#if CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
+
+// Global instance
+PowerManager powerMgr;
+
+PowerManager::PowerManager() {
+    _idle = false;
+    _lightSleepAllowed = POWERSAVE_LIGHT_SLEEP_DEFAULT;
+    _wifiActive = false;
+    _lightSleep = false;
+#if CONFIG_PM_ENABLE
+    _dfs = true;
+#else
+    _dfs = false;
+#endif
+    _note = "screen on";
+    _transitions = 0;
+    _wakeups = 0;
+    _lastWakeups = 0;
+    _lastUpdate = 0;
+    _wakeupRate = 0.0f;
+}
+
+// =============================================================================
+// INITIALIZATION
+// =============================================================================
+void PowerManager::init() {
+    // Only used in light sleep. The bytes that wake the chip are lost, so
+    // hosts should lead with a newline after a long quiet period.
+    uart_set_wakeup_threshold(UART_NUM_0, POWER_UART_WAKE_EDGES);
+    esp_sleep_enable_uart_wakeup(UART_NUM_0);
+}
+
+// =============================================================================
+// MODE SWITCHING
+// =============================================================================
+bool PowerManager::configure(int maxMhz, int minMhz, bool lightSleep) {
+#if CONFIG_PM_ENABLE
+#if ESP_IDF_VERSION_MAJOR >= 5
+    esp_pm_config_t pm;
+#else
+    esp_pm_config_esp32_t pm;
+#endif
+    pm.max_freq_mhz = maxMhz;
+    pm.min_freq_mhz = minMhz;
+    pm.light_sleep_enable = lightSleep;
+    return esp_pm_configure(&pm) == ESP_OK;
+#else
+    // No esp_pm: fixed clock switch, no light sleep
+    return !lightSleep && setCpuFrequencyMhz(minMhz);
+#endif
+}
+
+void PowerManager::setIdle(bool idle) {
+    if (idle == _idle) {
+        return;
+    }
+    _idle = idle;
+    _transitions++;
+
+    if (!idle) {
+        _lightSleep = false;
+        _note = "screen on";
+        configure(POWER_ACTIVE_CPU_MHZ, POWER_ACTIVE_CPU_MHZ, false);
+        return;
+    }
+    applyIdle();
+}
+
+void PowerManager::setWifiActive(bool active) {
+    if (active == _wifiActive) {
+        return;
+    }
+    _wifiActive = active;
+    if (_idle) {
+        applyIdle();
+    }
+}
+
+void PowerManager::applyIdle() {
+    // Light sleep needs tickless idle in the sdkconfig; esp_pm refuses it
+    // otherwise, and DFS alone is still worth having
+    _lightSleep = false;
+    if (!_lightSleepAllowed) {
+        _note = "disabled in " POWERSAVE_CONFIG_FILE;
+    } else if (_wifiActive) {
+        _note = "uplink on";
+    } else if (configure(POWER_ACTIVE_CPU_MHZ, POWER_IDLE_CPU_MHZ, true)) {
+        _lightSleep = true;
+        _note = "automatic";
+        return;
+    } else {
+        _note = "not supported by this build";
+    }
+    if (!configure(POWER_ACTIVE_CPU_MHZ, POWER_IDLE_CPU_MHZ, false)) {
+        _note = "clock change refused";
+    }
+}
+
+// =============================================================================
+// STATISTICS
+// =============================================================================
+void PowerManager::update(uint32_t now) {
+    uint32_t elapsed = now - _lastUpdate;
+    if (elapsed < POWER_STATS_PERIOD_MS) {
+        return;
+    }
+    uint32_t wakeups = _wakeups;
+    _wakeupRate = (wakeups - _lastWakeups) * 1000.0f / elapsed;
+    _lastWakeups = wakeups;
+    _lastUpdate = now;
+}
+
+uint16_t PowerManager::estimateCurrentMa(uint8_t scanDutyPct, bool backlightOn) {
+    // CPU current scales roughly linearly between the two clock points
+    uint32_t mhz = ESP.getCpuFreqMHz();
+    int32_t cpu = POWER_EST_CPU_80_MA +
+                  ((int32_t)mhz - 80) * (POWER_EST_CPU_240_MA - POWER_EST_CPU_80_MA) / 160;
+    if (_lightSleep) {
+        // Asleep between events; the clock is only up for the work itself
+        cpu = POWER_EST_LIGHT_SLEEP_MA +
+              (int32_t)(_wakeupRate * POWER_EST_WAKE_MS * (cpu - POWER_EST_LIGHT_SLEEP_MA) / 1000.0f);
+    }
+    uint32_t radio = POWER_EST_RADIO_RX_MA * scanDutyPct / 100;
+    uint32_t total = POWER_EST_BOARD_MA + cpu + radio + (backlightOn ? POWER_EST_BACKLIGHT_MA : 0);
+    return total > 0xFFFF ? 0xFFFF : (uint16_t)total;
+}
@@ -0,0 +1,76 @@
+/**
+ * BLEPTD - BLE Privacy Threat Detector
+ * Power Manager - CPU clock and light sleep while the screen is off
+ *
+ * When power save turns the backlight off, the CPU clock is allowed to drop
+ * to POWER_IDLE_CPU_MHZ (DFS), and automatic light sleep is requested if the
+ * build supports it (esp_pm with tickless idle). The pipeline tasks block
+ * between events, so the idle task can sleep in between. The wake sources
+ * are advertisement batches (the controller keeps scanning with a window
+ * shorter than the interval), UART RX and a short PENIRQ poll. Waking the
+ * screen restores the full clock.
+ *
+ * The current figure is a model (config.h POWER_EST_*), not a measurement.
+ */
+
+#ifndef POWER_MGR_H
+#define POWER_MGR_H
+
+#include <Arduino.h>
+#include "../config.h"
+
+class PowerManager {
+public:
+    PowerManager();
+
+    // Wake sources that can stay configured all the time
+    void init();
+
+    // Enter (screen off) or leave the low-power mode
+    void setIdle(bool idle);
+    void setLightSleepAllowed(bool allowed) { _lightSleepAllowed = allowed; }
+
+    // The Wi-Fi uplink is on; light sleep is held off meanwhile
+    void setWifiActive(bool active);
+
+    // Pipeline tasks call this each time they unblock
+    void countWakeup() { _wakeups++; }
+
+    // Refreshes the wakeup rate every POWER_STATS_PERIOD_MS
+    void update(uint32_t now);
+
+    // Estimated supply current for the current state
+    uint16_t estimateCurrentMa(uint8_t scanDutyPct, bool backlightOn);
+
+    // Status
+    bool isIdle() { return _idle; }
+    bool isLightSleepAllowed() { return _lightSleepAllowed; }
+    bool isLightSleepActive() { return _lightSleep; }
+    bool isDfsSupported() { return _dfs; }
+    float getWakeupRate() { return _wakeupRate; }
+    uint32_t getWakeupCount() { return _wakeups; }
+    uint32_t getIdleTransitions() { return _transitions; }
+    const char* getLightSleepNote() { return _note; }
+
+private:
+    bool _idle;
+    bool _lightSleepAllowed;            // powersave_light_sleep in /config.txt
+    bool _wifiActive;
+    bool _lightSleep;                   // Accepted by esp_pm in the current mode
+    bool _dfs;                          // esp_pm available in this build
+    const char* _note;                  // Why light sleep is off, if it is
+    uint32_t _transitions;
+
+    volatile uint32_t _wakeups;         // Approximate: producers don't lock
+    uint32_t _lastWakeups;
+    uint32_t _lastUpdate;
+    float _wakeupRate;
+
+    bool configure(int maxMhz, int minMhz, bool lightSleep);
+    void applyIdle();
+};
+
+// Global power manager instance
+extern PowerManager powerMgr;
+
+#endif // POWER_MGR_H
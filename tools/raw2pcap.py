@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+"""
+BLEPTD - BLE Privacy Threat Detector
+raw2pcap - convert a STREAM RAW capture into a BLE link-layer pcap
+
+Reads the COBS framed binary output of the firmware (see SPECIFICATION.md
+section 5.2.3) from a serial port or a capture file and writes every
+BIN_FRAME_RAW_ADV record as a LINKTYPE_BLUETOOTH_LE_LL (251) packet.
+Text lines and frames that fail the CRC are skipped.
+
+    # Live, from the board (needs pyserial); send "STREAM RAW" first
+    tools/raw2pcap.py --port /dev/ttyUSB0 --baud 921600 -o capture.pcap
+
+    # Offline, from a raw dump of the serial port
+    tools/raw2pcap.py -i dump.bin -o capture.pcap
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+FRAME_RAW_ADV = 0x03
+LINKTYPE_BLUETOOTH_LE_LL = 251
+ADV_ACCESS_ADDRESS = 0x8E89BED6
+
+# esp_ble_evt_type_t -> advertising PDU type
+EVT_TO_PDU = {
+    0: 0x0,  # ESP_BLE_EVT_CONN_ADV     -> ADV_IND
+    1: 0x1,  # ESP_BLE_EVT_CONN_DIR_ADV -> ADV_DIRECT_IND
+    2: 0x6,  # ESP_BLE_EVT_DISC_ADV     -> ADV_SCAN_IND
+    3: 0x2,  # ESP_BLE_EVT_NON_CONN_ADV -> ADV_NONCONN_IND
+    4: 0x4,  # ESP_BLE_EVT_SCAN_RSP     -> SCAN_RSP
+}
+PDU_SCAN_RSP = 0x4
+
+RAW_HEADER = struct.Struct("<I6sBBbBB")
+
+
+def crc16_ccitt(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data) + 1:
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def ble_crc24(pdu):
+    # LSB-first LFSR, advertising channel init 0x555555
+    crc = 0x555555
+    for b in pdu:
+        for bit in range(8):
+            feedback = ((crc >> 23) ^ (b >> bit)) & 1
+            crc = (crc << 1) & 0xFFFFFF
+            if feedback:
+                crc ^= 0x00065B
+    # Transmitted most significant bit first
+    out = 0
+    for bit in range(24):
+        if crc & (1 << bit):
+            out |= 1 << (23 - bit)
+    return out.to_bytes(3, "little")
+
+
+def ll_packet(pdu_type, tx_add, adv_addr, data):
+    header = bytes([pdu_type | (tx_add << 6), 6 + len(data)])
+    pdu = header + adv_addr + data
+    return struct.pack("<I", ADV_ACCESS_ADDRESS) + pdu + ble_crc24(pdu)
+
+
+def frames(stream):
+    """Yield decoded, CRC checked (type, body) tuples."""
+    buf = bytearray()
+    while True:
+        chunk = stream.read(4096)
+        if not chunk:
+            return
+        buf += chunk
+        while True:
+            end = buf.find(b"\x00")
+            if end < 0:
+                break
+            raw = bytes(buf[:end])
+            del buf[:end + 1]
+            if not raw:
+                continue
+            frame = cobs_decode(raw)
+            if frame is None or len(frame) < 4:
+                continue
+            body, crc = frame[:-2], struct.unpack("<H", frame[-2:])[0]
+            if crc16_ccitt(body) != crc:
+                continue
+            yield body[0], body[2:]
+
+
+class PcapWriter:
+    def __init__(self, out):
+        self.out = out
+        out.write(struct.pack("<IHHiIII", 0xA1B2C3D4, 2, 4, 0, 0, 65535,
+                              LINKTYPE_BLUETOOTH_LE_LL))
+
+    def write(self, ts, packet):
+        sec, usec = int(ts), int((ts % 1) * 1e6)
+        self.out.write(struct.pack("<IIII", sec, usec, len(packet), len(packet)))
+        self.out.write(packet)
+        self.out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    src = parser.add_mutually_exclusive_group(required=True)
+    src.add_argument("-i", "--input", help="binary capture file")
+    src.add_argument("--port", help="serial port (requires pyserial)")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("-o", "--output", required=True, help="pcap file to write")
+    args = parser.parse_args()
+
+    if args.port:
+        import serial
+        stream = serial.Serial(args.port, args.baud, timeout=1)
+    else:
+        stream = open(args.input, "rb")
+
+    # Device timestamps are millis() since boot; anchor them to wall time
+    # at the first record so the capture lines up with other traces
+    base = None
+    count = 0
+    with open(args.output, "wb") as out:
+        pcap = PcapWriter(out)
+        try:
+            for ftype, rec in frames(stream):
+                if ftype != FRAME_RAW_ADV or len(rec) < RAW_HEADER.size:
+                    continue
+                ts, mac, addr_type, evt_type, rssi, adv_len, payload_len = \
+                    RAW_HEADER.unpack_from(rec)
+                payload = rec[RAW_HEADER.size:RAW_HEADER.size + payload_len]
+                if base is None:
+                    base = time.time() - ts / 1000.0
+                when = base + ts / 1000.0
+
+                # Over the air the address is least significant byte first
+                adv_addr = mac[::-1]
+                tx_add = 1 if addr_type & 1 else 0
+                pdu_type = EVT_TO_PDU.get(evt_type, 0x2)
+                # A scan response record repeats the adv data ahead of the
+                # response; that advertisement has its own record already
+                if pdu_type != PDU_SCAN_RSP:
+                    pcap.write(when, ll_packet(pdu_type, tx_add, adv_addr, payload[:adv_len]))
+                if payload_len > adv_len:
+                    pcap.write(when, ll_packet(PDU_SCAN_RSP, tx_add, adv_addr,
+                                               payload[adv_len:]))
+                count += 1
+        except KeyboardInterrupt:
+            pass
+
+    print(f"{count} advertisements written to {args.output}", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()